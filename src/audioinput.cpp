@@ -0,0 +1,315 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+#include "audioinput.h"
+
+#include <QtEndian>
+
+#if defined(QtMultimedia_FOUND)
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QAudioSource>
+#include <QMediaDevices>
+#endif
+
+#include <cmath>
+
+// How much audio is read at a time from files, in milliseconds
+static constexpr int FILE_CHUNK = 10;
+// Audio queued by the microphone before the device starts dropping it, in microseconds
+static constexpr qint64 CAPTURE_BUFFER = 100000;
+
+AudioWorker::AudioWorker(AudioProcessor *processor)
+    : QObject()
+    , stopping(false)
+    , m_processor(processor)
+    , m_source(nullptr)
+    , m_fileEnd(0)
+    , m_framesRead(0)
+    , m_inputRate(AudioInput::SampleRate)
+    , m_channels(1)
+    , m_type(Int16)
+    , m_frameBytes(2)
+    , m_phase(0)
+    , m_previous(0)
+{
+    m_fileTimer.setInterval(FILE_CHUNK);
+    connect(&m_fileTimer, &QTimer::timeout, this, [this]() {
+        const qint64 due = m_clock.elapsed() * m_inputRate / 1000 - m_framesRead;
+        if (due > 0 && !readFileChunk(due)) {
+            m_fileTimer.stop();
+            Q_EMIT finished();
+        }
+    });
+}
+
+void AudioWorker::captureMicrophone()
+{
+#if defined(QtMultimedia_FOUND)
+    const QAudioDevice device = QMediaDevices::defaultAudioInput();
+    if (device.isNull()) {
+        Q_EMIT error(tr("No microphone was found"));
+        return;
+    }
+    QAudioFormat format;
+    format.setSampleRate(AudioInput::SampleRate);
+    format.setChannelCount(1);
+    format.setSampleFormat(QAudioFormat::Int16);
+    if (!device.isFormatSupported(format))
+        format = device.preferredFormat();
+    switch (format.sampleFormat()) {
+    case QAudioFormat::UInt8:
+        setInputFormat(format.sampleRate(), format.channelCount(), UInt8);
+        break;
+    case QAudioFormat::Int16:
+        setInputFormat(format.sampleRate(), format.channelCount(), Int16);
+        break;
+    case QAudioFormat::Int32:
+        setInputFormat(format.sampleRate(), format.channelCount(), Int32);
+        break;
+    case QAudioFormat::Float:
+        setInputFormat(format.sampleRate(), format.channelCount(), Float);
+        break;
+    default:
+        Q_EMIT error(tr("The microphone's audio format isn't supported"));
+        return;
+    }
+
+    m_source = new QAudioSource(device, format, this);
+    m_source->setBufferSize(format.bytesForDuration(CAPTURE_BUFFER));
+    m_device = m_source->start();
+    if (!m_device) {
+        Q_EMIT error(tr("Cannot capture audio from the microphone"));
+        return;
+    }
+    connect(m_device, &QIODevice::readyRead, this, &AudioWorker::readMicrophone);
+#else
+    Q_EMIT error(tr("This build can't capture audio"));
+#endif
+}
+
+void AudioWorker::readMicrophone()
+{
+    const QByteArray data = m_device->readAll();
+    convert(data.constData(), data.size());
+}
+
+void AudioWorker::readFile(const QString &filePath, bool realtime)
+{
+    m_file.setFileName(filePath);
+    if (!m_file.open(QFile::ReadOnly) || m_file.read(4) != "RIFF") {
+        Q_EMIT error(tr("Cannot read audio from ") + filePath);
+        Q_EMIT finished();
+        return;
+    }
+    m_file.skip(4);
+    if (m_file.read(4) != "WAVE") {
+        Q_EMIT error(tr("Not a WAV file: ") + filePath);
+        Q_EMIT finished();
+        return;
+    }
+
+    // Walk the chunks up to the samples, taking the format along the way.
+    bool formatFound = false;
+    m_fileEnd = 0;
+    while (!m_file.atEnd()) {
+        const QByteArray id = m_file.read(4);
+        quint32 size = 0;
+        if (m_file.read(reinterpret_cast<char *>(&size), sizeof(size)) != sizeof(size))
+            break;
+        size = qFromLittleEndian(size);
+        if (id == "fmt ") {
+            const QByteArray format = m_file.read(size);
+            if (format.size() < 16)
+                break;
+            const uchar *fields = reinterpret_cast<const uchar *>(format.constData());
+            quint16 encoding = qFromLittleEndian<quint16>(fields);
+            const int channels = qFromLittleEndian<quint16>(fields + 2);
+            const int sampleRate = qFromLittleEndian<quint32>(fields + 4);
+            const int bits = qFromLittleEndian<quint16>(fields + 14);
+            // WAVE_FORMAT_EXTENSIBLE keeps the actual encoding at the start of its sub format.
+            if (encoding == 0xFFFE && format.size() >= 26)
+                encoding = qFromLittleEndian<quint16>(fields + 24);
+            if (encoding == 1 && bits == 8)
+                setInputFormat(sampleRate, channels, UInt8);
+            else if (encoding == 1 && bits == 16)
+                setInputFormat(sampleRate, channels, Int16);
+            else if (encoding == 1 && bits == 32)
+                setInputFormat(sampleRate, channels, Int32);
+            else if (encoding == 3 && bits == 32)
+                setInputFormat(sampleRate, channels, Float);
+            else
+                break;
+            formatFound = sampleRate > 0 && channels > 0;
+            if (size & 1)
+                m_file.skip(1);
+        }
+        else if (id == "data") {
+            m_fileEnd = m_file.pos() + size;
+            break;
+        }
+        else
+            m_file.skip(size + (size & 1));
+    }
+    if (!formatFound || !m_fileEnd) {
+        Q_EMIT error(tr("Unsupported WAV file: ") + filePath);
+        Q_EMIT finished();
+        return;
+    }
+
+    m_framesRead = 0;
+    if (realtime) {
+        m_clock.start();
+        m_fileTimer.start();
+        return;
+    }
+    const qint64 chunk = qint64(m_inputRate) * FILE_CHUNK / 1000;
+    while (!stopping.load(std::memory_order_relaxed) && readFileChunk(chunk)) { }
+    Q_EMIT finished();
+}
+
+bool AudioWorker::readFileChunk(qint64 frames)
+{
+    const qint64 bytes = qMin(frames * m_frameBytes, m_fileEnd - m_file.pos());
+    if (bytes < m_frameBytes)
+        return false;
+    const QByteArray data = m_file.read(bytes - bytes % m_frameBytes);
+    if (data.isEmpty())
+        return false;
+    m_framesRead += data.size() / m_frameBytes;
+    convert(data.constData(), data.size());
+    return true;
+}
+
+void AudioWorker::setInputFormat(int sampleRate, int channels, SampleType type)
+{
+    static constexpr int sampleBytes[] = {1, 2, 4, 4};
+    m_inputRate = sampleRate;
+    m_channels = channels;
+    m_type = type;
+    m_frameBytes = channels * sampleBytes[type];
+    m_phase = 0;
+    m_previous = 0;
+}
+
+void AudioWorker::convert(const char *data, qsizetype bytes)
+{
+    // Mix down to mono floats
+    const qsizetype frames = bytes / m_frameBytes;
+    if (!frames)
+        return;
+    m_mono.resize(frames);
+    for (qsizetype frame = 0; frame < frames; frame++) {
+        const char *samples = data + frame * m_frameBytes;
+        float sum = 0;
+        for (int channel = 0; channel < m_channels; channel++) {
+            switch (m_type) {
+            case UInt8:
+                sum += (reinterpret_cast<const quint8 *>(samples)[channel] - 128) / 128.f;
+                break;
+            case Int16:
+                sum += qFromLittleEndian<qint16>(samples + channel * 2) / 32768.f;
+                break;
+            case Int32:
+                sum += qFromLittleEndian<qint32>(samples + channel * 4) / 2147483648.f;
+                break;
+            case Float:
+                sum += qFromLittleEndian<float>(samples + channel * 4);
+                break;
+            }
+        }
+        m_mono[frame] = sum / m_channels;
+    }
+
+    // Resample through linear interpolation
+    const double step = double(m_inputRate) / AudioInput::SampleRate;
+    m_output.resize(0);
+    while (m_phase < frames - 1) {
+        const qsizetype index = qsizetype(std::floor(m_phase));
+        const float fraction = m_phase - index;
+        const float from = index < 0 ? m_previous : m_mono.at(index);
+        const float to = m_mono.at(index + 1);
+        const float sample = from + (to - from) * fraction;
+        m_output.append(qint16(qBound(-32768L, std::lround(sample * 32767), 32767L)));
+        m_phase += step;
+    }
+    m_phase -= frames;
+    m_previous = m_mono.at(frames - 1);
+
+    if (!m_output.isEmpty())
+        m_processor->process(m_output.constData(), m_output.size());
+}
+
+AudioInput::AudioInput(AudioProcessor *processor, QObject *parent)
+    : QObject(parent)
+    , m_processor(processor)
+    , m_worker(nullptr)
+{
+    m_thread.setObjectName(QStringLiteral("Audio"));
+}
+
+AudioInput::~AudioInput()
+{
+    stop();
+}
+
+bool AudioInput::running() const
+{
+    return m_worker;
+}
+
+void AudioInput::start(const QString &filePath, bool realtime)
+{
+    if (m_worker)
+        return;
+
+    m_worker = new AudioWorker(m_processor);
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &AudioWorker::error, this, &AudioInput::error);
+    connect(m_worker, &AudioWorker::finished, this, &AudioInput::finished);
+    m_thread.start(QThread::TimeCriticalPriority);
+    if (filePath.isEmpty())
+        QMetaObject::invokeMethod(m_worker, &AudioWorker::captureMicrophone, Qt::QueuedConnection);
+    else
+        QMetaObject::invokeMethod(m_worker, "readFile", Qt::QueuedConnection, Q_ARG(QString, filePath), Q_ARG(bool, realtime));
+}
+
+void AudioInput::stop()
+{
+    if (!m_worker)
+        return;
+
+    m_worker->stopping.store(true, std::memory_order_relaxed);
+    m_thread.quit();
+    m_thread.wait();
+    m_worker = nullptr;
+}
+
+bool AudioInput::canCapture()
+{
+#if defined(QtMultimedia_FOUND)
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,126 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef AUDIOINPUT_H
+#define AUDIOINPUT_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+
+#include <atomic>
+
+class QAudioSource;
+class QIODevice;
+
+// Consumes audio on the audio thread.
+class AudioProcessor
+{
+public:
+    virtual ~AudioProcessor() = default;
+    // Receives mono 16 bit samples at AudioInput::SampleRate. Blocking here makes the device drop audio rather than
+    // queue it, which keeps latency bounded.
+    virtual void process(const qint16 *samples, qsizetype count) = 0;
+};
+
+// Reads audio on the audio thread and converts it to what processors take.
+class AudioWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AudioWorker(AudioProcessor *processor);
+
+    std::atomic<bool> stopping;
+
+public Q_SLOTS:
+    void captureMicrophone();
+    void readFile(const QString &filePath, bool realtime);
+
+Q_SIGNALS:
+    void error(const QString &message);
+    void finished();
+
+private:
+    enum SampleType { UInt8, Int16, Int32, Float };
+
+    void readMicrophone();
+    bool readFileChunk(qint64 frames);
+    void setInputFormat(int sampleRate, int channels, SampleType type);
+    void convert(const char *data, qsizetype bytes);
+
+    AudioProcessor *m_processor;
+    QAudioSource *m_source;
+    QPointer<QIODevice> m_device;
+    QFile m_file;
+    qint64 m_fileEnd;
+    QTimer m_fileTimer;
+    QElapsedTimer m_clock;
+    qint64 m_framesRead;
+
+    int m_inputRate;
+    int m_channels;
+    SampleType m_type;
+    int m_frameBytes;
+    // Linear resampling state: the next output's position in input frames, relative to the frame before the current
+    // block, which is kept in m_previous.
+    double m_phase;
+    float m_previous;
+    QList<float> m_mono;
+    QList<qint16> m_output;
+};
+
+// Runs a processor on a dedicated thread over microphone audio, or over a WAV file for tests and benchmarks.
+class AudioInput : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int SampleRate = 16000;
+
+    explicit AudioInput(AudioProcessor *processor, QObject *parent = nullptr);
+    ~AudioInput();
+
+    bool running() const;
+    // Reads the default microphone when filePath is empty. Files are read at their own pace when realtime is set, and
+    // as fast as the processor allows otherwise.
+    void start(const QString &filePath = QString(), bool realtime = true);
+    void stop();
+
+    // Whether this build can capture from microphones
+    static bool canCapture();
+
+Q_SIGNALS:
+    void error(const QString &message);
+    void finished();
+
+private:
+    AudioProcessor *m_processor;
+    QThread m_thread;
+    AudioWorker *m_worker;
+};
+
+#endif // AUDIOINPUT_H
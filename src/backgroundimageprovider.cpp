@@ -0,0 +1,106 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+#include "backgroundimageprovider.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QMutex>
+#include <QStandardPaths>
+#include <QUrl>
+
+// Decoded backgrounds kept on disk. Every image and size gets its own file, so the oldest are evicted past this count.
+static constexpr int MAX_CACHED_BACKGROUNDS = 16;
+
+// Images may be requested from several loader threads. Writes and evictions happen one at a time.
+static QMutex cacheMutex;
+
+BackgroundImageProvider::BackgroundImageProvider()
+    : QQuickImageProvider(QQuickImageProvider::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading)
+{
+}
+
+QImage BackgroundImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    const QString filePath = QUrl(QUrl::fromPercentEncoding(id.toUtf8())).toLocalFile();
+    const QFileInfo fileInfo(filePath);
+    if (!fileInfo.isFile())
+        return QImage();
+
+    const QString cachePath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/backgrounds");
+    const QByteArray key = QCryptographicHash::hash(QStringLiteral("%1/%2/%3x%4")
+                                                        .arg(fileInfo.absoluteFilePath())
+                                                        .arg(fileInfo.lastModified().toMSecsSinceEpoch())
+                                                        .arg(requestedSize.width())
+                                                        .arg(requestedSize.height())
+                                                        .toUtf8(),
+                                                    QCryptographicHash::Sha1);
+    const QString cacheFile = cachePath + QLatin1Char('/') + QString::fromLatin1(key.toHex());
+
+    QImage image;
+    if (image.load(cacheFile)) {
+        if (size)
+            *size = image.size();
+        return image;
+    }
+
+    QImageReader reader(filePath);
+    reader.setAutoTransform(true);
+    QSize sourceSize = reader.size();
+    if (reader.transformation() & QImageIOHandler::TransformationRotate90)
+        sourceSize.transpose();
+    // Scale so the image covers the requested size, as PreserveAspectCrop shows it. Decoders like JPEG's skip detail
+    // that isn't needed at the scaled size, which is most of the decoding time for large photographs.
+    if (sourceSize.isValid() && requestedSize.width() > 0 && requestedSize.height() > 0) {
+        const qreal scale = qMax(qreal(requestedSize.width()) / sourceSize.width(), qreal(requestedSize.height()) / sourceSize.height());
+        if (scale < 1) {
+            QSize scaledSize = (QSizeF(sourceSize) * scale).toSize();
+            if (reader.transformation() & QImageIOHandler::TransformationRotate90)
+                scaledSize.transpose();
+            reader.setScaledSize(scaledSize);
+        }
+    }
+    if (!reader.read(&image)) {
+        qWarning() << "Failed to load background image" << filePath << reader.errorString();
+        return QImage();
+    }
+
+    // Opaque images are cached as JPEG, which loads faster than PNG at screen sizes.
+    QMutexLocker locker(&cacheMutex);
+    QDir cacheDir(cachePath);
+    cacheDir.mkpath(QStringLiteral("."));
+    QImageWriter writer(cacheFile, image.hasAlphaChannel() ? "png" : "jpg");
+    writer.setQuality(92);
+    writer.write(image);
+    const QStringList cached = cacheDir.entryList(QDir::Files, QDir::Time);
+    for (qsizetype i = MAX_CACHED_BACKGROUNDS; i < cached.size(); ++i)
+        cacheDir.remove(cached.at(i));
+
+    if (size)
+        *size = image.size();
+    return image;
+}
@@ -0,0 +1,39 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef BACKGROUNDIMAGEPROVIDER_H
+#define BACKGROUNDIMAGEPROVIDER_H
+
+#include <QQuickImageProvider>
+
+// Serves prompter background images, decoded on the image reader thread at no more than the requested size. Requests
+// are made as image://background/<encoded file URL>, with the largest screen's size as sourceSize. Images are scaled to
+// cover that size, and the results are kept in the cache location, keyed by path, modification time and size, so
+// large photographs are only decoded once.
+class BackgroundImageProvider : public QQuickImageProvider
+{
+public:
+    BackgroundImageProvider();
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+};
+
+#endif // BACKGROUNDIMAGEPROVIDER_H
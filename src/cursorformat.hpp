@@ -0,0 +1,74 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef CURSORFORMAT_H
+#define CURSORFORMAT_H
+
+#include <QColor>
+#include <QObject>
+#include <QString>
+
+// Snapshot of the formatting found at the editor's cursor or selection.
+// It is taken on the first read after a cursor, selection or formatting change, so that toolbar bindings don't each have to query the document.
+struct CursorFormat {
+    Q_GADGET
+    Q_PROPERTY(QString fontFamily MEMBER fontFamily)
+    Q_PROPERTY(QColor textColor MEMBER textColor)
+    Q_PROPERTY(QColor textBackground MEMBER textBackground)
+    Q_PROPERTY(Qt::Alignment alignment MEMBER alignment)
+    Q_PROPERTY(bool bold MEMBER bold)
+    Q_PROPERTY(bool italic MEMBER italic)
+    Q_PROPERTY(bool underline MEMBER underline)
+    Q_PROPERTY(bool strike MEMBER strike)
+    Q_PROPERTY(bool subscript MEMBER subscript)
+    Q_PROPERTY(bool superscript MEMBER superscript)
+    Q_PROPERTY(bool regularMarker MEMBER regularMarker)
+    Q_PROPERTY(bool namedMarker MEMBER namedMarker)
+    Q_PROPERTY(int fontSize MEMBER fontSize)
+public:
+    bool operator==(const CursorFormat &other) const
+    {
+        return fontFamily == other.fontFamily && textColor == other.textColor && textBackground == other.textBackground && alignment == other.alignment
+            && bold == other.bold && italic == other.italic && underline == other.underline && strike == other.strike && subscript == other.subscript
+            && superscript == other.superscript && regularMarker == other.regularMarker && namedMarker == other.namedMarker && fontSize == other.fontSize;
+    }
+    bool operator!=(const CursorFormat &other) const
+    {
+        return !(*this == other);
+    }
+    // Contents, defaults match those of a document that isn't loaded
+    QString fontFamily;
+    QColor textColor = QColor(Qt::white);
+    QColor textBackground = QColor(Qt::transparent);
+    Qt::Alignment alignment = Qt::AlignCenter;
+    bool bold = false;
+    bool italic = false;
+    bool underline = false;
+    bool strike = false;
+    bool subscript = false;
+    bool superscript = false;
+    bool regularMarker = false;
+    bool namedMarker = false;
+    int fontSize = 0;
+};
+Q_DECLARE_METATYPE(CursorFormat);
+
+#endif // CURSORFORMAT_H
@@ -71,6 +71,7 @@
 
 #include "documenthandler.h"
 
+#include <algorithm>
 #include <vector>
 #if defined(Q_OS_ANDROID)
 #include <QAndroidJniObject>
@@ -85,6 +86,7 @@
 #include <QFileInfo>
 #include <QFileSelector>
 #include <QFileSystemWatcher>
+#include <QFutureWatcher>
 #include <QMimeDatabase>
 #include <QQmlFile>
 #include <QQmlFileSelector>
@@ -96,17 +98,30 @@
 #else
 #include <QTextCodec>
 #endif
+#include <QAbstractTextDocumentLayout>
+#include <QBuffer>
 #include <QClipboard>
+#include <QCryptographicHash>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QKeySequence>
 #include <QMimeData>
 #include <QNetworkReply>
 #include <QProcess>
+#include <QQmlComponent>
+#include <QQmlEngine>
 #include <QRegularExpression>
+#include <QScreen>
+#include <QSet>
 #include <QTemporaryFile>
 #include <QTextBlock>
 #include <QTextDocument>
+#include <QTextImageFormat>
+#include <QTextStream>
 #include <QTimer>
+#include <QtConcurrent>
+
+#include <memory>
 
 DocumentHandler::DocumentHandler(QObject *parent)
     : QObject(parent)
@@ -115,8 +130,23 @@ DocumentHandler::DocumentHandler(QObject *parent)
     , m_cursorPosition(-1)
     , m_selectionStart(0)
     , m_selectionEnd(0)
+    , m_formatDirty(true)
+    , m_formatUpdateQueued(false)
     , _markersModel(nullptr)
-
+    , m_lineHeight(100)
+    , m_paragraphHeight(0)
+    , m_appliedLineHeight(100)
+    , m_appliedParagraphHeight(0)
+    , m_typographyApplied(false)
+    , m_undoState(0)
+    , m_redoState(0)
+    , m_undoCommandAdded(false)
+    , m_undoCompactionQueued(false)
+    , m_undoMemoryUsage(0)
+    , m_undoMemoryBudget(64 * 1024 * 1024)
+    , m_pendingPastes(0)
+    , m_contentsGeneration(0)
+    , m_wordGeometryDirty(true)
 {
     _markersModel = new MarkersModel();
     _fileSystemWatcher = new QFileSystemWatcher();
@@ -127,6 +157,12 @@ DocumentHandler::DocumentHandler(QObject *parent)
     m_cache = new QTemporaryFile(this);
     connect(m_fontDialog, &SystemFontChooserDialog::fontFamilyChanged, this, &DocumentHandler::setFontFamily);
     connect(m_network, &QNetworkAccessManager::finished, this, &DocumentHandler::loadFromNetworkFinihed);
+
+    // Typography sliders emit a value per tick. Only the value they settle on gets laid out.
+    m_typographyTimer = new QTimer(this);
+    m_typographyTimer->setSingleShot(true);
+    m_typographyTimer->setInterval(120);
+    connect(m_typographyTimer, &QTimer::timeout, this, &DocumentHandler::applyTypography);
 }
 
 DocumentHandler::~DocumentHandler()
@@ -152,8 +188,10 @@ void DocumentHandler::setDocument(QQuickTextDocument *document)
     if (document == m_document)
         return;
 
-    if (m_document)
+    if (m_document) {
         m_document->textDocument()->disconnect(this);
+        m_document->textDocument()->documentLayout()->disconnect(this);
+    }
     m_document = document;
     if (m_document) {
         m_document->textDocument()->setDefaultStyleSheet(QString::fromUtf8(
@@ -164,7 +202,23 @@ void DocumentHandler::setDocument(QQuickTextDocument *document)
             "background-color:rgba(0,0,0,0.0);}img{margin:5pt;width:50vw;}p{margin:0;}h1,h2,h3,h4,h5,h6{font-size:medium;font-weight:normal;}"));
         connect(m_document->textDocument(), &QTextDocument::modificationChanged, this, &DocumentHandler::modifiedChanged);
         connect(m_document->textDocument(), &QTextDocument::contentsChanged, this, &DocumentHandler::setMarkersListDirty);
+        // Edits may reformat the text at the cursor without moving it
+        connect(m_document->textDocument(), &QTextDocument::contentsChanged, this, [this]() {
+            m_formatDirty = true;
+        });
+        connect(m_document->textDocument(), &QTextDocument::contentsChange, this, &DocumentHandler::measureUndoChange);
+        connect(m_document->textDocument(), &QTextDocument::undoCommandAdded, this, &DocumentHandler::accountUndoCommand);
+        // Any relayout moves words. Geometry is gathered again on the next lookup.
+        connect(m_document->textDocument()->documentLayout(), &QAbstractTextDocumentLayout::update, this, [this]() {
+            m_wordGeometryDirty = true;
+        });
     }
+    m_wordGeometryDirty = true;
+    scheduleFormatUpdate();
+    // Pastes still being processed were meant for the previous document
+    m_contentsGeneration++;
+    m_imageResources.clear();
+    resetUndoHistory();
     Q_EMIT documentChanged();
 }
 
@@ -179,7 +233,7 @@ void DocumentHandler::setCursorPosition(int position)
         return;
 
     m_cursorPosition = position;
-    reset();
+    scheduleFormatUpdate();
     Q_EMIT cursorPositionChanged();
 }
 
@@ -194,6 +248,7 @@ void DocumentHandler::setSelectionStart(int position)
         return;
 
     m_selectionStart = position;
+    scheduleFormatUpdate();
     Q_EMIT selectionStartChanged();
 }
 
@@ -208,17 +263,18 @@ void DocumentHandler::setSelectionEnd(int position)
         return;
 
     m_selectionEnd = position;
+    scheduleFormatUpdate();
     Q_EMIT selectionEndChanged();
 }
 
+CursorFormat DocumentHandler::format() const
+{
+    return cursorFormat();
+}
+
 QString DocumentHandler::fontFamily() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return QString();
-    QTextCharFormat format = cursor.charFormat();
-    const QFont font = format.font();
-    return font.families().length() ? font.families().constFirst() : font.family();
+    return cursorFormat().fontFamily;
 }
 
 void DocumentHandler::setFontFamily(const QString &family)
@@ -226,16 +282,12 @@ void DocumentHandler::setFontFamily(const QString &family)
     QTextCharFormat format;
     format.setFontFamilies(QStringList(family));
     mergeFormatOnWordOrSelection(format);
-    Q_EMIT fontFamilyChanged(family);
+    updateFormat();
 }
 
 QColor DocumentHandler::textColor() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return QColor(Qt::white);
-    QTextCharFormat format = cursor.charFormat();
-    return format.foreground().color();
+    return cursorFormat().textColor;
 }
 
 void DocumentHandler::setTextColor(const QColor &color)
@@ -243,16 +295,12 @@ void DocumentHandler::setTextColor(const QColor &color)
     QTextCharFormat format;
     format.setForeground(QBrush(color));
     mergeFormatOnWordOrSelection(format);
-    Q_EMIT textColorChanged();
+    updateFormat();
 }
 
 QColor DocumentHandler::textBackground() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return QColor(Qt::transparent);
-    QTextCharFormat format = cursor.charFormat();
-    return format.background().color();
+    return cursorFormat().textBackground;
 }
 
 void DocumentHandler::setTextBackground(const QColor &color)
@@ -260,15 +308,12 @@ void DocumentHandler::setTextBackground(const QColor &color)
     QTextCharFormat format;
     format.setBackground(QBrush(color));
     mergeFormatOnWordOrSelection(format);
-    Q_EMIT textBackgroundChanged();
+    updateFormat();
 }
 
 Qt::Alignment DocumentHandler::alignment() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return Qt::AlignCenter;
-    return textCursor().blockFormat().alignment();
+    return cursorFormat().alignment;
 }
 
 void DocumentHandler::setAlignment(Qt::Alignment alignment)
@@ -277,15 +322,12 @@ void DocumentHandler::setAlignment(Qt::Alignment alignment)
     format.setAlignment(alignment);
     QTextCursor cursor = textCursor();
     cursor.mergeBlockFormat(format);
-    Q_EMIT alignmentChanged();
+    updateFormat();
 }
 
 bool DocumentHandler::bold() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return false;
-    return textCursor().charFormat().fontWeight() == QFont::Bold;
+    return cursorFormat().bold;
 }
 
 void DocumentHandler::setBold(bool bold)
@@ -293,15 +335,12 @@ void DocumentHandler::setBold(bool bold)
     QTextCharFormat format;
     format.setFontWeight(bold ? QFont::Bold : QFont::Normal);
     mergeFormatOnWordOrSelection(format);
-    Q_EMIT boldChanged();
+    updateFormat();
 }
 
 bool DocumentHandler::italic() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return false;
-    return textCursor().charFormat().fontItalic();
+    return cursorFormat().italic;
 }
 
 void DocumentHandler::setItalic(bool italic)
@@ -309,15 +348,12 @@ void DocumentHandler::setItalic(bool italic)
     QTextCharFormat format;
     format.setFontItalic(italic);
     mergeFormatOnWordOrSelection(format);
-    Q_EMIT italicChanged();
+    updateFormat();
 }
 
 bool DocumentHandler::underline() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return false;
-    return textCursor().charFormat().fontUnderline();
+    return cursorFormat().underline;
 }
 
 void DocumentHandler::setUnderline(bool underline)
@@ -325,15 +361,12 @@ void DocumentHandler::setUnderline(bool underline)
     QTextCharFormat format;
     format.setFontUnderline(underline);
     mergeFormatOnWordOrSelection(format);
-    Q_EMIT underlineChanged();
+    updateFormat();
 }
 
 bool DocumentHandler::strike() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return false;
-    return textCursor().charFormat().fontStrikeOut();
+    return cursorFormat().strike;
 }
 
 void DocumentHandler::setStrike(bool strike)
@@ -341,15 +374,12 @@ void DocumentHandler::setStrike(bool strike)
     QTextCharFormat format;
     format.setFontStrikeOut(strike);
     mergeFormatOnWordOrSelection(format);
-    Q_EMIT strikeChanged();
+    updateFormat();
 }
 
 bool DocumentHandler::subscript() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return false;
-    return textCursor().charFormat().verticalAlignment() == QTextCharFormat::AlignSubScript;
+    return cursorFormat().subscript;
 }
 
 void DocumentHandler::setSubscript(bool subscript)
@@ -360,15 +390,12 @@ void DocumentHandler::setSubscript(bool subscript)
     else
         format.setVerticalAlignment(QTextCharFormat::AlignNormal);
     mergeFormatOnWordOrSelection(format);
-    Q_EMIT verticalAlignmentChanged();
+    updateFormat();
 }
 
 bool DocumentHandler::superscript() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return false;
-    return textCursor().charFormat().verticalAlignment() == QTextCharFormat::AlignSuperScript;
+    return cursorFormat().superscript;
 }
 
 void DocumentHandler::setSuperscript(bool superscript)
@@ -381,23 +408,17 @@ void DocumentHandler::setSuperscript(bool superscript)
         // format.setFontPointSize(12);
     }
     mergeFormatOnWordOrSelection(format);
-    Q_EMIT verticalAlignmentChanged();
+    updateFormat();
 }
 
 bool DocumentHandler::regularMarker() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return false;
-    return textCursor().charFormat().isAnchor() && textCursor().charFormat().anchorNames().size() == 0;
+    return cursorFormat().regularMarker;
 }
 
 bool DocumentHandler::namedMarker() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return false;
-    return textCursor().charFormat().isAnchor() && textCursor().charFormat().anchorNames().size() > 0;
+    return cursorFormat().namedMarker;
 }
 
 void DocumentHandler::setKeyMarker(QString keyCodeString = QString::fromUtf8(""))
@@ -414,7 +435,7 @@ void DocumentHandler::setKeyMarker(QString keyCodeString = QString::fromUtf8("")
     format.setFontOverline(true);
     mergeFormatOnWordOrSelection(format);
     this->setMarkersListDirty();
-    Q_EMIT markerChanged();
+    updateFormat();
 }
 
 bool DocumentHandler::showFontDialog()
@@ -469,16 +490,12 @@ void DocumentHandler::setMarker(bool marker)
         format.clearProperty(QTextFormat::AnchorHref);
     mergeFormatOnWordOrSelection(format);
     this->setMarkersListDirty();
-    Q_EMIT markerChanged();
+    updateFormat();
 }
 
 int DocumentHandler::fontSize() const
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
-        return 0;
-    QTextCharFormat format = cursor.charFormat();
-    return format.font().pointSize();
+    return cursorFormat().fontSize;
 }
 
 void DocumentHandler::setFontSize(int size)
@@ -499,7 +516,7 @@ void DocumentHandler::setFontSize(int size)
     QTextCharFormat format;
     format.setFontPointSize(size);
     mergeFormatOnWordOrSelection(format);
-    Q_EMIT fontSizeChanged();
+    updateFormat();
 }
 
 QString DocumentHandler::fileName() const
@@ -560,6 +577,8 @@ void DocumentHandler::loadFromNetworkFinihed()
             QString::fromUtf8("((font-size|letter-spacing|word-spacing|font-weight):\\s*-?[\\d]+(?:.[\\d]+)*(?:(?:px)|(?:pt)|(?:em)|(?:ex));?\\s*)"));
         QString html = QString::fromUtf8(document).replace(regex_0, QString::fromUtf8(""));
         updateContents(html, Qt::RichText);
+        // Loading isn't an edit, don't keep the previous document in the undo history.
+        resetUndoHistory();
 
         m_fileUrl = m_cache->fileName();
         Q_EMIT fileUrlChanged();
@@ -659,7 +678,7 @@ void DocumentHandler::load(const QUrl &fileUrl)
                 }
                 doc->setModified(false);
             }
-            reset();
+            updateFormat();
         }
         bool newPath = false;
         if (path != this->fileUrl())
@@ -674,7 +693,7 @@ void DocumentHandler::load(const QUrl &fileUrl)
     }
 
     m_fileUrl = fileUrl;
-    document()->textDocument()->clearUndoRedoStacks();
+    resetUndoHistory();
     Q_EMIT fileUrlChanged();
 }
 
@@ -738,6 +757,9 @@ QString DocumentHandler::import(const QString &fileName, ImportFormat type)
 }
 
 void DocumentHandler::updateContents(const QString &text, Qt::TextFormat format) {
+    // Pastes still being processed belong to the previous contents
+    m_contentsGeneration++;
+    m_imageResources.clear();
     QTextCursor cursor = textCursor();
     cursor.select(QTextCursor::Document);
     cursor.removeSelectedText();
@@ -753,16 +775,155 @@ void DocumentHandler::updateContents(const QString &text, Qt::TextFormat format)
         Q_FALLTHROUGH();
     case Qt::AutoText:
         cursor.insertHtml(text);
+        normalizeFormats();
         break;
     }
+    // Freshly loaded blocks carry whatever spacing their source had, so the next pass must reach all of them.
+    invalidateTypography();
     Q_EMIT loaded(format);
 }
 
+// Format normalization
+
+// Remove character properties that have no effect or that the prompter overrides, such as sizes and spacing, which are set for the whole document.
+static QTextCharFormat canonicalCharFormat(QTextCharFormat format, const QString &defaultFamily)
+{
+    static const int overriddenProperties[] = {QTextFormat::FontPointSize,
+                                               QTextFormat::FontPixelSize,
+                                               QTextFormat::FontSizeAdjustment,
+                                               QTextFormat::FontLetterSpacing,
+                                               QTextFormat::FontLetterSpacingType,
+                                               QTextFormat::FontWordSpacing,
+                                               QTextFormat::FontStretch,
+                                               QTextFormat::FontKerning,
+                                               QTextFormat::FontHintingPreference};
+    for (const int property : overriddenProperties)
+        format.clearProperty(property);
+
+    // Family names that match the editor's font or are generic are just noise from the source application
+    static const QStringList genericFamilies = {QString::fromUtf8("serif"),
+                                                QString::fromUtf8("sans-serif"),
+                                                QString::fromUtf8("monospace"),
+                                                QString::fromUtf8("cursive"),
+                                                QString::fromUtf8("fantasy"),
+                                                QString::fromUtf8("system-ui")};
+    const QStringList families = format.fontFamilies().toStringList();
+    if (format.hasProperty(QTextFormat::FontFamilies)
+        && (families.isEmpty() || families.constFirst() == defaultFamily || genericFamilies.contains(families.constFirst(), Qt::CaseInsensitive)))
+        format.clearProperty(QTextFormat::FontFamilies);
+    if (format.hasProperty(QTextFormat::FontFamily) && (format.fontFamily().isEmpty() || format.fontFamily() == defaultFamily))
+        format.clearProperty(QTextFormat::FontFamily);
+
+    // Properties explicitly set to their default value
+    if (format.hasProperty(QTextFormat::FontWeight) && format.fontWeight() == QFont::Normal)
+        format.clearProperty(QTextFormat::FontWeight);
+    if (format.hasProperty(QTextFormat::FontItalic) && !format.fontItalic())
+        format.clearProperty(QTextFormat::FontItalic);
+    if (format.hasProperty(QTextFormat::FontStrikeOut) && !format.fontStrikeOut())
+        format.clearProperty(QTextFormat::FontStrikeOut);
+    if (format.hasProperty(QTextFormat::TextVerticalAlignment) && format.verticalAlignment() == QTextCharFormat::AlignNormal)
+        format.clearProperty(QTextFormat::TextVerticalAlignment);
+    // Anchors use underline and overline to stand out, leave those alone
+    if (!format.isAnchor()) {
+        if (format.hasProperty(QTextFormat::FontUnderline) && !format.fontUnderline())
+            format.clearProperty(QTextFormat::FontUnderline);
+        if (format.hasProperty(QTextFormat::TextUnderlineStyle) && format.underlineStyle() == QTextCharFormat::NoUnderline)
+            format.clearProperty(QTextFormat::TextUnderlineStyle);
+        if (format.hasProperty(QTextFormat::FontOverline) && !format.fontOverline())
+            format.clearProperty(QTextFormat::FontOverline);
+    }
+    if (format.hasProperty(QTextFormat::BackgroundBrush)
+        && (format.background().style() == Qt::NoBrush || format.background().color().alpha() == 0))
+        format.clearProperty(QTextFormat::BackgroundBrush);
+    if (format.hasProperty(QTextFormat::ForegroundBrush) && format.foreground().style() == Qt::NoBrush)
+        format.clearProperty(QTextFormat::ForegroundBrush);
+    return format;
+}
+
+// Remove block properties that are set to a value without effect.
+static QTextBlockFormat canonicalBlockFormat(QTextBlockFormat format)
+{
+    static const int zeroEffectProperties[] = {QTextFormat::BlockTopMargin,
+                                               QTextFormat::BlockLeftMargin,
+                                               QTextFormat::BlockRightMargin,
+                                               QTextFormat::TextIndent,
+                                               QTextFormat::BlockIndent};
+    for (const int property : zeroEffectProperties)
+        if (format.hasProperty(property) && qFuzzyIsNull(format.doubleProperty(property)) && format.intProperty(property) == 0)
+            format.clearProperty(property);
+    if (format.hasProperty(QTextFormat::BackgroundBrush)
+        && (format.background().style() == Qt::NoBrush || format.background().color().alpha() == 0))
+        format.clearProperty(QTextFormat::BackgroundBrush);
+    return format;
+}
+
+// Canonicalize formats of imported and pasted documents, between from and to, or all of it if to is negative. HTML from word processors tends to carry
+// many near-identical formats, which inflate the number of fragments that layout and parse() go through. Once formats are canonical, the document merges
+// adjacent fragments that share the same format.
+void DocumentHandler::normalizeFormats(int from, int to)
+{
+    QTextDocument *doc = textDocument();
+    if (!doc)
+        return;
+    if (to < 0)
+        to = doc->characterCount();
+    const QStringList defaultFamilies = doc->defaultFont().families();
+    const QString defaultFamily = defaultFamilies.length() ? defaultFamilies.constFirst() : doc->defaultFont().family();
+
+    struct Change {
+        int position;
+        int length;
+        QTextCharFormat format;
+    };
+    QTextCursor cursor(doc);
+    cursor.beginEditBlock();
+    for (QTextBlock it = doc->findBlock(from); it.isValid() && it.position() <= to; it = it.next()) {
+        const QTextBlockFormat blockFormat = it.blockFormat();
+        const QTextBlockFormat canonicalBlock = canonicalBlockFormat(blockFormat);
+        if (canonicalBlock != blockFormat) {
+            cursor.setPosition(it.position());
+            cursor.setBlockFormat(canonicalBlock);
+        }
+        // Collect changes first, because changing formats invalidates the block's fragment iterator
+        std::vector<Change> changes;
+        for (QTextBlock::iterator jt = it.begin(); !(jt.atEnd()); ++jt) {
+            const QTextFragment fragment = jt.fragment();
+            if (!fragment.isValid())
+                continue;
+            const int start = qMax(fragment.position(), from);
+            const int end = qMin(fragment.position() + fragment.length(), to);
+            if (start >= end)
+                continue;
+            const QTextCharFormat charFormat = fragment.charFormat();
+            const QTextCharFormat canonical = canonicalCharFormat(charFormat, defaultFamily);
+            if (canonical != charFormat)
+                changes.push_back({start, end - start, canonical});
+        }
+        for (const Change &change : changes) {
+            cursor.setPosition(change.position);
+            cursor.setPosition(change.position + change.length, QTextCursor::KeepAnchor);
+            cursor.setCharFormat(change.format);
+        }
+    }
+    cursor.endEditBlock();
+}
+
 void DocumentHandler::unblockFileWatcher()
 {
     _fileSystemWatcher->blockSignals(false);
 }
 
+// Pasted images are referenced by short resource names while editing, so the document doesn't hold a second copy of each as a data URL. Saved scripts
+// embed them, to be self contained.
+QString DocumentHandler::embedImages(QString html) const
+{
+    for (auto it = m_imageResources.cbegin(); it != m_imageResources.cend(); ++it)
+        html.replace(QString::fromUtf8("src=\"") + it.key() + QLatin1Char('"'),
+                     QString::fromUtf8("src=\"data:image/") + QString::fromUtf8(it->format) + QString::fromUtf8(";base64,")
+                         + QString::fromLatin1(it->data.toBase64()) + QLatin1Char('"'));
+    return html;
+}
+
 void DocumentHandler::saveAs(const QUrl &fileUrl)
 {
     QTextDocument *doc = textDocument();
@@ -791,7 +952,7 @@ void DocumentHandler::saveAs(const QUrl &fileUrl)
         return;
     }
 
-    file.write((isHtml ? doc->toHtml() : doc->toPlainText()).toUtf8());
+    file.write((isHtml ? embedImages(doc->toHtml()) : doc->toPlainText()).toUtf8());
     file.flush();
     file.close();
 
@@ -814,19 +975,112 @@ void DocumentHandler::save()
     saveAs(url);
 }
 
-void DocumentHandler::reset()
+// Formatting actions notify right away, so that controls resynchronize even if the format couldn't be applied.
+void DocumentHandler::updateFormat()
+{
+    m_formatDirty = true;
+    m_formatUpdateQueued = false;
+    Q_EMIT formatChanged();
+}
+
+// The editor updates the cursor position and both ends of the selection one after the other on every move. Reads see
+// the new format right away, while bindings are notified once they've all been set.
+void DocumentHandler::scheduleFormatUpdate()
+{
+    m_formatDirty = true;
+    if (m_formatUpdateQueued)
+        return;
+    m_formatUpdateQueued = true;
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            if (m_formatUpdateQueued)
+                updateFormat();
+        },
+        Qt::QueuedConnection);
+}
+
+// Takes a single snapshot of the formatting at the cursor on the first read after a change, instead of having every
+// getter query the document.
+const CursorFormat &DocumentHandler::cursorFormat() const
+{
+    if (!m_formatDirty)
+        return m_format;
+    m_formatDirty = false;
+    CursorFormat next;
+    QTextCursor cursor = textCursor();
+    if (!cursor.isNull()) {
+        const QTextCharFormat charFormat = cursor.charFormat();
+        const QFont font = charFormat.font();
+        next.fontFamily = font.families().length() ? font.families().constFirst() : font.family();
+        next.textColor = charFormat.foreground().color();
+        next.textBackground = charFormat.background().color();
+        next.alignment = cursor.blockFormat().alignment();
+        next.bold = charFormat.fontWeight() == QFont::Bold;
+        next.italic = charFormat.fontItalic();
+        next.underline = charFormat.fontUnderline();
+        next.strike = charFormat.fontStrikeOut();
+        next.subscript = charFormat.verticalAlignment() == QTextCharFormat::AlignSubScript;
+        next.superscript = charFormat.verticalAlignment() == QTextCharFormat::AlignSuperScript;
+        const bool isAnchor = charFormat.isAnchor();
+        const bool hasNames = charFormat.anchorNames().size() > 0;
+        next.regularMarker = isAnchor && !hasNames;
+        next.namedMarker = isAnchor && hasNames;
+        next.fontSize = font.pointSize();
+    }
+    m_format = next;
+    return m_format;
+}
+
+int DocumentHandler::cursorBenchmark(const QString &filePath)
 {
-    Q_EMIT fontFamilyChanged(fontFamily());
-    Q_EMIT alignmentChanged();
-    Q_EMIT boldChanged();
-    Q_EMIT italicChanged();
-    Q_EMIT underlineChanged();
-    Q_EMIT strikeChanged();
-    Q_EMIT markerChanged();
-    Q_EMIT fontSizeChanged();
-    Q_EMIT textColorChanged();
-    Q_EMIT textBackgroundChanged();
-    Q_EMIT verticalAlignmentChanged();
+    QTextStream out(stdout);
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly)) {
+        out << "Cannot open " << filePath << ": " << file.errorString() << '\n';
+        return 1;
+    }
+
+    // DocumentHandler works on the document of a QML TextEdit, like the editor's
+    QQmlEngine engine;
+    QQmlComponent component(&engine);
+    component.setData("import QtQuick\nTextEdit { textFormat: TextEdit.AutoText }", QUrl());
+    std::unique_ptr<QObject> editor(component.create());
+    if (!editor) {
+        out << component.errorString() << '\n';
+        return 1;
+    }
+    editor->setProperty("text", QString::fromUtf8(file.readAll()));
+    DocumentHandler handler;
+    handler.setDocument(editor->property("textDocument").value<QQuickTextDocument *>());
+    int snapshots = 0;
+    // Read the format on every notification, as the toolbar's bindings do
+    connect(&handler, &DocumentHandler::formatChanged, &handler, [&handler, &snapshots]() {
+        handler.format();
+        snapshots++;
+    });
+
+    // Once with a bare cursor, as when moving with the arrow keys, then extending a selection, as when selecting with the mouse.
+    const int length = handler.textDocument()->characterCount() - 1;
+    QElapsedTimer timer;
+    timer.start();
+    for (int position = 0; position <= length; position++) {
+        handler.setCursorPosition(position);
+        handler.setSelectionStart(position);
+        handler.setSelectionEnd(position);
+        QCoreApplication::sendPostedEvents(&handler, QEvent::MetaCall);
+    }
+    for (int position = 0; position <= length; position++) {
+        handler.setCursorPosition(position);
+        handler.setSelectionStart(0);
+        handler.setSelectionEnd(position);
+        QCoreApplication::sendPostedEvents(&handler, QEvent::MetaCall);
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+    const int moves = 2 * (length + 1);
+    out << "Moved the cursor " << moves << " times in " << elapsed / 1e6 << " ms, " << elapsed / 1e3 / moves << " us per move, taking " << snapshots
+        << " format snapshots\n";
+    return 0;
 }
 
 QTextCursor DocumentHandler::textCursor() const
@@ -872,6 +1126,131 @@ void DocumentHandler::setModified(bool m)
         m_document->textDocument()->setModified(m);
 }
 
+// Undo history budget
+// QTextDocument keeps its own undo stack and doesn't report how much memory it holds, so the size of each step is estimated from the changes it made.
+// Text and formatting changes are both stored by Qt as deltas against the document's fragments, making the number of affected characters a fair proxy.
+qint64 DocumentHandler::undoMemoryBudget() const
+{
+    return m_undoMemoryBudget;
+}
+
+void DocumentHandler::setUndoMemoryBudget(qint64 bytes)
+{
+    if (bytes == m_undoMemoryBudget)
+        return;
+    m_undoMemoryBudget = bytes;
+    Q_EMIT undoMemoryBudgetChanged();
+    updateUndoMemoryUsage();
+}
+
+qint64 DocumentHandler::undoMemoryUsage() const
+{
+    return m_undoMemoryUsage;
+}
+
+void DocumentHandler::accountUndoCommand()
+{
+    // QTextDocument announces new steps right before the contentsChange that describes them.
+    m_undoCommandAdded = true;
+}
+
+void DocumentHandler::measureUndoChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(position)
+    QTextDocument *doc = textDocument();
+    if (!doc)
+        return;
+    const int undoState = doc->availableUndoSteps();
+    const int redoState = doc->availableRedoSteps();
+    // Fixed cost accounts for the command and fragment bookkeeping
+    constexpr qint64 commandOverhead = 64;
+    const qint64 size = commandOverhead + (static_cast<qint64>(charsRemoved) + charsAdded) * static_cast<qint64>(sizeof(QChar));
+
+    if (m_undoCommandAdded) {
+        // A new step, which replaces anything that could have been redone
+        const int previousState = m_undoState;
+        m_undoSteps.removeIf([previousState](const UndoStep &step) {
+            return step.end > previousState;
+        });
+        m_undoSteps.append({undoState, size});
+    }
+    else if (undoState != m_undoState && undoState - m_undoState == m_redoState - redoState) {
+        // Undoing and redoing move steps between the stacks without adding to them.
+    }
+    else if (undoState) {
+        // Merged into the current step, as consecutive typing is
+        m_undoSteps.removeIf([undoState](const UndoStep &step) {
+            return step.end > undoState;
+        });
+        if (!m_undoSteps.isEmpty() && m_undoSteps.last().end == undoState)
+            m_undoSteps.last().size += size;
+        else
+            m_undoSteps.append({undoState, size});
+    }
+    m_undoCommandAdded = false;
+    m_undoState = undoState;
+    m_redoState = redoState;
+    updateUndoMemoryUsage();
+}
+
+void DocumentHandler::updateUndoMemoryUsage()
+{
+    qint64 usage = 0;
+    int undoSteps = 0;
+    for (const UndoStep &step : std::as_const(m_undoSteps)) {
+        usage += step.size;
+        if (step.end <= m_undoState)
+            undoSteps++;
+    }
+    if (usage != m_undoMemoryUsage) {
+        m_undoMemoryUsage = usage;
+        Q_EMIT undoMemoryUsageChanged();
+    }
+    // A single step is kept regardless of its size, so a large paste or import can still be undone until the next edit. The stack can't be cleared
+    // while the document is still reporting the change that went over budget.
+    if (m_undoMemoryBudget > 0 && usage > m_undoMemoryBudget && undoSteps > 1 && !m_undoCompactionQueued) {
+        m_undoCompactionQueued = true;
+        QMetaObject::invokeMethod(this, &DocumentHandler::compactUndoHistory, Qt::QueuedConnection);
+    }
+}
+
+// QTextDocument can only clear its undo stack as a whole, and trimming it by replaying steps would edit the live document, relaying it out, moving
+// cursors and toggling its modified state. Once over budget, the undo history is dropped at once instead, leaving redo steps in place. This trades the
+// oldest-first trimming of a bounded stack for never touching the text. Formatting steps are already kept by Qt as compact deltas, storing indices into
+// the document's format table rather than copies of the text; their size is estimated by the characters they span, which errs on the early side.
+void DocumentHandler::compactUndoHistory()
+{
+    m_undoCompactionQueued = false;
+    QTextDocument *doc = textDocument();
+    if (!doc || m_undoMemoryBudget <= 0 || m_undoMemoryUsage <= m_undoMemoryBudget || doc->availableUndoSteps() == 0)
+        return;
+
+    const int dropped = doc->availableUndoSteps();
+    doc->clearUndoRedoStacks(QTextDocument::UndoStack);
+    m_undoSteps.removeIf([dropped](const UndoStep &step) {
+        return step.end <= dropped;
+    });
+    for (UndoStep &step : m_undoSteps)
+        step.end -= dropped;
+    m_undoState = 0;
+    m_redoState = doc->availableRedoSteps();
+    updateUndoMemoryUsage();
+}
+
+void DocumentHandler::resetUndoHistory()
+{
+    if (QTextDocument *doc = textDocument())
+        doc->clearUndoRedoStacks();
+    m_undoSteps.clear();
+    m_undoState = 0;
+    m_redoState = 0;
+    m_undoCommandAdded = false;
+    if (m_undoMemoryUsage) {
+        m_undoMemoryUsage = 0;
+        Q_EMIT undoMemoryUsageChanged();
+    }
+}
+
 QString DocumentHandler::filterHtml(QString html, bool ignoreBlackTextColor = true)
 // ignoreBlackTextColor=true is the default because websites tend to force black text color
 {
@@ -879,11 +1258,11 @@ QString DocumentHandler::filterHtml(QString html, bool ignoreBlackTextColor = tr
     bool comesFromRecognizedNativeSource = false;
     // Check for native sources, such as LibreOffice, MS Office, WPS Office, and AbiWord
     // Clean RegEx:  (<meta\s?\s*name="?[gG]enerator"?\s?\s*content="(?:(?:(?:(?:Libre)|(?:Open))Office)|(?:Microsoft)))
-    static QRegularExpression regex_1(
+    static const QRegularExpression regex_1(
         QString::fromUtf8("(<meta\\s?\\s*name=\"?[gG]enerator\"?\\s?\\s*content=\"(?:(?:(?:(?:Libre)|(?:Open))Office)|(?:Microsoft)))"),
         QRegularExpression::CaseInsensitiveOption);
     // Clean RegEx:  <!DOCTYPE html PUBLIC "-//ABISOURCE//DTD XHTML plus AWML
-    static QRegularExpression regex_2(QString::fromUtf8("<!DOCTYPE html PUBLIC \"-//ABISOURCE//DTD XHTML plus AWML"));
+    static const QRegularExpression regex_2(QString::fromUtf8("<!DOCTYPE html PUBLIC \"-//ABISOURCE//DTD XHTML plus AWML"));
     if (html.contains(regex_1) || html.contains(regex_2)) {
         comesFromRecognizedNativeSource = true;
         ignoreBlackTextColor = false;
@@ -900,12 +1279,12 @@ QString DocumentHandler::filterHtml(QString html, bool ignoreBlackTextColor = tr
     // Filters that run always:
     // 1. Remove HTML's non-scaling font-size attributes
     // Clean RegEx:  (font-size:\s*[\d]+(?:.[\d]+)*(?:(?:px)|(?:pt)|(?:em)|(?:ex));?\s*)
-    static QRegularExpression regex_3(QString::fromUtf8("(font-size:\\s*[\\d]+(?:.[\\d]+)*(?:(?:px)|(?:pt)|(?:em)|(?:ex));?\\s*)"));
+    static const QRegularExpression regex_3(QString::fromUtf8("(font-size:\\s*[\\d]+(?:.[\\d]+)*(?:(?:px)|(?:pt)|(?:em)|(?:ex));?\\s*)"));
     html = html.replace(regex_3, QString::fromUtf8(""));
 
     // Filters that apply only to native sources:
     if (comesFromRecognizedNativeSource) {
-        static QRegularExpression regex_4(QString::fromUtf8(
+        static const QRegularExpression regex_4(QString::fromUtf8(
             "(?:(?:p\\s*{.*(\\scolor:\\s*#[0123456789abcdefABCDEF]{3}(?:[0123456789abcdefABCDEF]{3})?;))|(?:(?:<[bB][oO][dD][yY]\\s).*(\\s(?:(?:text)|("
             "?:v?"
             "link))=\"#[0123456789abcdefABCDEF]{3}(?:[0123456789abcdefABCDEF]{3})?\").*(\\s(?:(?:text)|(?:v?link))=\"#[0123456789abcdefABCDEF]{3}(?:["
@@ -925,7 +1304,7 @@ QString DocumentHandler::filterHtml(QString html, bool ignoreBlackTextColor = tr
         // 3. Preserve highlights: Remove background color attributes from all elements except span, which is commonly used for highlights
         // Clean RegEx:
         // (?:<[^sS][^pP][^aA][^nN](?:\s*[^>]*(\s*background(?:-color)?:\s*(?:(?:rgba?\(\d\d?\d?,\s*\d\d?\d?,\s*\d\d?\d?(?:,\s*[01]?(?:[.]\d\d*)?)?\))|(?:#[0-9a-fA-F]{3}(?:[0-9a-fA-F]{3})?));?)\s*[^>]*)*>)
-        static QRegularExpression regex_5(
+        static const QRegularExpression regex_5(
             QString::fromUtf8("(?:<[^sS][^pP][^aA][^nN](?:\\s*[^>]*(\\s*background(?:-color)?:\\s*(?:(?:rgba?\\(\\d\\d?\\d?,\\s*\\d\\d?\\d?,\\s*\\d\\d?\\d?(?"
                               ":,\\s*[01]?(?:[.]\\d\\d*)?)?\\))|(?:#[0-9a-fA-F]{3}(?:[0-9a-fA-F]{3})?));?)\\s*[^>]*)*>)"));
         html = html.replace(regex_5, QString::fromUtf8(""));
@@ -938,7 +1317,7 @@ QString DocumentHandler::filterHtml(QString html, bool ignoreBlackTextColor = tr
         // LibreOffice has a correct implementation of default colors.
         // Clean RegEx:
         // (\s*(?:mso-style-textfill-fill-)?color:\s*(?:(?:rgba?\(\d{1,2},\s*\d{1,2},\s*\d{1,2}(?:,\s*[10]?(?:[.]00*)?)?\))|(?:black)|(?:windowtext)|(?:#0{3}(?:0{3})?));?)
-        static QRegularExpression regex_6(
+        static const QRegularExpression regex_6(
             QString::fromUtf8("(\\s*(?:mso-style-textfill-fill-)?color:\\s*(?:(?:rgba?\\(\\d{1,2},\\s*\\d{1,2},\\s*\\d{"
                               "1,2}(?:,\\s*[10]?(?:[.]00*)?)?\\))|(?:black)|(?:windowtext)|(?:#0{3}(?:0{3})?));?)"));
         html = html.replace(regex_6, QString::fromUtf8(""));
@@ -962,17 +1341,218 @@ void DocumentHandler::paste(bool withoutFormating = false)
     if (mimeData->hasHtml()) {
         if (withoutFormating)
             this->textCursor().insertText(mimeData->text());
-        else {
-            QString filteredHtml = this->filterHtml(mimeData->html());
-            this->textCursor().insertHtml(filteredHtml);
-        }
+        else
+            pasteHtml(mimeData->html());
     } else if (mimeData->hasText())
         this->textCursor().insertText(mimeData->text());
     // Moved image test to last because having it first breaks pasting from AbiWord
-    else if (mimeData->hasImage()) {
-        // Dev: Add image support
-        // setPixmap(qvariant_cast<QPixmap>(mimeData->imageData()));
+    else if (mimeData->hasImage() && !withoutFormating)
+        pasteImage(qvariant_cast<QImage>(mimeData->imageData()));
+}
+
+bool DocumentHandler::pasting() const
+{
+    return m_pendingPastes > 0;
+}
+
+void DocumentHandler::setPendingPastes(int pendingPastes)
+{
+    const bool wasPasting = pasting();
+    m_pendingPastes = pendingPastes;
+    if (wasPasting != pasting())
+        Q_EMIT pastingChanged();
+}
+
+// Inserts pasted HTML and canonicalizes the formats it brought along, in a single undo step
+void DocumentHandler::insertNormalizedHtml(QTextCursor &cursor, const QString &html)
+{
+    cursor.beginEditBlock();
+    const int start = cursor.selectionStart();
+    cursor.insertHtml(html);
+    normalizeFormats(start, cursor.position());
+    cursor.endEditBlock();
+}
+
+// Filter HTML pastes. Small pastes are filtered in place. Large ones, such as a slide deck's speaker notes, are filtered on a worker thread so the editor
+// doesn't freeze. The result is inserted at the cursor from the time of pasting, which QTextCursor keeps up to date with any edits made in the meantime.
+void DocumentHandler::pasteHtml(const QString &html)
+{
+    constexpr int asyncPasteThreshold = 64 * 1024;
+    QTextCursor cursor = textCursor();
+    if (html.length() < asyncPasteThreshold) {
+        insertNormalizedHtml(cursor, filterHtml(html));
+        return;
     }
+
+    const int generation = m_contentsGeneration;
+    setPendingPastes(m_pendingPastes + 1);
+    auto *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, cursor, generation]() mutable {
+        if (generation == m_contentsGeneration)
+            insertNormalizedHtml(cursor, watcher->result());
+        watcher->deleteLater();
+        setPendingPastes(m_pendingPastes - 1);
+    });
+    watcher->setFuture(QtConcurrent::run([html]() {
+        return DocumentHandler::filterHtml(html, true);
+    }));
+}
+
+// Paste images downscaled to fit the largest screen, the most the prompter can ever show, and keep them compressed so they can be embedded as data
+// URLs when the script is saved. Identical images are only stored once in the document's resources.
+void DocumentHandler::pasteImage(const QImage &image)
+{
+    if (image.isNull() || !textDocument())
+        return;
+
+    QSize maximumSize;
+    const QList<QScreen *> screens = QGuiApplication::screens();
+    for (const QScreen *screen : screens)
+        maximumSize = maximumSize.expandedTo(screen->geometry().size() * screen->devicePixelRatio());
+    if (maximumSize.isEmpty())
+        maximumSize = QSize(3840, 2160);
+
+    struct EncodedImage {
+        QString name;
+        const char *format = nullptr;
+        QByteArray data;
+        QImage image;
+    };
+    const int generation = m_contentsGeneration;
+    QTextCursor cursor = textCursor();
+    setPendingPastes(m_pendingPastes + 1);
+    auto *watcher = new QFutureWatcher<EncodedImage>(this);
+    connect(watcher, &QFutureWatcher<EncodedImage>::finished, this, [this, watcher, cursor, generation]() mutable {
+        const EncodedImage encoded = watcher->result();
+        QTextDocument *doc = textDocument();
+        if (doc && generation == m_contentsGeneration && !encoded.image.isNull()) {
+            // Reuse existing resource when the same image is pasted again
+            if (!m_imageResources.contains(encoded.name)) {
+                m_imageResources.insert(encoded.name, {encoded.format, encoded.data});
+                doc->addResource(QTextDocument::ImageResource, QUrl(encoded.name), QVariant(encoded.image));
+            }
+            QTextImageFormat format;
+            format.setName(encoded.name);
+            format.setWidth(encoded.image.width());
+            format.setHeight(encoded.image.height());
+            cursor.insertImage(format);
+        }
+        watcher->deleteLater();
+        setPendingPastes(m_pendingPastes - 1);
+    });
+    watcher->setFuture(QtConcurrent::run([image, maximumSize]() {
+        EncodedImage encoded;
+        const bool oversized = image.width() > maximumSize.width() || image.height() > maximumSize.height();
+        encoded.image = oversized ? image.scaled(maximumSize, Qt::KeepAspectRatio, Qt::SmoothTransformation) : image;
+        const bool opaque = !encoded.image.hasAlphaChannel();
+        encoded.image = encoded.image.convertToFormat(opaque ? QImage::Format_RGB32 : QImage::Format_ARGB32_Premultiplied);
+        const QByteArray hash = QCryptographicHash::hash(QByteArrayView(encoded.image.constBits(), encoded.image.sizeInBytes()), QCryptographicHash::Sha1);
+        encoded.name = QString::fromUtf8("qprompt-image-") + QString::fromLatin1(hash.toHex());
+        // Opaque images, like screenshots and photos, compress far better as JPEG
+        encoded.format = opaque ? "jpeg" : "png";
+        QBuffer buffer(&encoded.data);
+        buffer.open(QIODevice::WriteOnly);
+        encoded.image.save(&buffer, opaque ? "JPG" : "PNG", opaque ? 90 : -1);
+        return encoded;
+    }));
+}
+
+QVariantList DocumentHandler::glyphWarmup() const
+{
+    return m_glyphWarmup;
+}
+
+void DocumentHandler::clearGlyphWarmup()
+{
+    if (m_glyphWarmup.isEmpty())
+        return;
+    m_glyphWarmup.clear();
+    Q_EMIT glyphWarmupChanged();
+}
+
+// Pick real runs of the document's text per font family, weight and slant, so they can be rasterized and uploaded before prompting instead of stalling
+// the first scroll through the script. Runs are kept whole, so complex scripts such as Arabic or Bengali warm up their shaped forms rather than isolated
+// codepoints. Glyph caches live in the scene graph and don't outlast the process, so nothing is kept on disk; each load warms up again.
+void DocumentHandler::warmUpGlyphs(int pixelSize)
+{
+    QTextDocument *doc = textDocument();
+    if (!doc || pixelSize <= 0)
+        return;
+
+    // Fragment texts are gathered here because QTextDocument can't be read from other threads. Everything else happens on a worker.
+    struct GlyphRun {
+        QString family;
+        bool bold;
+        bool italic;
+        QString text;
+    };
+    QList<GlyphRun> runs;
+    const QString defaultFamily = doc->defaultFont().family();
+    for (QTextBlock block = doc->begin(); block.isValid(); block = block.next())
+        for (QTextBlock::iterator it = block.begin(); !it.atEnd(); ++it) {
+            const QTextFragment fragment = it.fragment();
+            if (!fragment.isValid())
+                continue;
+            const QTextCharFormat format = fragment.charFormat();
+            const QStringList families = format.fontFamilies().toStringList();
+            const QString family = families.isEmpty() ? defaultFamily : families.constFirst();
+            for (const QString &line : fragment.text().split(QChar::LineSeparator, Qt::SkipEmptyParts))
+                runs.append({family, format.fontWeight() >= QFont::DemiBold, format.fontItalic(), line});
+        }
+
+    const int generation = m_contentsGeneration;
+    auto *watcher = new QFutureWatcher<QVariantList>(this);
+    connect(watcher, &QFutureWatcher<QVariantList>::finished, this, [this, watcher, generation]() {
+        if (generation == m_contentsGeneration) {
+            m_glyphWarmup = watcher->result();
+            Q_EMIT glyphWarmupChanged();
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run([runs]() {
+        // Bounds the size of the warm-up text per style, and of each run, cut at a word boundary where possible.
+        constexpr int maximumWarmupLength = 16384;
+        constexpr int maximumRunLength = 256;
+
+        // A run is kept when it shows a glyph no earlier run of its style did, so every glyph is covered by the first lines that use it.
+        QStringList styles;
+        QHash<QString, QSet<char32_t>> covered;
+        QHash<QString, QStringList> lines;
+        QHash<QString, int> lengths;
+        for (const GlyphRun &run : runs) {
+            const QString style = run.family + QLatin1Char('/') + QLatin1Char(run.bold ? 'b' : 'n') + QLatin1Char(run.italic ? 'i' : 'n');
+            QString text = run.text;
+            if (text.size() > maximumRunLength) {
+                const int space = text.lastIndexOf(QLatin1Char(' '), maximumRunLength);
+                text.truncate(space > 0 ? space : maximumRunLength);
+            }
+            if (lengths.value(style) + text.size() > maximumWarmupLength)
+                continue;
+            const QList<char32_t> codepoints = text.toUcs4();
+            QSet<char32_t> &seen = covered[style];
+            const bool showsNewGlyph = std::any_of(codepoints.cbegin(), codepoints.cend(), [&seen](char32_t codepoint) {
+                return QChar::isPrint(codepoint) && !QChar::isSpace(codepoint) && !seen.contains(codepoint);
+            });
+            if (!showsNewGlyph)
+                continue;
+            for (const char32_t codepoint : codepoints)
+                seen.insert(codepoint);
+            if (!lines.contains(style))
+                styles.append(style);
+            lines[style].append(text);
+            lengths[style] += text.size();
+        }
+
+        QVariantList warmup;
+        for (const QString &style : std::as_const(styles)) {
+            const qsizetype flags = style.size() - 2;
+            warmup.append(QVariantMap({{QStringLiteral("family"), style.left(flags - 1)},
+                                       {QStringLiteral("bold"), style.at(flags) == QLatin1Char('b')},
+                                       {QStringLiteral("italic"), style.at(flags + 1) == QLatin1Char('i')},
+                                       {QStringLiteral("text"), lines.value(style).join(QLatin1Char('\n'))}}));
+        }
+        return warmup;
+    }));
 }
 
 void DocumentHandler::paste()
@@ -1097,31 +1677,87 @@ int DocumentHandler::keySearch(int key)
 }
 
 // Line Height
+int DocumentHandler::lineHeight() const
+{
+    return m_lineHeight;
+}
+
 void DocumentHandler::setLineHeight(int lineHeight)
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
+    if (lineHeight == m_lineHeight)
         return;
-    cursor.joinPreviousEditBlock();
-    cursor.select(QTextCursor::Document);
-    QTextBlockFormat modifier = QTextBlockFormat();
-    modifier.setLineHeight(lineHeight, QTextBlockFormat::ProportionalHeight);
-    cursor.mergeBlockFormat(modifier);
-    cursor.endEditBlock();
+    m_lineHeight = lineHeight;
+    m_typographyTimer->start();
+    Q_EMIT lineHeightChanged();
 }
 
 // Paragraph Height
+int DocumentHandler::paragraphHeight() const
+{
+    return m_paragraphHeight;
+}
+
 void DocumentHandler::setParagraphHeight(int paragraphHeight)
 {
-    QTextCursor cursor = textCursor();
-    if (cursor.isNull())
+    if (paragraphHeight == m_paragraphHeight)
         return;
-    cursor.joinPreviousEditBlock();
-    cursor.select(QTextCursor::Document);
-    QTextBlockFormat modifier = QTextBlockFormat();
-    modifier.setBottomMargin(paragraphHeight);
-    cursor.mergeBlockFormat(modifier);
-    cursor.endEditBlock();
+    m_paragraphHeight = paragraphHeight;
+    m_typographyTimer->start();
+    Q_EMIT paragraphHeightChanged();
+}
+
+void DocumentHandler::invalidateTypography()
+{
+    m_typographyApplied = false;
+}
+
+// Apply document-wide line and paragraph spacing.
+// Qt's text layout reads spacing from each block's format, so there is no single document property to set. Instead, only blocks that still follow the
+// previously applied document-wide values are updated. Blocks with their own spacing are left untouched, and nothing is written when values didn't change.
+// All changes are grouped into a single edit, which results in a single relayout.
+void DocumentHandler::applyTypography()
+{
+    m_typographyTimer->stop();
+    QTextDocument *doc = textDocument();
+    if (!doc)
+        return;
+    const bool lineHeightChanged = !m_typographyApplied || m_lineHeight != m_appliedLineHeight;
+    const bool paragraphHeightChanged = !m_typographyApplied || m_paragraphHeight != m_appliedParagraphHeight;
+    if (!lineHeightChanged && !paragraphHeightChanged)
+        return;
+
+    QTextCursor cursor(doc);
+    bool editing = false;
+    for (QTextBlock it = doc->begin(); it != doc->end(); it = it.next()) {
+        const QTextBlockFormat current = it.blockFormat();
+        QTextBlockFormat modifier;
+        if (lineHeightChanged) {
+            const bool followsDocument = !m_typographyApplied || !current.hasProperty(QTextFormat::LineHeight)
+                || (current.lineHeightType() == QTextBlockFormat::ProportionalHeight && qRound(current.lineHeight()) == m_appliedLineHeight);
+            if (followsDocument && !(current.lineHeightType() == QTextBlockFormat::ProportionalHeight && qRound(current.lineHeight()) == m_lineHeight))
+                modifier.setLineHeight(m_lineHeight, QTextBlockFormat::ProportionalHeight);
+        }
+        if (paragraphHeightChanged) {
+            const bool followsDocument =
+                !m_typographyApplied || !current.hasProperty(QTextFormat::BlockBottomMargin) || qRound(current.bottomMargin()) == m_appliedParagraphHeight;
+            if (followsDocument && !(current.hasProperty(QTextFormat::BlockBottomMargin) && qRound(current.bottomMargin()) == m_paragraphHeight))
+                modifier.setBottomMargin(m_paragraphHeight);
+        }
+        if (modifier.propertyCount() == 0)
+            continue;
+        if (!editing) {
+            cursor.joinPreviousEditBlock();
+            editing = true;
+        }
+        cursor.setPosition(it.position());
+        cursor.mergeBlockFormat(modifier);
+    }
+    if (editing)
+        cursor.endEditBlock();
+
+    m_appliedLineHeight = m_lineHeight;
+    m_appliedParagraphHeight = m_paragraphHeight;
+    m_typographyApplied = true;
 }
 
 // Markers (Anchors)
@@ -1138,6 +1774,8 @@ void DocumentHandler::parse()
     lines.reserve(size);
 
     _markersModel->clearMarkers();
+    m_wordLines.clear();
+    m_words.clear();
 
     // Go through the document once
     for (QTextBlock it = this->textDocument()->begin(); it != this->textDocument()->end(); it = it.next()) {
@@ -1145,11 +1783,13 @@ void DocumentHandler::parse()
 
         // Navigate the document's physical layout and extract line dimensions and text. Dimensions would be used for telemetry, text would be used as a
         // reference of what to expect during speech recognition.
+        const QPointF origin = this->textDocument()->documentLayout()->blockBoundingRect(it).topLeft();
         for (int i = 0; i < it.layout()->lineCount(); i++) {
             LINE line;
             line.rect = it.layout()->lineAt(i).naturalTextRect();
             line.text = it.text().mid(it.layout()->lineAt(i).textStart(), it.layout()->lineAt(i).textLength());
             lines.push_back(line);
+            appendWordGeometry(it, it.layout()->lineAt(i), origin);
         }
 
         // Navigate the document's formatting and extract markers' information.
@@ -1189,6 +1829,7 @@ void DocumentHandler::parse()
     }
     // Set markers list as clean
     this->setMarkersListClean();
+    m_wordGeometryDirty = false;
 
 #ifdef QT_DEBUG
     // Output results to terminal, only in debug compilation.
@@ -1206,6 +1847,141 @@ void DocumentHandler::parse()
 #endif
 }
 
+// Finds the word being read at height y, in document coordinates. Each line is swept from where reading starts to where
+// it ends as it passes through y, like a karaoke cursor, so the result moves word by word at the prompter's pace.
+// Lookups are logarithmic in the number of lines and words per line.
+QRectF DocumentHandler::wordAt(qreal y)
+{
+    if (m_wordGeometryDirty)
+        updateWordGeometry();
+
+    const auto line = std::upper_bound(m_wordLines.cbegin(), m_wordLines.cend(), y, [](qreal y, const WordLine &line) {
+        return y < line.bottom;
+    });
+    if (line == m_wordLines.cend() || y < line->top)
+        return QRectF();
+
+    const auto first = m_words.cbegin() + line->firstWord;
+    const auto end = m_words.cbegin() + line->endWord;
+    const qreal left = first->left;
+    const qreal right = (end - 1)->right;
+    const qreal progress = (y - line->top) / (line->bottom - line->top);
+    const qreal x = line->rightToLeft ? right - progress * (right - left) : left + progress * (right - left);
+    auto word = std::lower_bound(first, end, x, [](const WordSpan &word, qreal x) {
+        return word.right < x;
+    });
+    if (word == end)
+        --word;
+    return QRectF(word->left, line->top, word->right - word->left, line->bottom - line->top);
+}
+
+QList<QPointF> DocumentHandler::wordProgress()
+{
+    if (m_wordGeometryDirty)
+        updateWordGeometry();
+
+    QList<QPointF> progress;
+    if (m_wordLines.isEmpty())
+        return progress;
+    progress.reserve(m_wordLines.size() + 1);
+    progress.append(QPointF(m_wordLines.first().top, 0));
+    for (const WordLine &line : std::as_const(m_wordLines))
+        progress.append(QPointF(line.bottom, line.endWord));
+    return progress;
+}
+
+qreal DocumentHandler::cursorY(int position)
+{
+    QTextDocument *doc = textDocument();
+    if (!doc)
+        return 0;
+
+    const QTextBlock block = doc->findBlock(position);
+    if (!block.isValid() || !block.layout())
+        return 0;
+    const qreal top = doc->documentLayout()->blockBoundingRect(block).top();
+    const QTextLine line = block.layout()->lineForTextPosition(position - block.position());
+    return line.isValid() ? top + line.y() : top;
+}
+
+qreal DocumentHandler::cursorLineHeight(int position)
+{
+    QTextDocument *doc = textDocument();
+    if (!doc)
+        return 0;
+
+    const QTextBlock block = doc->findBlock(position);
+    if (!block.isValid() || !block.layout())
+        return 0;
+    const QTextLine line = block.layout()->lineForTextPosition(position - block.position());
+    return line.isValid() ? line.height() : doc->documentLayout()->blockBoundingRect(block).height();
+}
+
+int DocumentHandler::lineStart(qreal y)
+{
+    QTextDocument *doc = textDocument();
+    if (!doc)
+        return 0;
+
+    int position = doc->documentLayout()->hitTest(QPointF(doc->documentMargin(), y), Qt::FuzzyHit);
+    if (position < 0)
+        position = y <= 0 ? 0 : doc->characterCount() - 1;
+    const QTextBlock block = doc->findBlock(position);
+    if (!block.isValid() || !block.layout())
+        return position;
+    const QTextLine line = block.layout()->lineForTextPosition(position - block.position());
+    return line.isValid() ? block.position() + line.textStart() : block.position();
+}
+
+void DocumentHandler::updateWordGeometry()
+{
+    m_wordLines.clear();
+    m_words.clear();
+    m_wordGeometryDirty = false;
+    QTextDocument *doc = textDocument();
+    if (!doc)
+        return;
+
+    for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+        const QPointF origin = doc->documentLayout()->blockBoundingRect(block).topLeft();
+        for (int i = 0; i < block.layout()->lineCount(); i++)
+            appendWordGeometry(block, block.layout()->lineAt(i), origin);
+    }
+}
+
+void DocumentHandler::appendWordGeometry(const QTextBlock &block, const QTextLine &line, const QPointF &origin)
+{
+    const QString text = block.text();
+    const QRectF rect = line.naturalTextRect().translated(origin);
+    WordLine wordLine;
+    wordLine.top = rect.top();
+    wordLine.bottom = rect.bottom();
+    wordLine.firstWord = m_words.size();
+    wordLine.rightToLeft = block.textDirection() == Qt::RightToLeft;
+
+    const int end = line.textStart() + line.textLength();
+    for (int i = line.textStart(); i < end;) {
+        while (i < end && text.at(i).isSpace())
+            i++;
+        if (i == end)
+            break;
+        const int start = i;
+        while (i < end && !text.at(i).isSpace())
+            i++;
+        const qreal a = line.cursorToX(start);
+        const qreal b = line.cursorToX(i);
+        m_words.append({origin.x() + qMin(a, b), origin.x() + qMax(a, b)});
+    }
+    wordLine.endWord = m_words.size();
+    if (wordLine.endWord == wordLine.firstWord || wordLine.bottom <= wordLine.top)
+        return;
+
+    std::sort(m_words.begin() + wordLine.firstWord, m_words.end(), [](const WordSpan &a, const WordSpan &b) {
+        return a.left < b.left;
+    });
+    m_wordLines.append(wordLine);
+}
+
 Marker DocumentHandler::nextMarker(int position)
 {
     //     if (this->_markersModel->rowCount()==0)
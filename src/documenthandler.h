@@ -77,14 +77,20 @@
 #include <QObject>
 #include <QQmlEngine>
 #include <QTemporaryFile>
+#include <QTimer>
 #include <QUrl>
 
+#include "cursorformat.hpp"
 #include "markersmodel.h"
 #include "systemfontchooserdialog.h"
 #include <QFont>
+#include <QHash>
+#include <QImage>
 #include <QQuickTextDocument>
 #include <QTextCursor>
 #include <QTextDocument>
+#include <QTextLayout>
+#include <QVariantList>
 
 QT_BEGIN_NAMESPACE
 
@@ -98,29 +104,40 @@ class DocumentHandler : public QObject
     Q_PROPERTY(int selectionStart READ selectionStart WRITE setSelectionStart NOTIFY selectionStartChanged)
     Q_PROPERTY(int selectionEnd READ selectionEnd WRITE setSelectionEnd NOTIFY selectionEndChanged)
 
-    Q_PROPERTY(QColor textColor READ textColor WRITE setTextColor NOTIFY textColorChanged)
-    Q_PROPERTY(QColor textBackground READ textBackground WRITE setTextBackground NOTIFY textBackgroundChanged)
-    Q_PROPERTY(QString fontFamily READ fontFamily WRITE setFontFamily NOTIFY fontFamilyChanged)
-    Q_PROPERTY(Qt::Alignment alignment READ alignment WRITE setAlignment NOTIFY alignmentChanged)
-
-    Q_PROPERTY(bool bold READ bold WRITE setBold NOTIFY boldChanged)
-    Q_PROPERTY(bool italic READ italic WRITE setItalic NOTIFY italicChanged)
-    Q_PROPERTY(bool underline READ underline WRITE setUnderline NOTIFY underlineChanged)
-    Q_PROPERTY(bool strike READ strike WRITE setStrike NOTIFY strikeChanged)
-    Q_PROPERTY(bool subscript READ subscript WRITE setSubscript NOTIFY verticalAlignmentChanged)
-    Q_PROPERTY(bool superscript READ superscript WRITE setSuperscript NOTIFY verticalAlignmentChanged)
+    Q_PROPERTY(CursorFormat format READ format NOTIFY formatChanged)
+    Q_PROPERTY(QColor textColor READ textColor WRITE setTextColor NOTIFY formatChanged)
+    Q_PROPERTY(QColor textBackground READ textBackground WRITE setTextBackground NOTIFY formatChanged)
+    Q_PROPERTY(QString fontFamily READ fontFamily WRITE setFontFamily NOTIFY formatChanged)
+    Q_PROPERTY(Qt::Alignment alignment READ alignment WRITE setAlignment NOTIFY formatChanged)
+
+    Q_PROPERTY(bool bold READ bold WRITE setBold NOTIFY formatChanged)
+    Q_PROPERTY(bool italic READ italic WRITE setItalic NOTIFY formatChanged)
+    Q_PROPERTY(bool underline READ underline WRITE setUnderline NOTIFY formatChanged)
+    Q_PROPERTY(bool strike READ strike WRITE setStrike NOTIFY formatChanged)
+    Q_PROPERTY(bool subscript READ subscript WRITE setSubscript NOTIFY formatChanged)
+    Q_PROPERTY(bool superscript READ superscript WRITE setSuperscript NOTIFY formatChanged)
     Q_PROPERTY(bool autoReload READ autoReload WRITE setAutoReload NOTIFY autoReloadChanged)
 
-    Q_PROPERTY(bool regularMarker READ regularMarker WRITE setMarker NOTIFY markerChanged)
-    Q_PROPERTY(bool namedMarker READ namedMarker NOTIFY markerChanged)
+    Q_PROPERTY(bool regularMarker READ regularMarker WRITE setMarker NOTIFY formatChanged)
+    Q_PROPERTY(bool namedMarker READ namedMarker NOTIFY formatChanged)
 
-    Q_PROPERTY(int fontSize READ fontSize WRITE setFontSize NOTIFY fontSizeChanged)
+    Q_PROPERTY(int fontSize READ fontSize WRITE setFontSize NOTIFY formatChanged)
+
+    // Document-wide typography
+    Q_PROPERTY(int lineHeight READ lineHeight WRITE setLineHeight NOTIFY lineHeightChanged)
+    Q_PROPERTY(int paragraphHeight READ paragraphHeight WRITE setParagraphHeight NOTIFY paragraphHeightChanged)
 
     Q_PROPERTY(QString fileName READ fileName NOTIFY fileUrlChanged)
     Q_PROPERTY(QString fileType READ fileType NOTIFY fileUrlChanged)
     Q_PROPERTY(QUrl fileUrl READ fileUrl NOTIFY fileUrlChanged)
 
     Q_PROPERTY(bool modified READ modified WRITE setModified NOTIFY modifiedChanged)
+    Q_PROPERTY(bool pasting READ pasting NOTIFY pastingChanged)
+    Q_PROPERTY(QVariantList glyphWarmup READ glyphWarmup NOTIFY glyphWarmupChanged)
+
+    // Undo history
+    Q_PROPERTY(qint64 undoMemoryBudget READ undoMemoryBudget WRITE setUndoMemoryBudget NOTIFY undoMemoryBudgetChanged)
+    Q_PROPERTY(qint64 undoMemoryUsage READ undoMemoryUsage NOTIFY undoMemoryUsageChanged)
 
     //     Q_PROPERTY(MarkersModel* markers READ markers CONSTANT STORED false)
     QML_ELEMENT
@@ -141,6 +158,8 @@ public:
     int selectionEnd() const;
     void setSelectionEnd(int position);
 
+    CursorFormat format() const;
+
     QString fontFamily() const;
     void setFontFamily(const QString &family);
 
@@ -184,6 +203,10 @@ public:
     bool modified() const;
     void setModified(bool m);
 
+    qint64 undoMemoryBudget() const;
+    void setUndoMemoryBudget(qint64 bytes);
+    qint64 undoMemoryUsage() const;
+
     bool regularMarker() const;
     bool namedMarker() const;
     bool markersListDirty() const;
@@ -195,15 +218,34 @@ public:
     Q_INVOKABLE MarkersModel *markers() const;
     Q_INVOKABLE Marker previousMarker(int position);
     Q_INVOKABLE Marker nextMarker(int position);
-    Q_INVOKABLE void setLineHeight(int lineHeight);
-    Q_INVOKABLE void setParagraphHeight(int paragraphHeight);
+
+    int lineHeight() const;
+    void setLineHeight(int lineHeight);
+    int paragraphHeight() const;
+    void setParagraphHeight(int paragraphHeight);
+    Q_INVOKABLE void applyTypography();
 
     Q_INVOKABLE void paste(bool withoutFormating);
     Q_INVOKABLE void paste();
+    bool pasting() const;
+    QVariantList glyphWarmup() const;
+    Q_INVOKABLE void warmUpGlyphs(int pixelSize);
+    Q_INVOKABLE void clearGlyphWarmup();
     Q_INVOKABLE QPoint replaceSelected(QString text);
     Q_INVOKABLE long replaceAll(const QString &searchedText, const QString &replacementText, bool regEx);
     Q_INVOKABLE void parse();
-    Q_INVOKABLE QString filterHtml(QString html, bool ignoreBlackTextColor);
+    Q_INVOKABLE QRectF wordAt(qreal y);
+    // Words laid out up to each line's bottom edge, as (y, words) points in document coordinates, preceded by the first
+    // line's top edge at no words.
+    QList<QPointF> wordProgress();
+    // Document y of the top of the line holding a cursor position
+    qreal cursorY(int position);
+    // Height of the line holding a cursor position
+    qreal cursorLineHeight(int position);
+    // Cursor position at the start of the line at document y, clamped to the document
+    int lineStart(qreal y);
+    // Depends on nothing but its arguments, so large pastes can be filtered on a worker thread
+    Q_INVOKABLE static QString filterHtml(QString html, bool ignoreBlackTextColor);
 
     // Search
     Q_INVOKABLE QPoint search(const QString &subString, const bool next = false, const bool reverse = false, const bool regEx = false, bool loop = true);
@@ -215,6 +257,10 @@ public:
 
     Q_INVOKABLE void loadFromNetwork(const QUrl &url);
 
+    // Walks the cursor through a script the way the editor moves it and reports the cost of keeping the format snapshot up to date. Returns a process
+    // exit code.
+    static int cursorBenchmark(const QString &filePath);
+
 public Q_SLOTS:
     void loadFromNetworkFinihed();
     void load(const QUrl &fileUrl);
@@ -230,21 +276,13 @@ Q_SIGNALS:
     void selectionStartChanged();
     void selectionEndChanged();
 
-    void fontFamilyChanged(QString);
-    void textColorChanged();
-    void textBackgroundChanged();
-    void alignmentChanged();
+    // Notifies every formatting property at once
+    void formatChanged();
 
-    void boldChanged();
-    void italicChanged();
-    void underlineChanged();
-    void strikeChanged();
-    void verticalAlignmentChanged();
     void autoReloadChanged();
 
-    void markerChanged();
-
-    void fontSizeChanged();
+    void lineHeightChanged();
+    void paragraphHeightChanged();
 
     void textChanged();
     void fileUrlChanged();
@@ -253,16 +291,37 @@ Q_SIGNALS:
     void error(const QString &message);
 
     void modifiedChanged();
+    void pastingChanged();
+    void glyphWarmupChanged();
+
+    void undoMemoryBudgetChanged();
+    void undoMemoryUsageChanged();
 
 private:
-    void reset();
+    void updateFormat();
+    void scheduleFormatUpdate();
+    const CursorFormat &cursorFormat() const;
     QTextCursor textCursor() const;
     QTextDocument *textDocument() const;
     void unblockFileWatcher();
     void mergeFormatOnWordOrSelection(const QTextCharFormat &format);
+    void invalidateTypography();
+    void measureUndoChange(int position, int charsRemoved, int charsAdded);
+    void accountUndoCommand();
+    void updateUndoMemoryUsage();
+    void compactUndoHistory();
+    void resetUndoHistory();
+    void updateWordGeometry();
+    void appendWordGeometry(const QTextBlock &block, const QTextLine &line, const QPointF &origin);
 
     enum ImportFormat { NONE, PDF, ODT, DOCX, DOC, RTF, ABW, EPUB, MOBI, AZW, PAGES, PAGESX };
     void updateContents(const QString &text, Qt::TextFormat format);
+    void normalizeFormats(int from = 0, int to = -1);
+    void insertNormalizedHtml(QTextCursor &cursor, const QString &html);
+    void pasteHtml(const QString &html);
+    void pasteImage(const QImage &image);
+    QString embedImages(QString html) const;
+    void setPendingPastes(int pendingPastes);
     QString import(const QString &fileName, ImportFormat);
 
     QQuickTextDocument *m_document;
@@ -271,6 +330,10 @@ private:
     int m_cursorPosition;
     int m_selectionStart;
     int m_selectionEnd;
+    // Taken on the first read after the cursor, selection or formatting changes
+    mutable CursorFormat m_format;
+    mutable bool m_formatDirty;
+    bool m_formatUpdateQueued;
 
     MarkersModel *_markersModel;
     QFileSystemWatcher *_fileSystemWatcher;
@@ -282,6 +345,59 @@ private:
     QNetworkAccessManager *m_network;
     QNetworkReply *m_reply;
     QTemporaryFile *m_cache;
+
+    // Document-wide typography, applied once values settle
+    QTimer *m_typographyTimer;
+    int m_lineHeight;
+    int m_paragraphHeight;
+    int m_appliedLineHeight;
+    int m_appliedParagraphHeight;
+    bool m_typographyApplied;
+
+    // Estimated size of each undo step, oldest first, including steps that were undone and may be redone
+    struct UndoStep {
+        // Undo stack position once the step is applied
+        int end;
+        qint64 size;
+    };
+    QList<UndoStep> m_undoSteps;
+    // Undo and redo stack positions as of the last change seen
+    int m_undoState;
+    int m_redoState;
+    bool m_undoCommandAdded;
+    bool m_undoCompactionQueued;
+    qint64 m_undoMemoryUsage;
+    qint64 m_undoMemoryBudget;
+
+    // Paste pipeline
+    int m_pendingPastes;
+    int m_contentsGeneration;
+    // Encoded pasted images by resource name, turned into data URLs when saving
+    struct EmbeddedImage {
+        const char *format;
+        QByteArray data;
+    };
+    QHash<QString, EmbeddedImage> m_imageResources;
+
+    // Runs of text per font family, weight and slant, rendered once out of sight to fill the scene graph's glyph caches
+    QVariantList m_glyphWarmup;
+
+    // Extents of laid out words in document coordinates, for wordAt(). Lines are kept in document order, so their
+    // positions are sorted, and words within each line are sorted from left to right.
+    struct WordLine {
+        qreal top;
+        qreal bottom;
+        int firstWord;
+        int endWord;
+        bool rightToLeft;
+    };
+    struct WordSpan {
+        qreal left;
+        qreal right;
+    };
+    QList<WordLine> m_wordLines;
+    QList<WordSpan> m_words;
+    bool m_wordGeometryDirty;
 };
 QT_END_NAMESPACE
 
@@ -0,0 +1,420 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "frameprofiler.h"
+
+#include <QAbstractEventDispatcher>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScreen>
+#include <QTextStream>
+
+// Keep about ten minutes of samples at 100 Hz for export.
+static constexpr int MAX_HISTORY = 60000;
+static constexpr int COLLECT_INTERVAL = 500;
+// Qt Quick only renders when something changes. A frame that waited this many refresh periods to start, while the GUI
+// thread spent most of that wait blocked in its event loop, follows idle time rather than a stall.
+static constexpr int IDLE_PERIODS = 2;
+
+// Every profiler alive, so timings from all windows can be exported together. Only accessed from the GUI thread.
+static QList<FrameProfiler *> s_profilers;
+
+TimeHistogram::TimeHistogram()
+    : m_counts(Bins, 0)
+    , m_total(0)
+{
+}
+
+void TimeHistogram::add(float milliseconds, int count)
+{
+    const int bin = qBound(0, int(milliseconds * BinsPerMillisecond), Bins - 1);
+    m_counts[bin] += count;
+    m_total += count;
+}
+
+void TimeHistogram::clear()
+{
+    m_counts.fill(0, Bins);
+    m_total = 0;
+}
+
+qreal TimeHistogram::percentile(qreal fraction) const
+{
+    if (m_total <= 0)
+        return 0;
+    const int rank = qMin(m_total - 1, qFloor(fraction * m_total));
+    int seen = 0;
+    for (int bin = 0; bin < Bins; ++bin) {
+        seen += m_counts[bin];
+        if (seen > rank)
+            // Upper edge of the bin, so the result never understates a time
+            return qreal(bin + 1) / BinsPerMillisecond;
+    }
+    return qreal(Bins) / BinsPerMillisecond;
+}
+
+FrameProfiler::FrameProfiler(QObject *parent)
+    : QObject(parent)
+    , m_enabled(false)
+    , m_syncStart(0)
+    , m_renderStart(0)
+    , m_lastSwap(-1)
+    , m_waited(0)
+    , m_sync(0)
+    , m_render(0)
+    , m_restart(false)
+    , m_refreshNanoseconds(1000000000 / 60)
+    , m_guiBlocked(0)
+    , m_lostSamples(0)
+    , m_blockedSince(-1)
+    , m_blocked(0)
+    , m_historyStart(0)
+    , m_refreshInterval(1000.0 / 60)
+    , m_meanInterval(0)
+    , m_p99Interval(0)
+    , m_p99Sync(0)
+    , m_p99Render(0)
+    , m_droppedFrames(0)
+    , m_idleFrames(0)
+    , m_intervalTotal(0)
+    , m_histogram(HistogramBuckets, 0)
+{
+    m_clock.start();
+    m_collectTimer.setInterval(COLLECT_INTERVAL);
+    connect(&m_collectTimer, &QTimer::timeout, this, &FrameProfiler::poll);
+    s_profilers.append(this);
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    detach();
+    s_profilers.removeOne(this);
+}
+
+QQuickWindow *FrameProfiler::window() const
+{
+    return m_window;
+}
+
+void FrameProfiler::setWindow(QQuickWindow *window)
+{
+    if (window == m_window)
+        return;
+
+    detach();
+    m_window = window;
+    attach();
+    Q_EMIT windowChanged();
+}
+
+QString FrameProfiler::name() const
+{
+    return m_name;
+}
+
+void FrameProfiler::setName(const QString &name)
+{
+    if (name == m_name)
+        return;
+
+    m_name = name;
+    Q_EMIT nameChanged();
+}
+
+bool FrameProfiler::enabled() const
+{
+    return m_enabled;
+}
+
+void FrameProfiler::setEnabled(bool enabled)
+{
+    if (enabled == m_enabled)
+        return;
+
+    detach();
+    m_enabled = enabled;
+    attach();
+    Q_EMIT enabledChanged();
+}
+
+int FrameProfiler::frames() const
+{
+    return m_history.size();
+}
+
+int FrameProfiler::droppedFrames() const
+{
+    return m_droppedFrames;
+}
+
+int FrameProfiler::idleFrames() const
+{
+    return m_idleFrames;
+}
+
+qreal FrameProfiler::refreshInterval() const
+{
+    return m_refreshInterval;
+}
+
+qreal FrameProfiler::meanInterval() const
+{
+    return m_meanInterval;
+}
+
+qreal FrameProfiler::p99Interval() const
+{
+    return m_p99Interval;
+}
+
+qreal FrameProfiler::p99Sync() const
+{
+    return m_p99Sync;
+}
+
+qreal FrameProfiler::p99Render() const
+{
+    return m_p99Render;
+}
+
+QList<int> FrameProfiler::histogram() const
+{
+    return m_histogram;
+}
+
+void FrameProfiler::reset()
+{
+    m_history.clear();
+    m_historyStart = 0;
+    m_intervals.clear();
+    m_syncs.clear();
+    m_renders.clear();
+    m_histogram.fill(0, HistogramBuckets);
+    m_droppedFrames = 0;
+    m_idleFrames = 0;
+    m_intervalTotal = 0;
+    m_lostSamples.store(0, std::memory_order_relaxed);
+    collect();
+}
+
+bool FrameProfiler::save(const QUrl &fileUrl) const
+{
+    const QString filePath = fileUrl.toLocalFile();
+    QFile file(filePath);
+    const bool isJson = QFileInfo(filePath).suffix().compare(QLatin1String("json"), Qt::CaseInsensitive) == 0;
+    if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
+        return false;
+
+    if (isJson) {
+        QJsonArray windows;
+        for (const FrameProfiler *profiler : std::as_const(s_profilers)) {
+            QJsonArray samples;
+            for (qsizetype i = 0; i < profiler->m_history.size(); ++i) {
+                const FrameSample &sample = profiler->m_history.at((profiler->m_historyStart + i) % profiler->m_history.size());
+                samples.append(QJsonArray({sample.timestamp / 1e6, sample.sync, sample.render, sample.interval, sample.idle}));
+            }
+            QJsonArray histogram;
+            for (const int count : profiler->m_histogram)
+                histogram.append(count);
+            windows.append(QJsonObject({{QStringLiteral("name"), profiler->m_name},
+                                        {QStringLiteral("refreshInterval"), profiler->m_refreshInterval},
+                                        {QStringLiteral("meanInterval"), profiler->m_meanInterval},
+                                        {QStringLiteral("p99Interval"), profiler->m_p99Interval},
+                                        {QStringLiteral("p99Sync"), profiler->m_p99Sync},
+                                        {QStringLiteral("p99Render"), profiler->m_p99Render},
+                                        {QStringLiteral("droppedFrames"), profiler->m_droppedFrames},
+                                        {QStringLiteral("lostSamples"), profiler->m_lostSamples.load(std::memory_order_relaxed)},
+                                        {QStringLiteral("idleFrames"), profiler->m_idleFrames},
+                                        {QStringLiteral("histogram"), histogram},
+                                        {QStringLiteral("columns"), QJsonArray({QStringLiteral("timestamp"), QStringLiteral("sync"), QStringLiteral("render"), QStringLiteral("interval"), QStringLiteral("idle")})},
+                                        {QStringLiteral("samples"), samples}}));
+        }
+        file.write(QJsonDocument(QJsonObject({{QStringLiteral("windows"), windows}})).toJson(QJsonDocument::Compact));
+    }
+    else {
+        QTextStream stream(&file);
+        stream << "window,timestamp_ms,sync_ms,render_ms,interval_ms,idle\n";
+        for (const FrameProfiler *profiler : std::as_const(s_profilers)) {
+            QString name = profiler->m_name;
+            name.replace(QLatin1Char('"'), QLatin1String("\"\""));
+            for (qsizetype i = 0; i < profiler->m_history.size(); ++i) {
+                const FrameSample &sample = profiler->m_history.at((profiler->m_historyStart + i) % profiler->m_history.size());
+                stream << '"' << name << "\"," << sample.timestamp / 1e6 << ',' << sample.sync << ',' << sample.render << ',' << sample.interval << ','
+                       << int(sample.idle) << '\n';
+            }
+        }
+    }
+    file.close();
+    return true;
+}
+
+void FrameProfiler::poll()
+{
+    if (!m_ring.pending()) {
+        m_collectTimer.stop();
+        return;
+    }
+    collect();
+}
+
+void FrameProfiler::collect()
+{
+    if (m_window && m_window->screen() && m_window->screen()->refreshRate() > 0) {
+        m_refreshInterval = 1000 / m_window->screen()->refreshRate();
+        m_refreshNanoseconds.store(qint64(m_refreshInterval * 1e6), std::memory_order_relaxed);
+    }
+
+    // Only new samples, and the ones they evict, are accounted for, so collecting stays cheap however long the history.
+    m_ring.drain([this](FrameSample sample) {
+        // A frame presented n refresh periods after the previous one means n - 1 were missed.
+        sample.missed = quint8(qBound(0, qRound(sample.interval / m_refreshInterval) - 1, 255));
+        if (m_history.size() < MAX_HISTORY)
+            m_history.append(sample);
+        else {
+            account(m_history.at(m_historyStart), -1);
+            m_history[m_historyStart] = sample;
+            m_historyStart = (m_historyStart + 1) % MAX_HISTORY;
+        }
+        account(sample, 1);
+    });
+
+    const int busyFrames = m_history.size() - m_idleFrames;
+    m_meanInterval = busyFrames > 0 ? m_intervalTotal / 1e3 / busyFrames : 0;
+    m_p99Interval = m_intervals.percentile(0.99);
+    m_p99Sync = m_syncs.percentile(0.99);
+    m_p99Render = m_renders.percentile(0.99);
+    Q_EMIT statisticsChanged();
+}
+
+void FrameProfiler::account(const FrameSample &sample, int count)
+{
+    m_syncs.add(sample.sync, count);
+    m_renders.add(sample.render, count);
+    if (sample.idle) {
+        m_idleFrames += count;
+        return;
+    }
+    m_intervals.add(sample.interval, count);
+    // Whole microseconds, so adding and removing a sample cancel out exactly
+    m_intervalTotal += count * qRound64(sample.interval * 1e3);
+    m_droppedFrames += count * sample.missed;
+    m_histogram[qMin<int>(sample.missed, HistogramBuckets - 1)] += count;
+}
+
+void FrameProfiler::attach()
+{
+    if (!m_enabled || !m_window)
+        return;
+
+    // The render thread owns m_lastSwap, so it forgets the previous swap itself.
+    m_restart.store(true, std::memory_order_relaxed);
+    m_blockedSince = -1;
+    m_blocked = 0;
+    // Direct connections, so timestamps are taken on the render thread as each stage happens.
+    connect(m_window, &QQuickWindow::beforeSynchronizing, this, &FrameProfiler::beforeSynchronizing, Qt::DirectConnection);
+    connect(m_window, &QQuickWindow::afterSynchronizing, this, &FrameProfiler::afterSynchronizing, Qt::DirectConnection);
+    connect(m_window, &QQuickWindow::beforeRendering, this, &FrameProfiler::beforeRendering, Qt::DirectConnection);
+    connect(m_window, &QQuickWindow::afterRendering, this, &FrameProfiler::afterRendering, Qt::DirectConnection);
+    connect(m_window, &QQuickWindow::frameSwapped, this, &FrameProfiler::frameSwapped, Qt::DirectConnection);
+    connect(m_window, &QQuickWindow::afterAnimating, this, &FrameProfiler::animating);
+    // Time the GUI thread spends blocked in its event loop tells idle time apart from a stall while preparing a frame.
+    if (QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(thread())) {
+        connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &FrameProfiler::blocking);
+        connect(dispatcher, &QAbstractEventDispatcher::awake, this, &FrameProfiler::awake);
+    }
+    m_collectTimer.start();
+}
+
+void FrameProfiler::detach()
+{
+    m_collectTimer.stop();
+    if (m_window)
+        disconnect(m_window, nullptr, this, nullptr);
+    if (QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(thread()))
+        disconnect(dispatcher, nullptr, this, nullptr);
+}
+
+void FrameProfiler::blocking()
+{
+    m_blockedSince = m_clock.nsecsElapsed();
+}
+
+void FrameProfiler::awake()
+{
+    if (m_blockedSince < 0)
+        return;
+    m_blocked += m_clock.nsecsElapsed() - m_blockedSince;
+    m_blockedSince = -1;
+}
+
+void FrameProfiler::animating()
+{
+    // Hand the blocked time since the previous frame to the render thread, which synchronizes this frame next.
+    m_guiBlocked.store(m_blocked, std::memory_order_relaxed);
+    m_blocked = 0;
+    // Polling stops while the window is idle, and resumes with the next frame it prepares.
+    if (!m_collectTimer.isActive())
+        m_collectTimer.start();
+}
+
+void FrameProfiler::beforeSynchronizing()
+{
+    m_syncStart = m_clock.nsecsElapsed();
+    if (m_restart.exchange(false, std::memory_order_relaxed))
+        m_lastSwap = -1;
+    m_waited = m_lastSwap >= 0 ? m_syncStart - m_lastSwap : 0;
+}
+
+void FrameProfiler::afterSynchronizing()
+{
+    m_sync = (m_clock.nsecsElapsed() - m_syncStart) / 1e6;
+}
+
+void FrameProfiler::beforeRendering()
+{
+    m_renderStart = m_clock.nsecsElapsed();
+}
+
+void FrameProfiler::afterRendering()
+{
+    m_render = (m_clock.nsecsElapsed() - m_renderStart) / 1e6;
+}
+
+void FrameProfiler::frameSwapped()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    // Every frame is recorded. Idle ones are marked rather than dropped, so long stalls still count.
+    if (m_lastSwap >= 0) {
+        FrameSample sample;
+        sample.timestamp = now;
+        sample.sync = m_sync;
+        sample.render = m_render;
+        sample.interval = (now - m_lastSwap) / 1e6;
+        sample.idle = m_waited > IDLE_PERIODS * m_refreshNanoseconds.load(std::memory_order_relaxed)
+            && m_guiBlocked.load(std::memory_order_relaxed) * 2 > m_waited;
+        if (!m_ring.push(sample))
+            m_lostSamples.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_lastSwap = now;
+}
@@ -0,0 +1,223 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QQuickWindow>
+#include <QTimer>
+#include <QUrl>
+
+#include <array>
+#include <atomic>
+
+struct FrameSample {
+    qint64 timestamp = 0; // Nanoseconds since the profiler started, at frame swap
+    float sync = 0; // Milliseconds spent synchronizing QML state into the scene graph
+    float render = 0; // Milliseconds spent rendering
+    float interval = 0; // Milliseconds since the previous frame swap
+    bool idle = false; // Nothing was waiting to be shown for most of the interval, so it isn't a stall
+    quint8 missed = 0; // Refresh periods missed, filled in on the GUI thread
+};
+
+// Counts of millisecond times in fixed bins, so percentiles over a sliding window of samples cost a walk over the bins
+// instead of sorting the window.
+class TimeHistogram
+{
+public:
+    TimeHistogram();
+    void add(float milliseconds, int count = 1);
+    void clear();
+    qreal percentile(qreal fraction) const;
+
+private:
+    static constexpr int BinsPerMillisecond = 10;
+    // Up to two seconds. Longer times count in the last bin.
+    static constexpr int Bins = 2000 * BinsPerMillisecond;
+
+    QList<int> m_counts;
+    int m_total;
+};
+
+// Bounded single producer, single consumer ring of frame samples. The render thread writes, the GUI thread reads; neither
+// blocks. Slots are only reused once the reader has released them, so a sample is never read while being written. Pushes
+// fail while the ring is full, which takes over half a minute of the GUI thread not collecting at 120 Hz.
+template<int Capacity>
+class FrameSampleRing
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool push(const FrameSample &sample)
+    {
+        const quint64 head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) >= Capacity)
+            return false;
+        m_samples[head & (Capacity - 1)] = sample;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pending() const
+    {
+        return m_head.load(std::memory_order_acquire) != m_tail.load(std::memory_order_relaxed);
+    }
+
+    // Passes samples written since the previous call to read, then releases their slots to the writer.
+    template<typename Read>
+    void drain(Read read)
+    {
+        const quint64 head = m_head.load(std::memory_order_acquire);
+        quint64 tail = m_tail.load(std::memory_order_relaxed);
+        for (; tail < head; ++tail)
+            read(m_samples[tail & (Capacity - 1)]);
+        m_tail.store(tail, std::memory_order_release);
+    }
+
+private:
+    std::array<FrameSample, Capacity> m_samples;
+    std::atomic<quint64> m_head{0};
+    std::atomic<quint64> m_tail{0};
+};
+
+// Records CPU sync time, render time and present intervals for a window.
+class FrameProfiler : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(QQuickWindow *window READ window WRITE setWindow NOTIFY windowChanged)
+    Q_PROPERTY(QString name READ name WRITE setName NOTIFY nameChanged)
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(int frames READ frames NOTIFY statisticsChanged)
+    Q_PROPERTY(int droppedFrames READ droppedFrames NOTIFY statisticsChanged)
+    // Frames shown after the window sat idle, left out of interval statistics
+    Q_PROPERTY(int idleFrames READ idleFrames NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal refreshInterval READ refreshInterval NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal meanInterval READ meanInterval NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal p99Interval READ p99Interval NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal p99Sync READ p99Sync NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal p99Render READ p99Render NOTIFY statisticsChanged)
+    // Frame counts by number of refresh periods missed: none, one, two, three or more
+    Q_PROPERTY(QList<int> histogram READ histogram NOTIFY statisticsChanged)
+
+public:
+    explicit FrameProfiler(QObject *parent = nullptr);
+    ~FrameProfiler();
+
+    QQuickWindow *window() const;
+    void setWindow(QQuickWindow *window);
+    QString name() const;
+    void setName(const QString &name);
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    int frames() const;
+    int droppedFrames() const;
+    int idleFrames() const;
+    qreal refreshInterval() const;
+    qreal meanInterval() const;
+    qreal p99Interval() const;
+    qreal p99Sync() const;
+    qreal p99Render() const;
+    QList<int> histogram() const;
+
+    Q_INVOKABLE void reset();
+    // Reads pending samples and updates the statistics.
+    Q_INVOKABLE void collect();
+    // Writes samples from every profiler, as JSON when the file name ends in .json and as CSV otherwise.
+    Q_INVOKABLE bool save(const QUrl &fileUrl) const;
+
+Q_SIGNALS:
+    void windowChanged();
+    void nameChanged();
+    void enabledChanged();
+    void statisticsChanged();
+
+private Q_SLOTS:
+    void poll();
+
+private:
+    static constexpr int HistogramBuckets = 4;
+
+    void attach();
+    void detach();
+    // Adds a sample to the statistics, or takes it out with a count of -1
+    void account(const FrameSample &sample, int count);
+    void blocking();
+    void awake();
+    void animating();
+    // Render thread
+    void beforeSynchronizing();
+    void afterSynchronizing();
+    void beforeRendering();
+    void afterRendering();
+    void frameSwapped();
+
+    QPointer<QQuickWindow> m_window;
+    QString m_name;
+    bool m_enabled;
+    QTimer m_collectTimer;
+
+    // Owned by the render thread while attached
+    QElapsedTimer m_clock;
+    qint64 m_syncStart;
+    qint64 m_renderStart;
+    qint64 m_lastSwap;
+    qint64 m_waited;
+    float m_sync;
+    float m_render;
+    FrameSampleRing<4096> m_ring;
+
+    // Handed from the GUI thread to the render thread
+    std::atomic<bool> m_restart;
+    std::atomic<qint64> m_refreshNanoseconds;
+    // Nanoseconds the GUI thread spent blocked in its event loop before the frame being prepared
+    std::atomic<qint64> m_guiBlocked;
+    // Samples the render thread couldn't push because the ring was full
+    std::atomic<int> m_lostSamples;
+
+    // GUI thread
+    qint64 m_blockedSince;
+    qint64 m_blocked;
+    // Samples kept for export, oldest at m_historyStart once full
+    QList<FrameSample> m_history;
+    qsizetype m_historyStart;
+    qreal m_refreshInterval;
+    qreal m_meanInterval;
+    qreal m_p99Interval;
+    qreal m_p99Sync;
+    qreal m_p99Render;
+    int m_droppedFrames;
+    int m_idleFrames;
+    qint64 m_intervalTotal;
+    TimeHistogram m_intervals;
+    TimeHistogram m_syncs;
+    TimeHistogram m_renders;
+    QList<int> m_histogram;
+};
+
+#endif // FRAMEPROFILER_H
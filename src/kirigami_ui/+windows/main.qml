@@ -54,7 +54,9 @@ Kirigami.ApplicationWindow {
     property bool __invertScrollDirection: false
     property bool __noScroll: false
     property bool __telemetry: true
+    property bool recordSessions: false
     property bool forceQtTextRenderer: false
+    property bool frameStats: false
     property bool passiveNotifications: true
     property bool __throttleWheel: true
     property int __wheelThrottleFactor: 8
@@ -99,6 +101,7 @@ Kirigami.ApplicationWindow {
     Settings {
         category: "prompter"
         property alias stepsDefault: root.__iDefault
+        property alias frameStats: root.frameStats
     }
     Settings {
         category: "background"
@@ -109,6 +112,7 @@ Kirigami.ApplicationWindow {
     Settings {
         category: "telemetry"
         property alias enabled: root.__telemetry
+        property alias recordSessions: root.recordSessions
     }
 
     //// Theme management
@@ -165,12 +169,16 @@ Kirigami.ApplicationWindow {
     }
     function loadRemoteControlPage() {
         root.pageStack.layers.clear()
-        root.pageStack.layers.push(remoteControlPageComponent, {})
+        root.pageStack.layers.push(remoteControlPageComponent, {"remote": root.pageStack.currentItem.viewport.remote, "osc": root.pageStack.currentItem.prompter.oscControl, "sync": root.pageStack.currentItem.prompter.prompterSync})
     }
     function loadTelemetryPage() {
         root.pageStack.layers.clear()
         root.pageStack.layers.push(telemetryPageComponent, {})
     }
+    function loadSessionReviewPage() {
+        root.pageStack.layers.clear()
+        root.pageStack.layers.push(sessionReviewPageComponent, {"analytics": root.pageStack.currentItem.sessionAnalytics})
+    }
 
     // Left Global Drawer
     globalDrawer: Kirigami.GlobalDrawer {
@@ -304,6 +312,24 @@ Kirigami.ApplicationWindow {
                     checked: root.__noScroll
                     onTriggered: root.__noScroll = checked
                 }
+                Kirigami.Action {
+                    text: i18nc("Main menu and global menu actions. Scroll at the pace the script is read aloud while prompting.", "Follow speech")
+                    visible: root.pageStack.currentItem.prompter.speechFollower.available
+                    checkable: true
+                    checked: root.pageStack.currentItem.prompter.speechFollow
+                    onTriggered: {
+                        root.pageStack.currentItem.prompter.speechFollow = checked
+                        if (checked && root.pageStack.currentItem.prompter.speechModel.toString() === "")
+                            root.pageStack.currentItem.speechModelDialog.open()
+                    }
+                }
+                Kirigami.Action {
+                    text: i18nc("Main menu and global menu actions. Hold the scroll while the talent isn't speaking.", "Pause when not speaking")
+                    visible: root.pageStack.currentItem.prompter.voiceActivityDetector.available
+                    checkable: true
+                    checked: root.pageStack.currentItem.prompter.voicePause
+                    onTriggered: root.pageStack.currentItem.prompter.voicePause = checked
+                }
             },
             Kirigami.Action {
                 text: i18nc("Main menu actions", "Other &Settings")
@@ -337,6 +363,28 @@ Kirigami.ApplicationWindow {
                         checked: !projectionManager.isEnabled
                         onTriggered: projectionManager.toggle()
                     }
+                    Kirigami.Action {
+                        text: i18nc("Main menu actions. Shows frame timing statistics over the prompter and projections.", "Show frame statistics")
+                        checkable: true
+                        checked: root.frameStats
+                        onTriggered: root.frameStats = checked
+                    }
+                    Kirigami.Action {
+                        text: i18nc("Main menu actions", "Export frame statistics")
+                        enabled: root.frameStats
+                        onTriggered: root.pageStack.currentItem.frameStatsDialog.open()
+                    }
+                    Kirigami.Action {
+                        text: i18nc("Main menu actions. Saves prompter position over time while prompting.", "Record prompting sessions")
+                        checkable: true
+                        checked: root.recordSessions
+                        onTriggered: root.recordSessions = checked
+                    }
+                    Kirigami.Action {
+                        text: i18nc("Main menu actions. Shows reading pace statistics for the last recorded session.", "Review last session")
+                        enabled: root.pageStack.currentItem.sessionAnalytics.ready
+                        onTriggered: root.loadSessionReviewPage()
+                    }
                     Kirigami.Action {
                         text: i18nc("Main menu actions", "Disable timers")
                         enabled: !checked
@@ -511,14 +559,14 @@ Kirigami.ApplicationWindow {
                     globalMenu.close()
                 }
             }
-            // Button {
-            //     text: i18nc("Main menu and global actions.", "Remote")
-            //     flat: true
-            //     onClicked: {
-            //         root.pageStack.layers.push(remoteControlPageComponent, {})
-            //         globalMenu.close()
-            //     }
-            // }
+            Button {
+                text: i18nc("Main menu and global actions.", "Remote")
+                flat: true
+                onClicked: {
+                    root.loadRemoteControlPage()
+                    globalMenu.close()
+                }
+            }
             // Button {
             //     id: themeSwitch
             //     text: i18nc("Main menu and global actions.", "Dark &Mode")
@@ -657,16 +705,29 @@ Kirigami.ApplicationWindow {
         value: root.italic
     }*/
 
+    // Set from requesting a grab until the frame rendered for it is swapped
+    property bool __projectionGrabPending: false
+    Connections {
+        target: projectionManager
+        // Render a frame so projections get their first image even while the window is idle.
+        function onIsEnabledChanged() { if (projectionManager.isEnabled) root.update() }
+    }
+
     onFrameSwapped: {
-        // Thus runs from here because there's no event that occurs on each bit of scroll, and this takes much less CPU than a timer, is more precise and scales better.
-        root.pageStack.currentItem.prompter.markerCompare();
-        // Update Projections
-        if (projectionManager.isEnabled)
+        // Update Projections after every frame the window rendered, so any change to the viewport reaches them, whatever caused it. The window only renders
+        // when something changed. Grabbing renders a frame of its own, which is skipped here, or the window would never go idle.
+        if (root.__projectionGrabPending) {
+            root.__projectionGrabPending = false;
+            return;
+        }
+        if (projectionManager.isEnabled) {
+            root.__projectionGrabPending = true;
             root.pageStack.currentItem.viewport.grabToImage(function(p) {
                 // Recount projections on each for loop iteration to prevent value from going stale because a window was closed from a different thread.
                 for (var i=0; i<projectionManager.projections.count; i++)
                     projectionManager.model.setProperty(i, "p", String(p.url));
             });
+        }
     }
 
     ProjectionsManager {
@@ -700,6 +761,10 @@ Kirigami.ApplicationWindow {
         id: telemetryPageComponent
         TelemetryPage {}
     }
+    Component {
+        id: sessionReviewPageComponent
+        SessionReviewPage {}
+    }
 
     // Dialogues
     Labs.MessageDialog {
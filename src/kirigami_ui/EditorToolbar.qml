@@ -215,9 +215,9 @@ ToolBar {
                 font.family: iconFont.name
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
-                checked: viewport.prompter.document.regularMarker
+                checked: viewport.prompter.document.format.regularMarker
                 checkable: true
-                onClicked: viewport.prompter.document.regularMarker = !viewport.prompter.document.regularMarker
+                onClicked: viewport.prompter.document.regularMarker = !viewport.prompter.document.format.regularMarker
             }
             ToolButton {
                 id: namedBookmarkButton
@@ -227,7 +227,7 @@ ToolBar {
                 font.family: iconFont.name
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
-                checked: viewport.prompter.document.namedMarker
+                checked: viewport.prompter.document.format.namedMarker
                 checkable: true
                 onClicked: namedMarkerConfiguration.open()
             }
@@ -353,17 +353,17 @@ ToolBar {
                 }
                 MenuItem {
                     text: Qt.application.layoutDirection===Qt.LeftToRight ? i18nc("Editor actions. Text alignment.", "&Left") : i18nc("Editor actions. Text alignment.", "&Right")
-                    enabled: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.alignment !== Qt.AlignLeft : viewport.prompter.document.alignment !== Qt.AlignRight
+                    enabled: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.format.alignment !== Qt.AlignLeft : viewport.prompter.document.format.alignment !== Qt.AlignRight
                     onTriggered: viewport.prompter.document.alignment = Qt.AlignLeft
                 }
                 MenuItem {
                     text: i18nc("Editor actions. Text alignment.", "C&enter")
-                    enabled: !(viewport.prompter.document.alignment === Qt.AlignHCenter || (viewport.prompter.document.alignment !== Qt.AlignLeft && viewport.prompter.document.alignment !== Qt.AlignRight/*&& viewport.prompter.document.alignment !== Qt.AlignJustify*/))
+                    enabled: !(viewport.prompter.document.format.alignment === Qt.AlignHCenter || (viewport.prompter.document.format.alignment !== Qt.AlignLeft && viewport.prompter.document.format.alignment !== Qt.AlignRight/*&& viewport.prompter.document.format.alignment !== Qt.AlignJustify*/))
                     onTriggered: viewport.prompter.document.alignment = Qt.AlignHCenter
                 }
                 MenuItem {
                     text: Qt.application.layoutDirection===Qt.LeftToRight ? i18nc("Editor actions. Text alignment.", "&Right") : i18nc("Editor actions. Text alignment.", "&Left")
-                    enabled: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.alignment !== Qt.AlignRight : viewport.prompter.document.alignment !== Qt.AlignLeft
+                    enabled: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.format.alignment !== Qt.AlignRight : viewport.prompter.document.format.alignment !== Qt.AlignLeft
                     onTriggered: viewport.prompter.document.alignment = Qt.AlignRight
                 }
                 //MenuItem {
@@ -381,7 +381,7 @@ ToolBar {
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
                 checkable: true
-                checked: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.alignment === Qt.AlignLeft : viewport.prompter.document.alignment === Qt.AlignRight
+                checked: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.format.alignment === Qt.AlignLeft : viewport.prompter.document.format.alignment === Qt.AlignRight
                 onClicked: textAlignmentMenu.popup(this)
             }
             ToolButton {
@@ -393,7 +393,7 @@ ToolBar {
                 contentItem: Loader { sourceComponent: textComponent }
                 focusPolicy: Qt.TabFocus
                 checkable: true
-                checked: viewport.prompter.document.alignment === Qt.AlignHCenter
+                checked: viewport.prompter.document.format.alignment === Qt.AlignHCenter
                 onClicked: textAlignmentMenu.popup(this)
             }
             ToolButton {
@@ -405,7 +405,7 @@ ToolBar {
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
                 checkable: true
-                checked: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.alignment === Qt.AlignRight : viewport.prompter.document.alignment === Qt.AlignLeft
+                checked: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.format.alignment === Qt.AlignRight : viewport.prompter.document.format.alignment === Qt.AlignLeft
                 onClicked: textAlignmentMenu.popup(this)
             }
             // Justify is proven to make text harder to read for some readers. So I'm commenting out all text justification options from the program. I'm not removing them, only commenting out in case someone needs to re-enable. This article links to various sources that validate my decision: https://kaiweber.wordpress.com/2010/05/31/ragged-right-or-justified-alignment/ - Javier
@@ -436,7 +436,7 @@ ToolBar {
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
                 checkable: true
-                checked: viewport.prompter.document.bold
+                checked: viewport.prompter.document.format.bold
                 onClicked: viewport.prompter.document.bold = checked
             }
             ToolButton {
@@ -447,7 +447,7 @@ ToolBar {
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
                 checkable: true
-                checked: viewport.prompter.document.italic
+                checked: viewport.prompter.document.format.italic
                 onClicked: viewport.prompter.document.italic = checked
             }
             ToolButton {
@@ -458,7 +458,7 @@ ToolBar {
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
                 checkable: true
-                checked: viewport.prompter.document.underline
+                checked: viewport.prompter.document.format.underline
                 onClicked: viewport.prompter.document.underline = checked
             }
             ToolButton {
@@ -469,22 +469,22 @@ ToolBar {
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
                 checkable: true
-                checked: viewport.prompter.document.strike
+                checked: viewport.prompter.document.format.strike
                 onClicked: viewport.prompter.document.strike = checked
             }
             ToolButton {
                 id: verticalAlignmentButton
-                text: viewport.prompter.document.superscript ? "Aᵃ" : "Aₐ"
+                text: viewport.prompter.document.format.superscript ? "Aᵃ" : "Aₐ"
                 contentItem: Loader { sourceComponent: textComponent }
                 font.family: iconFont.name
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
                 checkable: true
-                checked: viewport.prompter.document.subscript || viewport.prompter.document.superscript
+                checked: viewport.prompter.document.format.subscript || viewport.prompter.document.format.superscript
                 onClicked: {
-                    if (viewport.prompter.document.subscript)
+                    if (viewport.prompter.document.format.subscript)
                         viewport.prompter.document.superscript = true
-                    else if (viewport.prompter.document.superscript)
+                    else if (viewport.prompter.document.format.superscript)
                         viewport.prompter.document.superscript = false
                     else
                         viewport.prompter.document.subscript = true
@@ -621,7 +621,7 @@ ToolBar {
                 Rectangle {
                     width: aFontMetrics.width + 3
                     height: 2
-                    color: viewport.prompter.document.textColor
+                    color: viewport.prompter.document.format.textColor
                     parent: textColorButton.contentItem
                     anchors.horizontalCenter: parent.horizontalCenter
                     anchors.baseline: parent.baseline
@@ -659,7 +659,7 @@ ToolBar {
                 Rectangle {
                     width: bFontMetrics.width + 3
                     height: 2
-                    color: viewport.prompter.document.textBackground
+                    color: viewport.prompter.document.format.textBackground
                     parent: textBackgroundButton.contentItem
                     anchors.horizontalCenter: parent.horizontalCenter
                     anchors.baseline: parent.baseline
@@ -687,7 +687,7 @@ ToolBar {
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
                 checkable: true
-                checked: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.alignment === Qt.AlignLeft : viewport.prompter.document.alignment === Qt.AlignRight
+                checked: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.format.alignment === Qt.AlignLeft : viewport.prompter.document.format.alignment === Qt.AlignRight
                 onClicked: {
                     if (Qt.application.layoutDirection===Qt.LeftToRight)
                         viewport.prompter.document.alignment = Qt.AlignLeft
@@ -703,7 +703,7 @@ ToolBar {
                 contentItem: Loader { sourceComponent: textComponent }
                 focusPolicy: Qt.TabFocus
                 checkable: true
-                checked: viewport.prompter.document.alignment === Qt.AlignHCenter
+                checked: viewport.prompter.document.format.alignment === Qt.AlignHCenter
                 onClicked: viewport.prompter.document.alignment = Qt.AlignHCenter
             }
             ToolButton {
@@ -714,7 +714,7 @@ ToolBar {
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
                 checkable: true
-                checked: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.alignment === Qt.AlignRight : viewport.prompter.document.alignment === Qt.AlignLeft
+                checked: Qt.application.layoutDirection===Qt.LeftToRight ? viewport.prompter.document.format.alignment === Qt.AlignRight : viewport.prompter.document.format.alignment === Qt.AlignLeft
                 onClicked: {
                     if (Qt.application.layoutDirection===Qt.LeftToRight)
                         viewport.prompter.document.alignment = Qt.AlignRight
@@ -749,7 +749,7 @@ ToolBar {
                 font.family: iconFont.name
                 font.pointSize: 13
                 focusPolicy: Qt.TabFocus
-                checked: viewport.prompter.document.namedMarker
+                checked: viewport.prompter.document.format.namedMarker
                 checkable: true
                 onClicked: wheelSettings.open()
             }
@@ -825,7 +825,6 @@ ToolBar {
                     if (!(viewport.prompter.__atEnd && value>=0 || viewport.prompter.__atStart && value<0)) {
                         viewport.prompter.__i = value
                         viewport.prompter.__play = true
-                        viewport.prompter.position = viewport.prompter.__destination
                     }
                 }
             }
@@ -1002,7 +1001,7 @@ ToolBar {
                 focusPolicy: Qt.TabFocus
                 onMoved: lineHeightSlider.update()
                 function update() {
-                    viewport.prompter.document.setLineHeight(value)
+                    viewport.prompter.document.lineHeight = value
                 }
             }
         }
@@ -1042,7 +1041,7 @@ ToolBar {
                 focusPolicy: Qt.TabFocus
                 onMoved: update()
                 function update() {
-                    viewport.prompter.document.setParagraphHeight(viewport.prompter.fontSize * value)
+                    viewport.prompter.document.paragraphHeight = viewport.prompter.fontSize * value
                 }
             }
         }
@@ -1156,7 +1155,6 @@ ToolBar {
                 onMoved: {
                     viewport.__baseSpeed = value;
                     viewport.prompter.focus = true;
-                    viewport.prompter.position = viewport.prompter.__destination
                 }
             }
         }
@@ -1197,7 +1195,6 @@ ToolBar {
                 onMoved: {
                     viewport.__curvature=value;
                     viewport.prompter.focus = true;
-                    viewport.prompter.position = viewport.prompter.__destination
                 }
             }
         }
@@ -47,6 +47,10 @@ Kirigami.Page {
     property alias keyConfigurationOverlay: keyConfigurationOverlay
     property alias displaySettings: displaySettings
     property alias markersDrawer: markersDrawer
+    property alias frameStatsDialog: frameStatsDialog
+    property alias speechModelDialog: speechModelDialog
+    property alias wakeupMonitor: wakeupMonitor
+    property alias sessionAnalytics: sessionAnalytics
     property alias countdownConfiguration: countdownConfiguration
     property alias namedMarkerConfiguration: namedMarkerConfiguration
     property alias pointerConfiguration: pointerConfiguration
@@ -191,6 +195,17 @@ Kirigami.Page {
                     }
                 }
             }
+            Kirigami.Action {
+                id: wordHighlightButton
+                text: i18nc("Highlights the word being read at the reading region while prompting", "Highlight current word")
+                checkable: true
+                checked: viewport.overlay.wordHighlight
+                tooltip: i18n("Mark the word at the reading region as it passes, like a karaoke cursor")
+                onTriggered: {
+                    viewport.overlay.wordHighlight = checked
+                    viewport.prompter.restoreFocus()
+                }
+            }
             // Commenting out because there's no way to hide an empty sub-menu in mobile interface and distinction between Normal and Auto is confusing.
             // Kirigami.Action {
             //     id: hideDecorationsButton
@@ -797,6 +812,110 @@ Kirigami.Page {
         y: parent.height
     }
 
+    FrameProfiler {
+        id: frameProfiler
+        window: prompterPage.Window.window
+        name: i18n("Main window")
+        enabled: root.frameStats
+    }
+    WakeupMonitor {
+        id: wakeupMonitor
+        readonly property Window window: prompterPage.Window.window
+        enabled: root.frameStats
+        onWindowChanged: watch(window, i18n("Main window"))
+    }
+    Telemetry {
+        readonly property bool prompting: parseInt(prompter.state) === Prompter.States.Prompting && root.recordSessions && typeof replaySession === "undefined"
+        target: prompter
+        lineWidth: editor.width
+        lineHeight: prompter.fontSize * document.lineHeight / 100
+        onPromptingChanged: prompting ? startSession() : endSession()
+        onRecordingChanged: {
+            if (!recording) {
+                sessionAnalytics.file = sessionFile
+                sessionAnalytics.analyse()
+            }
+        }
+    }
+    SessionAnalytics {
+        id: sessionAnalytics
+        document: prompterPage.document
+        lineWidth: editor.width
+        lineHeight: prompter.fontSize * prompterPage.document.lineHeight / 100
+        readOffset: prompter.topMargin
+    }
+    // Command line replays of recorded sessions, for rendering benchmarks
+    Loader {
+        active: typeof replaySession !== "undefined"
+        sourceComponent: SessionReplay {
+            // Shadow benchmarks replay once with text shadows and once without. The setting is restored afterwards.
+            readonly property bool shadowBenchmark: typeof replayShadowBenchmark !== "undefined" && replayShadowBenchmark
+            property bool shadowsSetting: false
+            target: prompter
+            file: replaySession
+            realtime: replayRealtime
+            report: shadowBenchmark && replayReport ? replayReport.replace(/(\.\w+)?$/, (root.shadows ? "-shadows" : "-no-shadows") + "$1") : replayReport
+            label: shadowBenchmark ? (root.shadows ? "shadows on" : "shadows off") : ""
+            profiler: frameProfiler
+            onRunningChanged: prompter.__replaySteered = running && realtime
+            onVelocityChanged: prompter.__replayVelocity = velocity
+            onFinished: {
+                if (shadowBenchmark && root.shadows) {
+                    root.shadows = false
+                    Qt.callLater(start)
+                    return
+                }
+                if (shadowBenchmark)
+                    root.shadows = shadowsSetting
+                Qt.quit()
+            }
+            Component.onCompleted: {
+                if (shadowBenchmark) {
+                    shadowsSetting = root.shadows
+                    root.shadows = true
+                }
+                // Replay through the same rendering path as a show. Operator controls are held, so only the recording moves it.
+                prompter.__play = false
+                prompter.state = Prompter.States.Prompting
+                prompter.document.parse()
+                prompter.restoreFocus()
+                Qt.callLater(start)
+            }
+        }
+    }
+    // Placed outside of the viewport so it doesn't show on projections, which have their own.
+    FrameStatsOverlay {
+        profiler: frameProfiler
+        monitor: wakeupMonitor
+        visible: root.frameStats
+        anchors.top: parent.top
+        anchors.right: parent.right
+        anchors.margins: 10
+        z: 1
+    }
+
+    Labs.FolderDialog {
+        id: speechModelDialog
+        title: i18nc("Title of dialog for choosing a speech recognition model", "Speech Recognition Model")
+        onAccepted: prompter.speechModel = speechModelDialog.folder
+    }
+    Labs.FileDialog {
+        id: frameStatsDialog
+        defaultSuffix: 'csv'
+        nameFilters: [
+            i18nc("Format name (FORMAT_EXTENSION)", "Comma-separated values (%1)", "CSV") + "(*.csv *.CSV)",
+            i18nc("Format name (FORMAT_EXTENSION)", "JavaScript Object Notation (%1)", "JSON") + "(*.json *.JSON)"
+        ]
+        folder: StandardPaths.writableLocation(StandardPaths.DocumentsLocation)
+        fileMode: Labs.FileDialog.SaveFile
+        onAccepted: {
+            if (frameProfiler.save(frameStatsDialog.file))
+                showPassiveNotification(i18nc("Saved FILE_NAME", "Saved %1", frameStatsDialog.file))
+            else
+                showPassiveNotification(i18n("Could not save frame statistics"))
+        }
+    }
+
     Labs.ColorDialog {
         id: colorDialog
         options: Labs.ColorDialog.ShowAlphaChannel
@@ -951,7 +1070,10 @@ Kirigami.Page {
         repeat: true
         triggeredOnStart: false
         interval: 1000 * (3600 * autoReloadHours.value + 60 * autoReloadMinutes.value + autoReloadSeconds.value)
-        onTriggered: networkDialog.openFromRemote();
+        onTriggered: {
+            wakeupMonitor.wake(i18nc("Subsystem name in frame statistics", "Auto reload"));
+            networkDialog.openFromRemote();
+        }
     }
     Kirigami.OverlaySheet {
         id: networkDialog
@@ -21,14 +21,201 @@
 
 import QtQuick 2.12
 import org.kde.kirigami 2.11 as Kirigami
+import QtQuick.Controls 2.12
+import QtQuick.Layouts 1.12
 
-Kirigami.Page {
+Kirigami.ScrollablePage {
     id: prompterPage
-    
+
+    // Remote.qml instance of the prompter being controlled
+    property var remote
+    property var osc
+    property var sync
+
     title: i18n("Remote Control")
-    
-//    Remote {
-//        id: remote
-//        anchors.fill: parent
-//    }
+
+    background: Rectangle {
+        color: Kirigami.Theme.alternateBackgroundColor
+    }
+
+    GridLayout {
+        width: parent.implicitWidth
+        columns: 2
+        Label {
+            text: i18n("Remote control")
+        }
+        Button {
+            text: checked ? i18n("Enabled") : i18n("Disabled")
+            checkable: true
+            checked: remote.active
+            flat: true
+            onClicked: remote.active = checked
+            Layout.fillWidth: true
+        }
+        Label {
+            text: i18n("Interface")
+        }
+        ComboBox {
+            model: remote.server.availableAddresses()
+            currentIndex: Math.max(0, model.indexOf(remote.address))
+            onActivated: remote.address = currentText
+            Layout.fillWidth: true
+        }
+        Label {
+            text: i18n("Port")
+        }
+        SpinBox {
+            from: 1024
+            to: 65535
+            editable: true
+            value: remote.port
+            textFromValue: function (value) {
+                return value.toString()
+            }
+            onValueModified: remote.port = value
+            Layout.fillWidth: true
+        }
+        Label {
+            text: i18n("Control page")
+        }
+        TextField {
+            readOnly: true
+            selectByMouse: true
+            text: remote.server.listening ? remote.server.url : i18n("Not listening")
+            Layout.fillWidth: true
+        }
+        Label {
+            text: i18n("Connected devices")
+        }
+        Label {
+            text: remote.server.clients
+            Layout.fillWidth: true
+        }
+        Label {
+            text: ""
+        }
+        TextArea {
+            implicitWidth: parent.width-80
+            background: Item{}
+            readOnly: true
+            wrapMode: TextEdit.Wrap
+            text: i18n("Open the control page from a browser on another device to control velocity, pause, and jump between markers and through the script. Anyone who can reach the selected interface can control the prompter, so only listen on networks you trust.")
+        }
+        Label {
+            text: i18n("OSC control")
+        }
+        Button {
+            text: checked ? i18n("Enabled") : i18n("Disabled")
+            checkable: true
+            checked: osc.active
+            flat: true
+            onClicked: osc.active = checked
+            Layout.fillWidth: true
+        }
+        Label {
+            text: i18n("OSC interface")
+        }
+        ComboBox {
+            model: remote.server.availableAddresses()
+            currentIndex: Math.max(0, model.indexOf(osc.address))
+            onActivated: osc.address = currentText
+            Layout.fillWidth: true
+        }
+        Label {
+            text: i18n("OSC port")
+        }
+        SpinBox {
+            from: 1024
+            to: 65535
+            editable: true
+            value: osc.port
+            textFromValue: function (value) {
+                return value.toString()
+            }
+            onValueModified: osc.port = value
+            Layout.fillWidth: true
+        }
+        Label {
+            text: i18n("Last OSC latency")
+        }
+        Label {
+            text: i18n("%1 ms", osc.latency.toFixed(1))
+            Layout.fillWidth: true
+        }
+        Label {
+            text: ""
+        }
+        TextArea {
+            implicitWidth: parent.width-80
+            background: Item{}
+            readOnly: true
+            wrapMode: TextEdit.Wrap
+            text: i18n("Show control software can send OSC messages over UDP named after the keyboard shortcuts, such as /qprompt/increaseVelocity, /qprompt/pause, /qprompt/nextMarker or /qprompt/setVelocity5.")
+        }
+        Label {
+            text: i18n("Multi-prompter sync")
+        }
+        ComboBox {
+            // In the order of PrompterSync.Role
+            model: [i18n("Off"), i18n("Leader"), i18n("Follower")]
+            currentIndex: sync.role
+            onActivated: sync.role = currentIndex
+            Layout.fillWidth: true
+        }
+        Label {
+            text: i18n("Leader address")
+            visible: sync.role === 2
+        }
+        TextField {
+            text: sync.leader
+            placeholderText: "192.168.1.10"
+            selectByMouse: true
+            visible: sync.role === 2
+            onEditingFinished: sync.leader = text
+            Layout.fillWidth: true
+        }
+        Label {
+            text: i18n("Sync port")
+            enabled: sync.role !== 0
+        }
+        SpinBox {
+            from: 1024
+            to: 65535
+            editable: true
+            enabled: sync.role !== 0
+            value: sync.port
+            textFromValue: function (value) {
+                return value.toString()
+            }
+            onValueModified: sync.port = value
+            Layout.fillWidth: true
+        }
+        Label {
+            text: i18n("Sync status")
+            visible: sync.role !== 0
+        }
+        Label {
+            visible: sync.role !== 0
+            text: {
+                if (sync.role === 1)
+                    return i18np("%1 follower", "%1 followers", sync.followers)
+                if (!sync.documentMatches)
+                    return i18n("The leader's script differs from this one")
+                if (sync.following)
+                    return i18n("Following, %1 px off", Math.abs(sync.drift).toFixed(1))
+                return i18n("Waiting for the leader to start prompting")
+            }
+            Layout.fillWidth: true
+        }
+        Label {
+            text: ""
+        }
+        TextArea {
+            implicitWidth: parent.width-80
+            background: Item{}
+            readOnly: true
+            wrapMode: TextEdit.Wrap
+            text: i18n("Followers scroll in lockstep with their leader while both are prompting. Load the same script on every machine and use the same window width, font size and text layout, as positions are shared in pixels.")
+        }
+    }
 }
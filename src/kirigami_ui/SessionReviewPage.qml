@@ -0,0 +1,162 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+import QtQuick 2.12
+import org.kde.kirigami 2.11 as Kirigami
+import QtQuick.Controls 2.12
+import QtQuick.Layouts 1.12
+
+import com.cuperino.qprompt 1.0
+
+// Reading pace statistics for the last recorded prompting session.
+Kirigami.ScrollablePage {
+    id: sessionReviewPage
+    required property SessionAnalytics analytics
+
+    function formatTime(milliseconds) {
+        const seconds = Math.round(milliseconds / 1000)
+        const minutes = Math.floor(seconds / 60)
+        return Math.floor(minutes / 60) + ":" + String(minutes % 60).padStart(2, "0") + ":" + String(seconds % 60).padStart(2, "0")
+    }
+
+    title: i18n("Session Review")
+
+    background: Rectangle {
+        color: Kirigami.Theme.alternateBackgroundColor
+    }
+
+    ColumnLayout {
+        Kirigami.FormLayout {
+            Layout.fillWidth: true
+            Label {
+                Kirigami.FormData.label: i18n("Duration:")
+                text: sessionReviewPage.formatTime(analytics.duration)
+            }
+            Label {
+                Kirigami.FormData.label: i18n("Reading time:")
+                text: sessionReviewPage.formatTime(analytics.readingTime)
+            }
+            Label {
+                Kirigami.FormData.label: i18n("Pauses:")
+                text: i18nc("Number of pauses (total time paused)", "%1 (%2)", analytics.pauses, sessionReviewPage.formatTime(analytics.pausedTime))
+            }
+            Label {
+                Kirigami.FormData.label: i18n("Reading pace:")
+                text: i18nc("Words per minute, plus or minus standard deviation", "%1 ± %2 words per minute", Math.round(analytics.wordsPerMinute), Math.round(analytics.paceDeviation))
+            }
+        }
+        Kirigami.Heading {
+            level: 3
+            text: i18n("Pace over time")
+        }
+        Canvas {
+            id: paceChart
+            Layout.fillWidth: true
+            Layout.preferredHeight: 160
+            onPaint: {
+                const context = getContext("2d")
+                context.reset()
+                const pace = analytics.pace
+                if (pace.length < 2)
+                    return
+                let fastest = 1
+                for (let i = 0; i < pace.length; i++)
+                    fastest = Math.max(fastest, pace[i].y)
+                context.strokeStyle = Kirigami.Theme.highlightColor
+                context.lineWidth = 2
+                context.beginPath()
+                for (let i = 0; i < pace.length; i++) {
+                    const x = i * (width - 1) / (pace.length - 1)
+                    const y = height - 1 - pace[i].y * (height - 2) / fastest
+                    if (i === 0)
+                        context.moveTo(x, y)
+                    else
+                        context.lineTo(x, y)
+                }
+                context.stroke()
+            }
+            onWidthChanged: requestPaint()
+            Connections {
+                target: analytics
+                function onAnalysed() {
+                    paceChart.requestPaint()
+                }
+            }
+        }
+        Kirigami.Heading {
+            level: 3
+            text: i18n("Position over time")
+        }
+        // One bar per row spanning the positions it summarizes, at about one row per two pixels
+        Item {
+            id: positionChart
+            readonly property real scale: height / Math.max(1, sessionModel.maximumPosition - sessionModel.minimumPosition)
+            Layout.fillWidth: true
+            Layout.preferredHeight: 160
+            clip: true
+            SessionModel {
+                id: sessionModel
+                resolution: positionChart.width / 2
+                Component.onCompleted: load(analytics.file)
+            }
+            Connections {
+                target: analytics
+                function onAnalysed() {
+                    sessionModel.load(analytics.file)
+                }
+            }
+            Repeater {
+                model: sessionModel
+                delegate: Rectangle {
+                    required property int time
+                    required property real minimumPosition
+                    required property real maximumPosition
+                    x: time * positionChart.width / Math.max(1, sessionModel.duration)
+                    y: (minimumPosition - sessionModel.minimumPosition) * positionChart.scale
+                    width: 2
+                    height: Math.max(1, (maximumPosition - minimumPosition) * positionChart.scale)
+                    color: Kirigami.Theme.highlightColor
+                }
+            }
+        }
+        Kirigami.Heading {
+            level: 3
+            text: i18n("Sections")
+            visible: analytics.sections.length > 0
+        }
+        GridLayout {
+            columns: 3
+            // Three cells per section: name, time spent and pace
+            Repeater {
+                model: analytics.sections.length * 3
+                delegate: Label {
+                    required property int index
+                    readonly property var section: analytics.sections[Math.floor(index / 3)]
+                    Layout.fillWidth: index % 3 === 0
+                    text: index % 3 === 0 ? (section.name !== "" ? section.name : i18nc("Section of the script before its first marker", "Start"))
+                        : index % 3 === 1 ? sessionReviewPage.formatTime(section.time)
+                        : i18n("%1 words per minute", Math.round(section.wordsPerMinute))
+                }
+            }
+        }
+    }
+}
@@ -60,7 +60,12 @@
 
 #include "../qprompt_version.h"
 #include "abstractunits.hpp"
-//#include "documenthandler.h"
+#include "backgroundimageprovider.h"
+#include "documenthandler.h"
+#include "osccontrol.h"
+#include "promptersync.h"
+#include "remotecontrol.h"
+#include "voiceactivity.h"
 //#include "qmlutil.hpp"
 #include <stdlib.h>
 
@@ -91,6 +96,18 @@ Q_DECL_EXPORT int main(int argc, char *argv[])
         qputenv("LANG", langCode);
     }
 
+    // Replays and benchmarks run headless and without a GPU unless told otherwise.
+    for (int i = 1; i < argc; i++)
+        if (qstrncmp(argv[i], "--replay", 8) == 0 || qstrncmp(argv[i], "--vad-benchmark", 15) == 0
+            || qstrncmp(argv[i], "--remote-benchmark", 18) == 0 || qstrncmp(argv[i], "--osc-benchmark", 15) == 0
+            || qstrncmp(argv[i], "--sync-drift", 12) == 0 || qstrncmp(argv[i], "--cursor-benchmark", 18) == 0) {
+            if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+                qputenv("QT_QPA_PLATFORM", QByteArray("offscreen"));
+            if (qEnvironmentVariableIsEmpty("QT_QUICK_BACKEND"))
+                qputenv("QT_QUICK_BACKEND", QByteArray("software"));
+            break;
+        }
+
     // Instantiate app
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
     QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
@@ -111,7 +128,61 @@ Q_DECL_EXPORT int main(int argc, char *argv[])
                                                << QLatin1String("qgs_ignore"),
                                  QLatin1String("Ignore QSG_RENDER_LOOP environment variable."));
     parser.addOption(qgsIgnore);
+    QCommandLineOption replayOption(QLatin1String("replay"),
+                                    QLatin1String("Replay a recorded prompting session over the source file and report frame statistics."),
+                                    QLatin1String("session"));
+    parser.addOption(replayOption);
+    QCommandLineOption replayRealtimeOption(QLatin1String("replay-realtime"), QLatin1String("Replay at recorded speed instead of as fast as possible."));
+    parser.addOption(replayRealtimeOption);
+    QCommandLineOption replayReportOption(QLatin1String("replay-report"),
+                                          QLatin1String("Save replay frame statistics to a CSV or JSON file."),
+                                          QLatin1String("file"));
+    parser.addOption(replayReportOption);
+    QCommandLineOption replayWithoutTilesOption(QLatin1String("replay-without-tiles"),
+                                                QLatin1String("Replay without rasterizing the prompter into cached tiles, for comparison."));
+    parser.addOption(replayWithoutTilesOption);
+    QCommandLineOption shadowBenchmarkOption(QLatin1String("shadow-benchmark"),
+                                             QLatin1String("Replay twice, with text shadows and without, and report frame statistics for each."));
+    parser.addOption(shadowBenchmarkOption);
+    QCommandLineOption speechSourceOption(QLatin1String("speech-source"),
+                                          QLatin1String("Follow speech from a WAV file instead of the microphone."),
+                                          QLatin1String("file"));
+    parser.addOption(speechSourceOption);
+    QCommandLineOption vadBenchmarkOption(QLatin1String("vad-benchmark"),
+                                          QLatin1String("Run voice activity detection over a WAV file and report its cost."),
+                                          QLatin1String("file"));
+    parser.addOption(vadBenchmarkOption);
+    QCommandLineOption vadLabelsOption(QLatin1String("vad-labels"),
+                                       QLatin1String("Audacity label file marking speech, to measure voice activity detection accuracy against."),
+                                       QLatin1String("file"));
+    parser.addOption(vadLabelsOption);
+    QCommandLineOption remoteBenchmarkOption(QLatin1String("remote-benchmark"),
+                                             QLatin1String("Measure round trip latency to a running instance's remote control server."),
+                                             QLatin1String("url"));
+    parser.addOption(remoteBenchmarkOption);
+    QCommandLineOption oscBenchmarkOption(QLatin1String("osc-benchmark"),
+                                          QLatin1String("Measure input to motion latency of a running instance's OSC control."),
+                                          QLatin1String("host:port"));
+    parser.addOption(oscBenchmarkOption);
+    QCommandLineOption syncDriftOption(QLatin1String("sync-drift"),
+                                       QLatin1String("Measure how far a running leader's followers drift from it over ten seconds."),
+                                       QLatin1String("host:port"));
+    parser.addOption(syncDriftOption);
+    QCommandLineOption cursorBenchmarkOption(QLatin1String("cursor-benchmark"),
+                                             QLatin1String("Walk the cursor through a script and report the cost of tracking its formatting."),
+                                             QLatin1String("file"));
+    parser.addOption(cursorBenchmarkOption);
     parser.process(app);
+    if (parser.isSet(remoteBenchmarkOption))
+        return RemoteControl::benchmark(parser.value(remoteBenchmarkOption), 1000);
+    if (parser.isSet(oscBenchmarkOption))
+        return OscControl::benchmark(parser.value(oscBenchmarkOption), 50);
+    if (parser.isSet(syncDriftOption))
+        return PrompterSync::measureDrift(parser.value(syncDriftOption), 10);
+    if (parser.isSet(cursorBenchmarkOption))
+        return DocumentHandler::cursorBenchmark(parser.value(cursorBenchmarkOption));
+    if (parser.isSet(vadBenchmarkOption))
+        return VoiceActivityDetector::benchmark(parser.value(vadBenchmarkOption), parser.value(vadLabelsOption));
     QStringList positionalArguments = parser.positionalArguments();
     QString fileToOpen = QLatin1String("");
     if (positionalArguments.length())
@@ -251,11 +322,21 @@ Q_DECL_EXPORT int main(int argc, char *argv[])
     // MacOS paths
     engine.addImportPath(QStringLiteral("../build/"));
     engine.addImportPath(QStringLiteral("../Resources/qml/"));
+    engine.addImageProvider(QStringLiteral("background"), new BackgroundImageProvider);
     // Send context data from C++ to QML
     // engine.rootContext()->setContextObject(new KLocalizedContext(&engine));
     engine.rootContext()->setContextProperty(QStringLiteral("aboutData"), QVariant::fromValue(KAboutData::applicationData()));
     if (positionalArguments.length())
         engine.rootContext()->setContextProperty(QStringLiteral("fileToOpen"), fileToOpen);
+    if (parser.isSet(speechSourceOption))
+        engine.rootContext()->setContextProperty(QStringLiteral("speechSource"), parser.value(speechSourceOption));
+    if (parser.isSet(replayOption)) {
+        engine.rootContext()->setContextProperty(QStringLiteral("replaySession"), parser.value(replayOption));
+        engine.rootContext()->setContextProperty(QStringLiteral("replayRealtime"), parser.isSet(replayRealtimeOption));
+        engine.rootContext()->setContextProperty(QStringLiteral("replayReport"), parser.value(replayReportOption));
+        engine.rootContext()->setContextProperty(QStringLiteral("replayTiles"), !parser.isSet(replayWithoutTilesOption));
+        engine.rootContext()->setContextProperty(QStringLiteral("replayShadowBenchmark"), parser.isSet(shadowBenchmarkOption));
+    }
 #if defined(Q_OS_MACOS)
     // engine.addImportPath(QStringLiteral("/opt/homebrew/lib/qml"));
     engine.addImportPath(QStringLiteral("/opt/homebrew/Cellar/kf5-kirigami2/5.95.0/lib/qt6/qml"));
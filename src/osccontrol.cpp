@@ -0,0 +1,511 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+#include "osccontrol.h"
+
+#include <QByteArrayView>
+#include <QElapsedTimer>
+#include <QNetworkDatagram>
+#include <QQuickWindow>
+#include <QTextStream>
+#include <QUdpSocket>
+#include <QtEndian>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// Bundles nested deeper than this are dropped
+static constexpr int MAX_BUNDLE_DEPTH = 8;
+// Actions that haven't moved the prompter by then never will
+static constexpr qint64 MOTION_TIMEOUT = 1000000000;
+static constexpr int MAX_VELOCITY_BINDING = 10;
+
+namespace
+{
+struct Binding {
+    const char *name;
+    OscControl::Action action;
+};
+
+// Named after the key bindings in Prompter.qml
+const Binding BINDINGS[] = {
+    {"increaseVelocity", OscControl::IncreaseVelocity},
+    {"decreaseVelocity", OscControl::DecreaseVelocity},
+    {"stop", OscControl::Stop},
+    {"pause", OscControl::Pause},
+    {"reverse", OscControl::Reverse},
+    {"rewind", OscControl::Rewind},
+    {"fastForward", OscControl::FastForward},
+    {"skipBackwards", OscControl::SkipBackwards},
+    {"skipForward", OscControl::SkipForward},
+    {"previousMarker", OscControl::PreviousMarker},
+    {"nextMarker", OscControl::NextMarker},
+    {"toggle", OscControl::Toggle},
+    {"setVelocity", OscControl::SetVelocity},
+    {"ack", OscControl::Ack},
+};
+
+// OSC strings are null terminated and padded to a multiple of four bytes. Returns the bytes taken, or -1 if malformed.
+qsizetype oscStringSize(const char *data, qsizetype size)
+{
+    const void *end = std::memchr(data, 0, size);
+    if (!end)
+        return -1;
+    const qsizetype padded = ((static_cast<const char *>(end) - data) + 4) & ~qsizetype(3);
+    return padded <= size ? padded : -1;
+}
+
+QByteArray oscString(const QByteArray &string)
+{
+    return QByteArray(string).append(4 - string.size() % 4, '\0');
+}
+
+QByteArray oscMessage(const QByteArray &address)
+{
+    return oscString(address) + oscString(",");
+}
+
+QByteArray oscMessage(const QByteArray &address, qint32 argument)
+{
+    char value[4];
+    qToBigEndian<qint32>(argument, value);
+    return (oscString(address) + oscString(",i")).append(value, 4);
+}
+
+// Bundle to be executed immediately
+QByteArray oscBundle(const QList<QByteArray> &elements)
+{
+    QByteArray bundle = oscString("#bundle");
+    char value[8];
+    qToBigEndian<quint64>(1, value);
+    bundle.append(value, 8);
+    for (const QByteArray &element : elements) {
+        qToBigEndian<qint32>(qint32(element.size()), value);
+        bundle.append(value, 4).append(element);
+    }
+    return bundle;
+}
+}
+
+OscWorker::OscWorker(OscControl *control)
+    : QObject()
+    , m_control(control)
+    , m_socket(nullptr)
+{
+}
+
+void OscWorker::listen(const QString &address, int port)
+{
+    m_socket = new QUdpSocket(this);
+    connect(m_socket, &QUdpSocket::readyRead, this, &OscWorker::read);
+    if (!m_socket->bind(QHostAddress(address), quint16(port)))
+        Q_EMIT error(tr("Cannot listen for OSC on %1:%2").arg(address).arg(port));
+}
+
+void OscWorker::reply(const QHostAddress &host, quint16 port, const QByteArray &packet)
+{
+    if (m_socket)
+        m_socket->writeDatagram(packet, host, port);
+}
+
+void OscWorker::read()
+{
+    while (m_socket->hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_socket->receiveDatagram();
+        const QByteArray data = datagram.data();
+        parse(data.constData(), data.size(), datagram.senderAddress(), quint16(datagram.senderPort()), OscControl::now(), 0);
+    }
+}
+
+void OscWorker::parse(const char *data, qsizetype size, const QHostAddress &sender, quint16 senderPort, qint64 timestamp, int depth)
+{
+    // Bundles are executed on arrival, regardless of their time tag.
+    if (size >= 16 && std::memcmp(data, "#bundle", 8) == 0) {
+        if (depth >= MAX_BUNDLE_DEPTH)
+            return;
+        for (qsizetype offset = 16; offset + 4 <= size;) {
+            const qint32 elementSize = qFromBigEndian<qint32>(data + offset);
+            offset += 4;
+            if (elementSize <= 0 || elementSize > size - offset)
+                return;
+            parse(data + offset, elementSize, sender, senderPort, timestamp, depth + 1);
+            offset += elementSize;
+        }
+        return;
+    }
+
+    const qsizetype addressSize = oscStringSize(data, size);
+    if (addressSize < 0 || data[0] != '/')
+        return;
+    QByteArrayView name(data);
+    if (name.startsWith("/qprompt/"))
+        name = name.sliced(9);
+    else
+        name = name.sliced(1);
+
+    // Only the first argument matters, and only when it's a number or a boolean.
+    bool hasArgument = false;
+    double argument = 0;
+    const qsizetype tagsSize = addressSize < size ? oscStringSize(data + addressSize, size - addressSize) : -1;
+    if (tagsSize > 2 && data[addressSize] == ',') {
+        const char *value = data + addressSize + tagsSize;
+        const qsizetype available = size - addressSize - tagsSize;
+        hasArgument = true;
+        switch (data[addressSize + 1]) {
+        case 'i':
+            hasArgument = available >= 4;
+            argument = hasArgument ? qFromBigEndian<qint32>(value) : 0;
+            break;
+        case 'f':
+            hasArgument = available >= 4;
+            argument = hasArgument ? qFromBigEndian<float>(value) : 0;
+            break;
+        case 'h':
+            hasArgument = available >= 8;
+            argument = hasArgument ? double(qFromBigEndian<qint64>(value)) : 0;
+            break;
+        case 'd':
+            hasArgument = available >= 8;
+            argument = hasArgument ? qFromBigEndian<double>(value) : 0;
+            break;
+        case 'T':
+            argument = 1;
+            break;
+        case 'F':
+            argument = 0;
+            break;
+        default:
+            hasArgument = false;
+            break;
+        }
+        if (!std::isfinite(argument))
+            return;
+    }
+
+    OscControl::Event event{OscControl::Toggle, 1, timestamp, sender, senderPort};
+    const auto binding = std::find_if(std::begin(BINDINGS), std::end(BINDINGS), [name](const Binding &binding) {
+        return name.startsWith(binding.name);
+    });
+    if (binding == std::end(BINDINGS))
+        return;
+    event.action = binding->action;
+    const QByteArrayView suffix = name.sliced(qstrlen(binding->name));
+    if (event.action == OscControl::SetVelocity && !suffix.isEmpty()) {
+        // setVelocity0 to setVelocity10 behave like buttons
+        bool ok = false;
+        event.value = QByteArray(suffix.data(), suffix.size()).toInt(&ok);
+        if (!ok || event.value < 0 || event.value > MAX_VELOCITY_BINDING || (hasArgument && argument == 0))
+            return;
+    }
+    else if (!suffix.isEmpty())
+        return;
+    else if (event.action == OscControl::SetVelocity) {
+        if (!hasArgument)
+            return;
+        // Same range as the setVelocity0 to setVelocity10 buttons and the number keys, so a stray fader value can't send
+        // the prompter flying.
+        event.value = int(std::lround(qBound<double>(-MAX_VELOCITY_BINDING, argument, MAX_VELOCITY_BINDING)));
+    }
+    else if (event.action == OscControl::Ack) {
+        if (!hasArgument)
+            return;
+        event.value = int(std::lround(qBound<double>(-1e6, argument, 1e6)));
+    }
+    else if (event.action == OscControl::Rewind || event.action == OscControl::FastForward)
+        event.value = !hasArgument || argument != 0;
+    else if (hasArgument && argument == 0)
+        return;
+    m_control->post(event);
+}
+
+OscControl::OscControl(QObject *parent)
+    : QObject(parent)
+    , m_active(false)
+    , m_address(QStringLiteral("127.0.0.1"))
+    , m_port(8000)
+    , m_latency(0)
+    , m_worker(nullptr)
+    , m_awaitingMotion(false)
+    , m_actionTimestamp(0)
+    , m_startPosition(0)
+{
+}
+
+OscControl::~OscControl()
+{
+    stop();
+}
+
+bool OscControl::active() const
+{
+    return m_active;
+}
+
+void OscControl::setActive(bool active)
+{
+    if (active == m_active)
+        return;
+
+    m_active = active;
+    if (m_active)
+        start();
+    else
+        stop();
+    Q_EMIT activeChanged();
+}
+
+QString OscControl::address() const
+{
+    return m_address;
+}
+
+void OscControl::setAddress(const QString &address)
+{
+    if (address == m_address)
+        return;
+
+    m_address = address;
+    if (m_active) {
+        stop();
+        start();
+    }
+    Q_EMIT addressChanged();
+}
+
+int OscControl::port() const
+{
+    return m_port;
+}
+
+void OscControl::setPort(int port)
+{
+    if (port == m_port)
+        return;
+
+    m_port = port;
+    if (m_active) {
+        stop();
+        start();
+    }
+    Q_EMIT portChanged();
+}
+
+QQuickItem *OscControl::target() const
+{
+    return m_target;
+}
+
+void OscControl::setTarget(QQuickItem *target)
+{
+    if (target == m_target)
+        return;
+
+    if (m_target)
+        disconnect(m_target, &QQuickItem::windowChanged, this, &OscControl::windowChanged);
+    m_target = target;
+    if (m_target)
+        connect(m_target, &QQuickItem::windowChanged, this, &OscControl::windowChanged);
+    windowChanged(m_target ? m_target->window() : nullptr);
+    Q_EMIT targetChanged();
+}
+
+qreal OscControl::latency() const
+{
+    return m_latency;
+}
+
+// Relative changes add up; absolute ones replace each other. The merged event keeps the earliest timestamp, so latency
+// is measured from the first message of a burst.
+void OscControl::post(const Event &event)
+{
+    QMutexLocker locker(&m_mutex);
+    const bool idle = m_queue.isEmpty();
+    if (!idle) {
+        Event &last = m_queue.last();
+        if (last.action == event.action && (event.action == SetVelocity || event.action == IncreaseVelocity || event.action == DecreaseVelocity)) {
+            last.value = event.action == SetVelocity ? event.value : last.value + event.value;
+            return;
+        }
+    }
+    m_queue.append(event);
+    locker.unlock();
+    if (idle)
+        QMetaObject::invokeMethod(this, &OscControl::drain, Qt::QueuedConnection);
+}
+
+qint64 OscControl::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void OscControl::start()
+{
+    m_worker = new OscWorker(this);
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &OscWorker::error, this, &OscControl::error);
+    m_thread.start(QThread::HighestPriority);
+    QMetaObject::invokeMethod(m_worker, "listen", Qt::QueuedConnection, Q_ARG(QString, m_address), Q_ARG(int, m_port));
+}
+
+void OscControl::stop()
+{
+    if (!m_worker)
+        return;
+
+    m_thread.quit();
+    m_thread.wait();
+    m_worker = nullptr;
+    QMutexLocker locker(&m_mutex);
+    m_queue.clear();
+    m_acks.clear();
+    m_awaitingMotion = false;
+}
+
+void OscControl::drain()
+{
+    QList<Event> events;
+    {
+        QMutexLocker locker(&m_mutex);
+        events.swap(m_queue);
+    }
+    if (m_awaitingMotion && now() - m_actionTimestamp > MOTION_TIMEOUT)
+        m_awaitingMotion = false;
+
+    const qreal position = m_target ? m_target->property("contentY").toReal() : 0;
+    bool acted = false;
+    for (const Event &event : std::as_const(events)) {
+        if (event.action == Ack) {
+            m_acks.append(event);
+            continue;
+        }
+        if (!acted) {
+            acted = true;
+            m_awaitingMotion = true;
+            m_actionTimestamp = event.timestamp;
+            m_startPosition = position;
+        }
+        Q_EMIT triggered(event.action, event.value, event.timestamp);
+    }
+    if (!m_awaitingMotion)
+        acknowledge();
+}
+
+void OscControl::acknowledge()
+{
+    if (!m_worker)
+        return;
+    for (const Event &ack : std::as_const(m_acks)) {
+        const QByteArray packet = oscMessage("/qprompt/ack", ack.value);
+        QMetaObject::invokeMethod(m_worker, [worker = m_worker, ack, packet]() {
+            worker->reply(ack.sender, ack.senderPort, packet);
+        }, Qt::QueuedConnection);
+    }
+    m_acks.clear();
+}
+
+void OscControl::windowChanged(QQuickWindow *window)
+{
+    if (window == m_window)
+        return;
+
+    if (m_window)
+        disconnect(m_window, &QQuickWindow::afterAnimating, this, &OscControl::frame);
+    m_window = window;
+    if (m_window)
+        connect(m_window, &QQuickWindow::afterAnimating, this, &OscControl::frame);
+}
+
+// Latency runs up to the first frame prepared at a new position, which is the earliest it can be shown.
+void OscControl::frame()
+{
+    if (!m_awaitingMotion || !m_target || m_target->property("contentY").toReal() == m_startPosition)
+        return;
+
+    m_awaitingMotion = false;
+    m_latency = (now() - m_actionTimestamp) / 1e6;
+    Q_EMIT latencyChanged();
+    acknowledge();
+}
+
+int OscControl::benchmark(const QString &target, int count)
+{
+    QTextStream out(stdout);
+    const qsizetype separator = target.lastIndexOf(QLatin1Char(':'));
+    const QHostAddress host(separator > 0 ? target.left(separator) : QStringLiteral("127.0.0.1"));
+    const quint16 port = quint16(target.mid(separator + 1).toUInt());
+    if (host.isNull() || !port) {
+        out << "Expected an OSC port to send to, as host:port\n";
+        return 1;
+    }
+    QUdpSocket socket;
+    if (!socket.bind(host.protocol() == QAbstractSocket::IPv6Protocol ? QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4, 0)) {
+        out << "Cannot open a UDP socket: " << socket.errorString() << '\n';
+        return 1;
+    }
+
+    // From sending a velocity change to the acknowledgement that the prompter moved
+    QList<qint64> latencies;
+    latencies.reserve(count);
+    int lost = 0;
+    QElapsedTimer clock;
+    for (qint32 token = 0; token < count; token++) {
+        socket.writeDatagram(oscMessage("/qprompt/stop"), host, port);
+        QThread::msleep(200);
+        while (socket.hasPendingDatagrams())
+            socket.receiveDatagram();
+
+        const QByteArray acknowledgement = oscMessage("/qprompt/ack", token);
+        const QByteArray bundle = oscBundle({oscMessage("/qprompt/setVelocity", 3), acknowledgement});
+        clock.start();
+        socket.writeDatagram(bundle, host, port);
+        bool acknowledged = false;
+        while (!acknowledged && clock.elapsed() < 1000 && socket.waitForReadyRead(int(1000 - clock.elapsed()))) {
+            while (socket.hasPendingDatagrams()) {
+                if (socket.receiveDatagram().data() == acknowledgement && !acknowledged) {
+                    latencies.append(clock.nsecsElapsed());
+                    acknowledged = true;
+                }
+            }
+        }
+        if (!acknowledged)
+            ++lost;
+    }
+    socket.writeDatagram(oscMessage("/qprompt/stop"), host, port);
+
+    if (latencies.isEmpty()) {
+        out << "The prompter never moved. Start prompting past the beginning of the script, with OSC enabled, first.\n";
+        return 1;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const auto milliseconds = [&latencies](qreal quantile) {
+        return latencies.at(qMin(latencies.size() - 1, qsizetype(quantile * latencies.size()))) / 1e6;
+    };
+    out << "Input to motion: " << latencies.size() << " measured, " << lost << " lost\n";
+    out << "Minimum: " << milliseconds(0) << " ms\n";
+    out << "Median: " << milliseconds(0.5) << " ms\n";
+    out << "95th percentile: " << milliseconds(0.95) << " ms\n";
+    out << "Maximum: " << milliseconds(1) << " ms\n";
+    return 0;
+}
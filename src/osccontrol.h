@@ -0,0 +1,176 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef OSCCONTROL_H
+#define OSCCONTROL_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QString>
+#include <QThread>
+
+class OscControl;
+class QQuickWindow;
+class QUdpSocket;
+
+// Reads OSC packets on the OSC thread, so bursts of show control traffic never wait on the GUI.
+class OscWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OscWorker(OscControl *control);
+
+public Q_SLOTS:
+    void listen(const QString &address, int port);
+    void reply(const QHostAddress &host, quint16 port, const QByteArray &packet);
+
+Q_SIGNALS:
+    void error(const QString &message);
+
+private:
+    void read();
+    void parse(const char *data, qsizetype size, const QHostAddress &sender, quint16 senderPort, qint64 timestamp, int depth);
+
+    OscControl *m_control;
+    QUdpSocket *m_socket;
+};
+
+// Maps OSC messages to the actions of the prompter's key bindings. Addresses are the names of the bindings, optionally
+// under /qprompt: /qprompt/increaseVelocity, /qprompt/setVelocity5, /qprompt/nextMarker and so on. /qprompt/setVelocity
+// takes the velocity as its argument, clamped to -10 to 10. Messages whose first argument is zero or false are ignored, as buttons send those
+// when released, except by rewind and fastForward, which last from a nonzero argument to a zero one.
+//
+// Actions reach QML in order through triggered(), along with when they were received. Consecutive velocity changes that
+// arrive before the GUI thread gets to them are coalesced into one. /qprompt/ack with an integer token replies with the
+// same message once the prompter moves in response to the actions before it, for measuring latency end to end.
+class OscControl : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    // Interface to listen on
+    Q_PROPERTY(QString address READ address WRITE setAddress NOTIFY addressChanged)
+    Q_PROPERTY(int port READ port WRITE setPort NOTIFY portChanged)
+    // Flickable whose motion is timed
+    Q_PROPERTY(QQuickItem *target READ target WRITE setTarget NOTIFY targetChanged)
+    // Milliseconds from receiving the last actions that moved the prompter to the frame where it moved
+    Q_PROPERTY(qreal latency READ latency NOTIFY latencyChanged)
+
+public:
+    enum Action {
+        IncreaseVelocity,
+        DecreaseVelocity,
+        SetVelocity,
+        Stop,
+        Pause,
+        Reverse,
+        Rewind,
+        FastForward,
+        SkipBackwards,
+        SkipForward,
+        PreviousMarker,
+        NextMarker,
+        Toggle,
+        Ack,
+    };
+    Q_ENUM(Action)
+
+    struct Event {
+        Action action;
+        // Velocity for SetVelocity, repetitions for IncreaseVelocity and DecreaseVelocity, pressed for Rewind and
+        // FastForward, token for Ack
+        int value;
+        // Nanoseconds on the steady clock
+        qint64 timestamp;
+        QHostAddress sender;
+        quint16 senderPort;
+    };
+
+    explicit OscControl(QObject *parent = nullptr);
+    ~OscControl();
+
+    bool active() const;
+    void setActive(bool active);
+    QString address() const;
+    void setAddress(const QString &address);
+    int port() const;
+    void setPort(int port);
+    QQuickItem *target() const;
+    void setTarget(QQuickItem *target);
+    qreal latency() const;
+
+    // Queues an event for the GUI thread. Called on the OSC thread.
+    void post(const Event &event);
+
+    static qint64 now();
+
+    // Sends velocity changes to an OSC port as a show control system would, acknowledging each, and prints how long the
+    // prompter took to move. Returns a process exit code.
+    static int benchmark(const QString &target, int count);
+
+Q_SIGNALS:
+    void activeChanged();
+    void addressChanged();
+    void portChanged();
+    void targetChanged();
+    void latencyChanged();
+    void error(const QString &message);
+
+    void triggered(OscControl::Action action, int value, qint64 timestamp);
+
+private:
+    void start();
+    void stop();
+    void drain();
+    void acknowledge();
+    void windowChanged(QQuickWindow *window);
+    void frame();
+
+    bool m_active;
+    QString m_address;
+    int m_port;
+    QPointer<QQuickItem> m_target;
+    QPointer<QQuickWindow> m_window;
+    qreal m_latency;
+
+    QThread m_thread;
+    OscWorker *m_worker;
+
+    // Shared with the OSC thread
+    QMutex m_mutex;
+    QList<Event> m_queue;
+
+    // Motion expected from the last actions delivered
+    bool m_awaitingMotion;
+    qint64 m_actionTimestamp;
+    qreal m_startPosition;
+    QList<Event> m_acks;
+};
+
+#endif // OSCCONTROL_H
@@ -52,6 +52,10 @@ MouseArea {
         triggeredOnStart: false
         onTriggered: {
             stop();
+            // Pages other than the prompter, such as settings or session review, may be on top and have no monitor.
+            const monitor = root.pageStack.currentItem ? root.pageStack.currentItem.wakeupMonitor : undefined
+            if (monitor)
+                monitor.wake(i18nc("Subsystem name in frame statistics", "Cursor auto hide"));
             if (root.activeFocusItem === root.pageStack.currentItem.prompter || typeof projectionWindow!=="undefined" && projectionWindow.active)
                 cursorUtil.hideCursor();
         }
@@ -0,0 +1,99 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+import QtQuick 2.12
+import QtQuick.Controls 2.12
+import QtQuick.Layouts 1.12
+
+import com.cuperino.qprompt 1.0
+
+// Shows a FrameProfiler's statistics over the window it measures, and optionally a WakeupMonitor's.
+Rectangle {
+    id: frameStats
+    required property FrameProfiler profiler
+    property WakeupMonitor monitor: null
+    readonly property var bucketNames: [i18nc("Frame statistics histogram bucket", "On time"), i18nc("Frame statistics histogram bucket", "1 missed"), i18nc("Frame statistics histogram bucket", "2 missed"), i18nc("Frame statistics histogram bucket", "3+ missed")]
+    readonly property int largestBucket: Math.max(1, Math.max.apply(null, profiler.histogram))
+
+    width: layout.implicitWidth + 20
+    height: layout.implicitHeight + 20
+    radius: 4
+    color: "#CC000000"
+
+    ColumnLayout {
+        id: layout
+        anchors.centerIn: parent
+        spacing: 2
+        Label {
+            text: frameStats.profiler.name
+            font.bold: true
+            color: "#FFF"
+        }
+        Label {
+            text: i18nc("Frame statistics. %1 is a number of frames, %2 is a number of dropped frames, %3 is a number of frames shown after idle time", "Frames: %1, dropped: %2, idle: %3", frameStats.profiler.frames, frameStats.profiler.droppedFrames, frameStats.profiler.idleFrames)
+            color: "#FFF"
+        }
+        Label {
+            text: i18nc("Frame statistics. Times in milliseconds", "Interval: %1 ms mean, %2 ms p99 (refresh %3 ms)", frameStats.profiler.meanInterval.toFixed(2), frameStats.profiler.p99Interval.toFixed(2), frameStats.profiler.refreshInterval.toFixed(2))
+            color: "#FFF"
+        }
+        Label {
+            text: i18nc("Frame statistics. Times in milliseconds", "Sync: %1 ms p99, render: %2 ms p99", frameStats.profiler.p99Sync.toFixed(2), frameStats.profiler.p99Render.toFixed(2))
+            color: "#FFF"
+        }
+        // Jank histogram, in log scale so rare long frames remain visible next to the on time ones.
+        Repeater {
+            model: frameStats.profiler.histogram
+            RowLayout {
+                required property int index
+                required property int modelData
+                Label {
+                    text: frameStats.bucketNames[index]
+                    color: "#FFF"
+                    Layout.preferredWidth: 80
+                }
+                Rectangle {
+                    color: index ? "#F66" : "#6C6"
+                    implicitHeight: 10
+                    implicitWidth: 1 + 120 * Math.log(1 + modelData) / Math.log(1 + frameStats.largestBucket)
+                }
+                Label {
+                    text: modelData
+                    color: "#FFF"
+                }
+            }
+        }
+        Label {
+            visible: frameStats.monitor !== null
+            text: frameStats.monitor ? i18nc("Frame statistics. %1 is a number of event loop wakeups", "Wakeups: %1/s", frameStats.monitor.wakeups) : ""
+            font.bold: true
+            color: "#FFF"
+        }
+        Repeater {
+            model: frameStats.monitor ? frameStats.monitor.subsystems : []
+            Label {
+                required property var modelData
+                text: i18nc("Frame statistics. %1 is a subsystem name, %2 a number of wakeups, %3 a number of frames", "%1: %2 wakeups/s, %3 frames/s", modelData.name, modelData.wakeups, modelData.frames)
+                color: modelData.wakeups || modelData.frames ? "#FFF" : "#AAA"
+            }
+        }
+    }
+}
@@ -200,6 +200,25 @@ Item {
                 ignored: root.pageStack.currentItem.markersDrawer
                 anchors.fill: parent
             }
+            FrameProfiler {
+                id: frameProfiler
+                window: projectionWindow
+                name: model.name
+                enabled: root.frameStats
+                Component.onCompleted: {
+                    const monitor = root.pageStack.currentItem ? root.pageStack.currentItem.wakeupMonitor : undefined
+                    if (monitor)
+                        monitor.watch(projectionWindow, model.name)
+                }
+            }
+            FrameStatsOverlay {
+                profiler: frameProfiler
+                visible: root.frameStats
+                anchors.top: parent.top
+                anchors.right: parent.right
+                anchors.margins: 10
+                z: 1
+            }
             MouseArea {
                 enabled: true
                 anchors.fill: parent
@@ -110,14 +110,18 @@ Flickable {
     readonly property bool __possitiveDirection: __i>=0
     readonly property real __vw: width / 100 // prompter viewport width hundredth
     readonly property real __evw: editor.width / 100 // editor viewport width hundredth
+    // Width the editor should have at the current size. Long scripts are laid out at it once resizing settles, and are
+    // shown scaled to it until then.
+    readonly property real __targetEditorWidth: prompter.width-2*Math.abs(editor.x)
+    property real __editorWidth: 0
+    readonly property real __layoutPreviewScale: __editorWidth > 0 ? __targetEditorWidth / __editorWidth : 1
+    // Contents don't change while reading, so they may be rendered from caches instead of the live editor.
+    readonly property bool __staticContents: parseInt(state) === Prompter.States.Prompting && !editor.activeFocus && !__atEnd && !loop.running
     readonly property real __speed: __baseSpeed * Math.pow(Math.abs(__i), __curvature)
     readonly property real __velocity: (__possitiveDirection ? 1 : -1) * __speed
+    // Largest velocity step whose speed stays within __speedLimit
+    readonly property int __stepLimit: __baseSpeed > 0 ? Math.floor(Math.pow(__speedLimit / __baseSpeed, 1 / __curvature)) : 0
     readonly property real __relativeSpeed: (__speed * fontSize/2 * ((__vw-__evw/2) / __vw)) // Adjust relative to viewport widths and font size.
-    readonly property real __travelDistance: position + topMargin - __jitterMargin
-    readonly property real __timeToEnd: 2 * (editor.height + fontSize - __travelDistance) / __relativeSpeed // In seconds, used for Timer.
-    readonly property real __timeToArival: __i ? ((__possitiveDirection ? __timeToEnd : 2 * __travelDistance / __relativeSpeed)) * 1000 : 0 // In milliseconds, used for animation.
-    property real timeToArival: __timeToArival
-    readonly property int __destination: __i  ? (__possitiveDirection ? editor.height+fontSize-__jitterMargin : __jitterMargin)-topMargin : position
     // At start and at end rules
     readonly property bool __atStart: position<=__jitterMargin-topMargin+2
     readonly property bool __atEnd: position>=editor.height-topMargin+fontSize+__jitterMargin-2
@@ -152,7 +156,20 @@ Flickable {
     property bool __invertScrollDirection: root.__invertScrollDirection
     property bool __noScroll: root.__noScroll
     property bool wysiwyg: true
+    property int deferredLayoutThreshold: 1000
+    property bool speechFollow: false
+    property url speechModel
+    property bool voicePause: false
+    property alias speechFollower: speechFollower
+    property alias voiceActivityDetector: voiceActivityDetector
+    property alias oscControl: oscControl
+    property alias prompterSync: prompterSync
     property bool __play: true
+    // Scrolling is held while the talent is silent. Kept apart from __play, which only the operator controls.
+    readonly property bool __voiceHold: voiceActivityDetector.active && !voiceActivityDetector.speaking
+    // Recorded velocity steering the prompter while a session is replayed in real time
+    property bool __replaySteered: false
+    property real __replayVelocity: 0
     property int __i: __iDefault
     property int __iBackup: 0
     property int __iDefault:  root.__iDefault
@@ -182,6 +199,8 @@ Flickable {
     Settings {
         category: "editor"
         property alias autoReload: document.autoReload
+        property alias undoMemoryBudget: document.undoMemoryBudget
+        property alias deferredLayoutThreshold: prompter.deferredLayoutThreshold
     }
     Settings {
         id: keys
@@ -238,6 +257,24 @@ Flickable {
         property int setVelocity10Modifiers: Qt.NoModifier
         property int setVelocityModifier: Qt.AltModifier
     }
+    Settings {
+        category: "speech"
+        property alias follow: prompter.speechFollow
+        property alias model: prompter.speechModel
+        property alias autoPause: prompter.voicePause
+    }
+    Settings {
+        category: "osc"
+        property alias enabled: oscControl.active
+        property alias address: oscControl.address
+        property alias port: oscControl.port
+    }
+    Settings {
+        category: "sync"
+        property alias role: prompterSync.role
+        property alias leader: prompterSync.leader
+        property alias port: prompterSync.port
+    }
     Settings {
         category: "atEnd"
         property alias atEndAction: prompter.atEndAction
@@ -254,6 +291,8 @@ Flickable {
     }
 
     property int q: 0
+    // Only movement can carry the read region past a marker, so compare when the prompter moves rather than on every frame.
+    onContentYChanged: markerCompare()
     function markerCompare() {
         // Check that state is not prompting and editor isn't active.
         if (parseInt(state)===Prompter.States.Prompting && !editor.activeFocus) {
@@ -338,7 +377,6 @@ Flickable {
             if (this.__play)
                 this.__i++
             this.__play = true
-            this.position = this.__destination
             //if (root.passiveNotifications)
             //    showPassiveNotification(i18n("Increase Velocity"));
         }
@@ -353,7 +391,6 @@ Flickable {
             if (this.__play)
                 this.__i--
             this.__play = true
-            this.position = this.__destination
             //if (root.passiveNotifications)
             //    showPassiveNotification(i18n("Decrease Velocity"));
         }
@@ -365,15 +402,69 @@ Flickable {
         if (this.__atStart)
             this.__i=0
         else {
-            this.__i = velocity - 1
-            this.position = this.__destination
-            this.__i = velocity
+            this.__i = Math.max(-this.__stepLimit, Math.min(this.__stepLimit, velocity))
             this.__play = true
-            this.position = this.__destination
         }
         prompter.restoreFocus()
     }
 
+    function stop() {
+        prompter.__i = 0;
+        prompter.__iBackup = 0;
+        prompter.position = prompter.position
+    }
+
+    function togglePause() {
+        if (prompter.__play) {
+            prompter.__play = false
+            prompter.position = prompter.position
+        }
+        else
+            prompter.__play = true
+    }
+
+    function reverse() {
+        prompter.__i = -prompter.__i;
+    }
+
+    // Rewind and fast forward last until unwound
+    function wind(velocity) {
+        if (!prompter.winding) {
+            prompter.__iBackup = prompter.__i;
+            prompter.winding = true;
+            prompter.__i = velocity;
+        }
+    }
+
+    function unwind() {
+        if (prompter.winding) {
+            prompter.__i = prompter.__iBackup;
+            prompter.winding = false;
+        }
+    }
+
+    function skipBackwards() {
+        if (!prompter.__atStart) {
+            if (prompter.__play && prompter.__i!==0)
+                prompter.__iBackup = prompter.__i
+            prompter.__i=0;
+            prompter.position = prompter.position
+            scrollBar.decrease()
+            prompter.__i=prompter.__iBackup
+        }
+    }
+
+    function skipForward() {
+        if (!prompter.__atEnd) {
+            if (prompter.__play && prompter.__i!==0)
+                prompter.__iBackup = prompter.__i
+            prompter.__i=0;
+            prompter.position = prompter.position
+            scrollBar.increase()
+            prompter.__i=prompter.__iBackup
+        }
+    }
+
     function editMarker(cursorPosition, fragmentLength) {
         goTo(cursorPosition);
         editor.select(cursorPosition, fragmentLength);
@@ -389,8 +480,6 @@ Flickable {
         editor.cursorPosition = cursorPosition
         prompter.position = editor.cursorRectangle.y - (overlay.__readRegionPlacement*(overlay.height-overlay.readRegionHeight)+overlay.readRegionHeight/2) + 1
         __i = i;
-        if (prompter.__play && i!==0)
-            prompter.position = prompter.__destination
     }
 
     function goToPreviousMarker() {
@@ -402,8 +491,6 @@ Flickable {
         editor.cursorPosition = document.previousMarker(editor.cursorPosition).position
         prompter.position = editor.cursorRectangle.y - (overlay.__readRegionPlacement*(overlay.height-overlay.readRegionHeight)+overlay.readRegionHeight/2) + 1
         __i = i
-        if (prompter.__play && i!==0)
-            prompter.position = prompter.__destination
     }
 
     function goToNextMarker() {
@@ -415,15 +502,38 @@ Flickable {
         editor.cursorPosition = document.nextMarker(editor.cursorPosition).position
         prompter.position = editor.cursorRectangle.y - (overlay.__readRegionPlacement*(overlay.height-overlay.readRegionHeight)+overlay.readRegionHeight/2) + 1
         __i = i
-        if (prompter.__play && i!==0)
-            prompter.position = prompter.__destination
     }
 
     function setContentWidth() {
         //contentsPlacement = Math.abs(editor.x)/prompter.width
         contentsPlacement = (Math.abs(editor.x)-fontSize/2)/(prompter.width-fontSize)
         const offset = 0
-        positionHandler.placement = (2 * (editor.x - 2 * offset) + editor.width - positionHandler.width) / positionHandler.width
+        positionHandler.placement = (2 * (editor.x - 2 * offset) + __targetEditorWidth - positionHandler.width) / positionHandler.width
+        updateEditorWidth()
+    }
+
+    // Lays text out at the target width, keeping whatever is at the read region in place while it reflows.
+    function updateEditorWidth() {
+        relayoutTimer.stop()
+        if (__editorWidth === __targetEditorWidth)
+            return
+        const readRegionOffset = overlay.__readRegionPlacement*(overlay.height-overlay.readRegionHeight)+overlay.readRegionHeight/2
+        const anchor = editor.positionAt(editor.leftPadding, position+readRegionOffset)
+        const offset = position+readRegionOffset - editor.positionToRectangle(anchor).y
+        __editorWidth = __targetEditorWidth
+        position = editor.positionToRectangle(anchor).y + offset - readRegionOffset
+    }
+    on__TargetEditorWidthChanged: {
+        if (!__editorWidth || editor.lineCount < deferredLayoutThreshold)
+            updateEditorWidth()
+        else
+            relayoutTimer.restart()
+    }
+    Component.onCompleted: __editorWidth = __targetEditorWidth
+    Timer {
+        id: relayoutTimer
+        interval: 250
+        onTriggered: prompter.updateEditorWidth()
     }
 
     function ensureVisible(r)
@@ -499,7 +609,8 @@ Flickable {
     // It also provides a workaround to the lack of background in the global toolbar when using transparent backgrounds in Material theme.
     clip: true
     transform: __flips
-    layer.enabled: root.shadows
+    // Tiles carry their own pre-rendered shadow while prompting.
+    layer.enabled: root.shadows && !tiles.active
     layer.effect: ShaderEffect {
         id: shadow
         readonly property variant source: prompterShadowSource
@@ -507,12 +618,16 @@ Flickable {
         readonly property point offset: Qt.point(prompter.fontSize / 13 * Math.cos(angle), prompter.fontSize / 13 * Math.sin(angle))
         readonly property size delta: Qt.size(offset.x / width, offset.y / height)
         readonly property real darkness: 0.5 // + ((prompter.fontSize / (prompter.fontSize + 1)) / 2)
+        // Blur passes run at half resolution. The result is blurry by design, so the difference isn't visible, while
+        // each pass touches a quarter of the pixels.
         readonly property ShaderEffectSource shadow: ShaderEffectSource {
+            textureSize: Qt.size(Math.ceil(shadow.source.sourceItem.width / 2), Math.ceil(shadow.source.sourceItem.height / 2))
             sourceItem: ShaderEffect {
                 width: shadow.source.sourceItem.width
                 height: shadow.source.sourceItem.height
                 readonly property size delta: Qt.size(0.0, 4.0 / height)
                 readonly property ShaderEffectSource source: ShaderEffectSource {
+                    textureSize: Qt.size(Math.ceil(shadow.source.sourceItem.width / 2), Math.ceil(shadow.source.sourceItem.height / 2))
                     sourceItem: ShaderEffect {
                         width: shadow.source.sourceItem.width
                         height: shadow.source.sourceItem.height
@@ -547,12 +662,8 @@ Flickable {
         //console.log("Movement ended")
         //console.log(__iBackup, __i, position)
         __i = __iBackup
-        if (parseInt(prompter.state)===Prompter.States.Prompting) {
+        if (parseInt(prompter.state)===Prompter.States.Prompting)
             __iBackup = 0
-            position = __destination
-        }
-        else
-           position = position
     }
     boundsBehavior: Flickable.DragOverBounds
     flickableDirection: Flickable.VerticalFlick
@@ -592,31 +703,135 @@ Flickable {
     //    height: 2
     //    color: "red"
     //}
-    Behavior on position {
+    // Velocity is integrated once per frame, so speed, resize, and font changes apply without restarting any animation.
+    ScrollEngine {
         id: motion
-        enabled: true
-        animation: NumberAnimation {
-            id: animationX
-            duration: timeToArival
-            easing.type: Easing.Linear
-            onRunningChanged: {
-                if (!animationX.running && prompter.__i && prompter.__play) {
-                    __i = 0
-                    root.alert(0)
-                    if (parseInt(prompter.state) === Prompter.States.Prompting && !prompter.__atStart) {
-                        //if (root.passiveNotifications)
-                        //    showPassiveNotification(i18n("End reached"));
-                        switch (prompter.atEndAction) {
-                            case Prompter.AtEndActions.Exit:
-                                return prompter.toggle();
-                            case Prompter.AtEndActions.Loop:
-                                loop.start()
-                        }
+        target: prompter
+        running: parseInt(prompter.state) === Prompter.States.Prompting && (prompter.__play && !prompter.__voiceHold && (prompter.__i !== 0 || speechFollower.active) || prompterSync.following || prompter.__replaySteered)
+        step: prompter.__i
+        steered: speechFollower.active || prompterSync.following || prompter.__replaySteered
+        steeredVelocity: prompter.__replaySteered ? prompter.__replayVelocity : prompterSync.following ? prompterSync.velocity : speechFollower.velocity
+        baseSpeed: prompter.__baseSpeed
+        curvature: prompter.__curvature
+        // Half of __relativeSpeed's per unit scale, which is how far the prompter travels per second.
+        speedScale: prompter.fontSize / 4 * ((prompter.__vw - prompter.__evw / 2) / prompter.__vw)
+        minimum: -prompter.topMargin
+        maximum: editor.height + prompter.fontSize - prompter.topMargin
+        onBoundaryReached: {
+            if (prompter.__i && prompter.__play) {
+                __i = 0
+                root.alert(0)
+                if (parseInt(prompter.state) === Prompter.States.Prompting && !prompter.__atStart) {
+                    //if (root.passiveNotifications)
+                    //    showPassiveNotification(i18n("End reached"));
+                    switch (prompter.atEndAction) {
+                        case Prompter.AtEndActions.Exit:
+                            return prompter.toggle();
+                        case Prompter.AtEndActions.Loop:
+                            loop.start()
                     }
                 }
             }
         }
     }
+    // Sets the pace while following speech, in place of the velocity steps.
+    SpeechFollower {
+        id: speechFollower
+        document: prompter.document
+        target: prompter
+        readOffset: prompter.topMargin
+        lineHeight: prompter.fontSize * prompter.document.lineHeight / 100
+        model: prompter.speechModel
+        source: typeof speechSource !== "undefined" ? speechSource : ""
+        active: prompter.speechFollow && parseInt(prompter.state) === Prompter.States.Prompting
+        onError: function (message) {
+            showPassiveNotification(message)
+        }
+    }
+    // Holds the scroll while the talent isn't speaking. Following speech already does so on its own.
+    VoiceActivityDetector {
+        id: voiceActivityDetector
+        source: typeof speechSource !== "undefined" ? speechSource : ""
+        active: prompter.voicePause && !prompter.speechFollow && parseInt(prompter.state) === Prompter.States.Prompting
+        onError: function (message) {
+            showPassiveNotification(message)
+        }
+    }
+    // Scrolls in lockstep with prompters on other machines. Followers are steered by their leader's motion.
+    PrompterSync {
+        id: prompterSync
+        document: prompter.document
+        target: prompter
+        readOffset: prompter.topMargin
+        prompting: parseInt(prompter.state) === Prompter.States.Prompting
+        leaderVelocity: motion.running ? motion.velocity : 0
+        onError: function (message) {
+            showPassiveNotification(message)
+        }
+    }
+    // Show control input. Actions behave as their key bindings do.
+    OscControl {
+        id: oscControl
+        target: prompter
+        onTriggered: function (action, value) {
+            const prompting = parseInt(prompter.state) === Prompter.States.Prompting
+            switch (action) {
+            case OscControl.IncreaseVelocity:
+                for (let i = 0; prompting && i < value; i++)
+                    prompter.increaseVelocity({})
+                break
+            case OscControl.DecreaseVelocity:
+                for (let i = 0; prompting && i < value; i++)
+                    prompter.decreaseVelocity({})
+                break
+            case OscControl.SetVelocity:
+                if (prompting)
+                    prompter.setVelocity(value, null)
+                break
+            case OscControl.Stop:
+                if (prompting)
+                    prompter.stop()
+                else if (parseInt(prompter.state) !== Prompter.States.Editing)
+                    prompter.toggle()
+                break
+            case OscControl.Pause:
+                if (prompting)
+                    prompter.togglePause()
+                else if (parseInt(prompter.state) !== Prompter.States.Editing)
+                    prompter.toggle()
+                break
+            case OscControl.Reverse:
+                if (prompting)
+                    prompter.reverse()
+                break
+            case OscControl.Rewind:
+            case OscControl.FastForward:
+                if (!value)
+                    prompter.unwind()
+                else if (prompting)
+                    prompter.wind(action === OscControl.Rewind ? -prompter.fastSpeed : prompter.fastSpeed)
+                break
+            case OscControl.SkipBackwards:
+                prompter.skipBackwards()
+                break
+            case OscControl.SkipForward:
+                prompter.skipForward()
+                break
+            case OscControl.PreviousMarker:
+                prompter.goToPreviousMarker()
+                break
+            case OscControl.NextMarker:
+                prompter.goToNextMarker()
+                break
+            case OscControl.Toggle:
+                prompter.toggle()
+                break
+            }
+        }
+        onError: function (message) {
+            showPassiveNotification(message)
+        }
+    }
     SequentialAnimation {
         id: loop
 //        PropertyAction {
@@ -679,7 +894,7 @@ Flickable {
         // Force positionHandler's position to reset to center on resize.
         //x: (editor.x - (width - editor.width)/2) / 2
         property real placement: 0
-        x: (editor.x - (width - editor.width + placement * width)/2) / 2
+        x: (editor.x - (width - prompter.__targetEditorWidth + placement * width)/2) / 2
 
         // Keep dimensions at their right size, but adjustable
         width: parent.width
@@ -688,6 +903,13 @@ Flickable {
         Item {
             id: flickableContent
             anchors.fill: parent
+            // Approximates the layout at the target width until text is laid out at it, scaling around the read region.
+            transform: Scale {
+                origin.x: editor.x
+                origin.y: prompter.__layoutPreviewScale !== 1 ? prompter.position + overlay.__readRegionPlacement*(overlay.height-overlay.readRegionHeight)+overlay.readRegionHeight/2 : 0
+                xScale: prompter.__layoutPreviewScale
+                yScale: prompter.__layoutPreviewScale
+            }
 
             TextArea {
                 id: editor
@@ -714,7 +936,7 @@ Flickable {
                 x: fontSize/2 + contentsPlacement*(prompter.width-fontSize)
 
                 // Width drag controls
-                width: prompter.width-2*Math.abs(x)
+                width: prompter.__editorWidth
 
                 // Start with the editor in focus
                 focus: !root.__isMobile
@@ -1110,7 +1332,7 @@ Flickable {
                         anchors {top: parent.top; bottom: parent.bottom; horizontalCenter: parent.horizontalCenter}
                     }
                     //onPressed: editor.invertDrag = true
-                    onReleased: positionHandler.placement = (2 * (editor.x - 2 * positionHandler.x) + editor.width - positionHandler.width) / positionHandler.width
+                    onReleased: positionHandler.placement = (2 * (editor.x - 2 * positionHandler.x) + prompter.__targetEditorWidth - positionHandler.width) / positionHandler.width
                 }
 
                 Keys.onPressed: function(event) {
@@ -1168,16 +1390,16 @@ Flickable {
                     if (event.modifiers & Qt.ControlModifier)
                         switch (event.key) {
                             case Qt.Key_B:
-                                document.bold = !document.bold;
+                                document.bold = !document.format.bold;
                                 return;
                             case Qt.Key_U:
-                                document.underline = !document.underline;
+                                document.underline = !document.format.underline;
                                 return;
                             case Qt.Key_I:
-                                document.italic = !document.italic;
+                                document.italic = !document.format.italic;
                                 return;
                             case Qt.Key_T:
-                                document.strike = !document.strike;
+                                document.strike = !document.format.strike;
                                 return;
                             case Qt.Key_L:
                                 document.alignment = Qt.AlignLeft;
@@ -1196,7 +1418,7 @@ Flickable {
                                 if (event.modifiers & Qt.ShiftModifier)
                                     namedMarkerConfiguration.open();
                                 else
-                                    document.regularMarker = !document.regularMarker;
+                                    document.regularMarker = !document.format.regularMarker;
                                 return;
                             // Forward these other keys to prompter.
                             case Qt.Key_F:
@@ -1219,6 +1441,58 @@ Flickable {
                         }
                 }
             }
+
+            PromptingTiles {
+                id: tiles
+                source: editor
+                // Replays may leave tiles out, to measure what they save
+                active: prompter.__staticContents && (typeof replayTiles === "undefined" || replayTiles)
+                shadows: root.shadows
+                shadowOffset: Qt.point(prompter.fontSize / 13 * Math.cos(180), prompter.fontSize / 13 * Math.sin(180))
+                x: -positionHandler.x
+                width: prompter.width
+                height: editor.height + prompter.bottomMargin
+                viewportY: prompter.contentY
+                viewportHeight: prompter.height
+            }
+        }
+    }
+
+    // Renders runs of the script's text covering every glyph it uses in each style once, clipped out of sight, so shaping,
+    // rasterizing and uploading them to the glyph cache happens after loading instead of during the first scroll.
+    Item {
+        id: glyphWarmupItem
+        width: 1
+        height: 1
+        clip: true
+        Repeater {
+            model: document.glyphWarmup
+            Text {
+                required property var modelData
+                text: modelData.text
+                textFormat: Text.PlainText
+                font.family: modelData.family
+                font.bold: modelData.bold
+                font.italic: modelData.italic
+                font.pixelSize: editor.font.pixelSize
+                font.hintingPreference: editor.font.hintingPreference
+                renderType: editor.renderType
+            }
+        }
+        // Glyphs stay cached after the first frame that shows them, so the text is dropped soon after.
+        Timer {
+            running: document.glyphWarmup.length > 0
+            interval: 2000
+            onTriggered: document.clearGlyphWarmup()
+        }
+        Timer {
+            id: glyphWarmupTimer
+            interval: 1000
+            onTriggered: document.warmUpGlyphs(editor.font.pixelSize)
+        }
+        Connections {
+            target: editor
+            function onFontChanged() { glyphWarmupTimer.restart(); }
         }
     }
 
@@ -1334,11 +1608,18 @@ Flickable {
             editor.textFormat = format
             editorToolbar.lineHeightSlider.update()
             editorToolbar.paragraphSpacingSlider.update()
+            // Apply right away so that loading doesn't leave spacing changes in the undo history.
+            document.applyTypography()
+            glyphWarmupTimer.restart()
         }
         onError: function (message) {
             errorDialog.text = message
             errorDialog.visible = true
         }
+        onPastingChanged: {
+            if (pasting)
+                showPassiveNotification(i18n("Pasting…"))
+        }
 
         Component.onCompleted: {
             if (prompter.performFileOperations) {
@@ -1552,23 +1833,14 @@ Flickable {
             }
             else if (event.key===keys.stop && event.modifiers===keys.stopModifiers) {
                 // Stop
-                prompter.__i = 0;
-                prompter.__iBackup = 0;
-                prompter.position = prompter.position
+                prompter.stop()
                 return
             }
             else if (event.key===keys.pause && event.modifiers===keys.pauseModifiers || event.key===Qt.Key_SysReq || event.key===Qt.Key_Play || event.key===Qt.Key_Pause) {
                 // Pause
                 //if (root.passiveNotifications)
                 //    showPassiveNotification((i18n("Toggle Playback"));
-                if (prompter.__play) {
-                    prompter.__play = false
-                    prompter.position = prompter.position
-                }
-                else {
-                    prompter.__play = true
-                    prompter.position = prompter.__destination
-                }
+                prompter.togglePause()
                 return
             }
             else if (event.key===keys.setVelocity0 && (event.modifiers===keys.setVelocity0Modifiers ||
@@ -1658,33 +1930,22 @@ Flickable {
             }
             else if (event.key===keys.reverse && event.modifiers===keys.reverseModifiers) {
                 // Reverse
-                __i = -__i;
-                position = __destination
+                prompter.reverse()
                 return
             }
             else if (event.key===keys.rewind && event.modifiers===keys.rewindModifiers) {
                 // Rewind
                 if (!winding) {
-                    __iBackup = __i;
-                    winding = true;
                     keyBeingPressed = event.key;
-                    __i = 0;
-                    position = __destination
-                    __i = -fastSpeed;
-                    position = __destination
+                    prompter.wind(-fastSpeed)
                 }
                 return
             }
             else if (event.key===keys.fastForward && event.modifiers===keys.fastForwardModifiers) {
                 // Fast Forward
                 if (!winding) {
-                    __iBackup = __i;
-                    winding = true;
                     keyBeingPressed = event.key;
-                    __i = 0;
-                    position = __destination
-                    __i = fastSpeed;
-                    position = __destination
+                    prompter.wind(fastSpeed)
                 }
                 return
             }
@@ -1729,36 +1990,14 @@ Flickable {
             /* if (event.modifiers & Qt.ControlModifier)
                 prompter.goToPreviousMarker();
             else */
-            if (!this.__atStart) {
-                if (prompter.__play && __i!==0)
-                    __iBackup = __i
-                __i=0;
-                prompter.position = prompter.position
-                scrollBar.decrease()
-                __i=__iBackup
-                if (prompter.__play)
-                    prompter.position = __destination
-                else
-                    prompter.position = prompter.position
-            }
+            prompter.skipBackwards()
         }
         else if (event.key===keys.skipForward && event.modifiers===keys.skipForwardModifiers) {
             // Move Forward
             /* if (event.modifiers & Qt.ControlModifier)
                 prompter.goToNextMarker();
             else */
-            if (!this.__atEnd) {
-                if (prompter.__play && __i!==0)
-                    __iBackup = __i
-                __i=0;
-                prompter.position = prompter.position
-                scrollBar.increase()
-                __i=__iBackup
-                if (prompter.__play)
-                    prompter.position = __destination
-                else
-                    prompter.position = prompter.position
-            }
+            prompter.skipForward()
         }
         else if (event.key===keys.previousMarker && event.modifiers===keys.previousMarkerModifiers)
             prompter.goToPreviousMarker();
@@ -1771,11 +2010,7 @@ Flickable {
         if (parseInt(prompter.state)===Prompter.States.Prompting) {
             if (winding && (event.key===keyBeingPressed && (event.key===keys.rewind || event.key===keys.fastForward))) {
                 // Let go
-                __i = 0;
-                position = __destination
-                __i = __iBackup;
-                position = __destination
-                winding = false;
+                prompter.unwind()
             }
             return
         }
@@ -1819,7 +2054,6 @@ Flickable {
                 __i: 0
                 __play: false
                 position: position
-                timeToArival: 0
             }
             PropertyChanges {
                 target: viewport.mouse
@@ -1851,7 +2085,6 @@ Flickable {
                 z: 1
                 __iBackup: 0
                 position: position
-                timeToArival: 0
                 focus: true
             }
             PropertyChanges {
@@ -1899,7 +2132,6 @@ Flickable {
                 z: 1
                 __iBackup: 0
                 position: position
-                timeToArival: 0
                 focus: true
             }
             PropertyChanges {
@@ -1944,10 +2176,8 @@ Flickable {
                 z: 1
                 __i: __iDefault
                 __iBackup: 0
-                position: prompter.__destination
                 focus: true
                 __play: true
-                timeToArival: __timeToArival
             }
             PropertyChanges {
                 target: editor
@@ -1988,7 +2218,6 @@ Flickable {
         setCursorAtCurrentPosition()
         var pos = prompter.position
         position = pos
-        timer.updateTimer()
     }
 
     transitions: [
@@ -1999,7 +2228,6 @@ Flickable {
                 script: {
                     // Auto frame to current line
                     position = editor.cursorRectangle.y - (overlay.__readRegionPlacement*(overlay.height-overlay.readRegionHeight)+overlay.readRegionHeight/2) + 1
-                    //timer.stopTimer()
                 }
             }
         },
@@ -2008,20 +2236,11 @@ Flickable {
             ScriptAction  {
                 // Jump into position
                 script: {
-                    timer.startTimer();
                     cursorAutoHide.hide();
                     cursorAutoHide.restart();
                 }
             }
         },
-        Transition {
-            to: Prompter.States.Editing
-            ScriptAction  {
-                script: {
-                    timer.stopTimer()
-                }
-            }
-        },
         Transition {
             from: Prompter.States.Prompting
             to: Prompter.States.Editing
@@ -59,7 +59,7 @@ Rectangle {
     }
     function setBackgroundImage(file) {
         if (file) {
-            backgroundImage.source = file
+            backgroundImage.file = file
         }
     }
 
@@ -72,7 +72,7 @@ Rectangle {
         // property color color: "#303030" // "#181818"
         //property color color: Qt.rgba(Kirigami.Theme.backgroundColor.r, Kirigami.Theme.backgroundColor.g, Kirigami.Theme.backgroundColor.b, 1)
         property alias color: prompterBackground.backgroundColor
-        property alias image: backgroundImage.source
+        property alias image: backgroundImage.file
         category: "background"
     }
 
@@ -80,11 +80,24 @@ Rectangle {
     Timer {
         id: resetBackground
         interval: 2800
-        onTriggered: backgroundImage.source = ""
+        onTriggered: backgroundImage.file = ""
     }
 
     Image {
         id: backgroundImage
+        property url file: ""
+        // Large photographs are decoded off the GUI thread and downsampled to the largest screen, see BackgroundImageProvider.
+        readonly property size screenSize: {
+            let width = 0, height = 0;
+            for (let i = 0; i < Qt.application.screens.length; i++) {
+                const screen = Qt.application.screens[i];
+                width = Math.max(width, screen.width * screen.devicePixelRatio);
+                height = Math.max(height, screen.height * screen.devicePixelRatio);
+            }
+            return Qt.size(width, height);
+        }
+        source: file.toString() ? "image://background/" + encodeURIComponent(file.toString()) : ""
+        sourceSize: screenSize
         anchors.fill: parent
         fillMode: Image.PreserveAspectCrop
         opacity: 0
@@ -35,6 +35,7 @@ Item {
     property alias overlay: overlay
     property alias prompterBackground: prompterBackground
     property alias timer: timer
+    property alias remote: remote
     property alias find: find
     property alias mouse: mouse
     //property bool project: true
@@ -80,6 +81,10 @@ Item {
        anchors.fill: parent
     }
 
+    Remote {
+        id: remote
+    }
+
     ReadRegionOverlay {
         id: overlay
         z: 2
@@ -162,9 +167,6 @@ Item {
                 else
                     prompter.position = -prompter.topMargin
                 prompter.__i=i;
-                // Resume prompting
-                if (parseInt(prompter.state)===Prompter.States.Prompting && prompter.__play)
-                    prompter.position = prompter.__destination
             }
         }
     }
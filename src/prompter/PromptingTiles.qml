@@ -0,0 +1,145 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+import QtQuick 2.12
+
+// Rasterizes the laid-out prompter contents into horizontal strips while prompting. Text stays static in this mode, so
+// scrolling only has to move textures around instead of redrawing every glyph and recomputing the shadow on each frame.
+Item {
+    id: tiles
+
+    property Item source
+    property bool active: false
+    property bool shadows: false
+    property point shadowOffset: Qt.point(0, 0)
+    property real shadowDarkness: 0.5
+    // Fraction of the tile's resolution at which the shadow is blurred
+    property real shadowResolution: 0.5
+    property int tileHeight: 512
+    // Distance beyond the viewport, in both directions, within which tiles are kept rasterized.
+    property real margin: tileHeight
+    property real viewportY: 0
+    property real viewportHeight: 0
+
+    readonly property int tileCount: Math.ceil(height / tileHeight)
+    // Range of tiles kept rasterized
+    readonly property int first: Math.max(0, Math.floor((viewportY - margin) / tileHeight))
+    readonly property int last: Math.min(tileCount - 1, Math.floor((viewportY + viewportHeight + margin) / tileHeight))
+    // Strips are pooled, enough to cover the range wherever it falls. Scrolling hands the strip of a tile that left the
+    // range to the one that entered it, so no items or textures are created or destroyed mid-scroll.
+    readonly property int poolSize: Math.ceil((viewportHeight + 2 * margin) / tileHeight) + 1
+    readonly property real sourceX: x - (source ? source.x : 0)
+    // Reach of the two blur passes (3.182 * 4px) plus the shadow's own offset. Rendering each tile with this much
+    // overlap prevents seams at the tile boundaries.
+    readonly property int padding: Math.ceil(13 + Math.max(Math.abs(shadowOffset.x), Math.abs(shadowOffset.y)))
+
+    visible: active
+
+    function invalidate() {
+        for (let i=0; i<repeater.count; i++)
+            repeater.itemAt(i).invalidate();
+    }
+
+    // Re-rasterize only on edits and style changes. Calls are coalesced into a single pass per event loop iteration.
+    Connections {
+        target: tiles.source
+        enabled: tiles.active
+        function onTextChanged() { Qt.callLater(tiles.invalidate); }
+        function onContentHeightChanged() { Qt.callLater(tiles.invalidate); }
+        function onWidthChanged() { Qt.callLater(tiles.invalidate); }
+        function onFontChanged() { Qt.callLater(tiles.invalidate); }
+        function onColorChanged() { Qt.callLater(tiles.invalidate); }
+        function onSelectionStartChanged() { Qt.callLater(tiles.invalidate); }
+        function onSelectionEndChanged() { Qt.callLater(tiles.invalidate); }
+    }
+    onShadowOffsetChanged: Qt.callLater(tiles.invalidate)
+    onShadowDarknessChanged: Qt.callLater(tiles.invalidate)
+    onShadowResolutionChanged: Qt.callLater(tiles.invalidate)
+
+    Repeater {
+        id: repeater
+        model: tiles.active && tiles.source ? tiles.poolSize : 0
+        delegate: ShaderEffectSource {
+            id: tileView
+            required property int index
+            // The one tile in range that falls on this strip
+            readonly property int tile: tiles.first + ((index - tiles.first) % tiles.poolSize + tiles.poolSize) % tiles.poolSize
+
+            function invalidate() {
+                raster.scheduleUpdate();
+                scheduleUpdate();
+            }
+
+            // Padded snapshot of the source, used as input to the shadow passes.
+            readonly property ShaderEffectSource raster: ShaderEffectSource {
+                sourceItem: tiles.source
+                live: false
+                hideSource: tiles.active
+                sourceRect: Qt.rect(tiles.sourceX - tiles.padding, tileView.y - tiles.padding, tileView.width + 2 * tiles.padding, tileView.height + 2 * tiles.padding)
+                onSourceRectChanged: scheduleUpdate()
+            }
+            // Same shadow chain as the prompter's layer effect, evaluated once per tile instead of once per frame.
+            readonly property ShaderEffect composite: ShaderEffect {
+                id: composite
+                width: tileView.raster.sourceRect.width
+                height: tileView.raster.sourceRect.height
+                readonly property ShaderEffectSource source: tileView.raster
+                readonly property size delta: Qt.size(tiles.shadowOffset.x / width, tiles.shadowOffset.y / height)
+                readonly property real darkness: tiles.shadowDarkness
+                // Separable blur, horizontal then vertical, at reduced resolution.
+                readonly property ShaderEffectSource shadow: ShaderEffectSource {
+                    textureSize: Qt.size(Math.ceil(composite.width * tiles.shadowResolution), Math.ceil(composite.height * tiles.shadowResolution))
+                    sourceItem: ShaderEffect {
+                        width: composite.width
+                        height: composite.height
+                        readonly property size delta: Qt.size(0.0, 4.0 / height)
+                        readonly property ShaderEffectSource source: ShaderEffectSource {
+                            textureSize: Qt.size(Math.ceil(composite.width * tiles.shadowResolution), Math.ceil(composite.height * tiles.shadowResolution))
+                            sourceItem: ShaderEffect {
+                                width: composite.width
+                                height: composite.height
+                                readonly property size delta: Qt.size(4.0 / width, 0.0)
+                                readonly property ShaderEffectSource source: tileView.raster
+                                fragmentShader: "/qt/qml/com/cuperino/qprompt/shaders/blur.frag.qsb"
+                            }
+                        }
+                        fragmentShader: "/qt/qml/com/cuperino/qprompt/shaders/blur.frag.qsb"
+                    }
+                }
+                fragmentShader: "/qt/qml/com/cuperino/qprompt/shaders/shadow.frag.qsb"
+            }
+
+            // Strips keep their size, past the end of the contents too, so their textures are never reallocated.
+            visible: tile <= tiles.last
+            y: tile * tiles.tileHeight
+            width: tiles.width
+            height: tiles.tileHeight
+            // Without shadows the source is sampled directly. With shadows, the composite is only re-rendered when
+            // its inputs change, which happens solely when the raster is invalidated.
+            sourceItem: tiles.shadows ? composite : tiles.source
+            live: tiles.shadows
+            hideSource: tiles.active
+            sourceRect: tiles.shadows ? Qt.rect(tiles.padding, tiles.padding, width, height) : Qt.rect(tiles.sourceX, y, width, height)
+            onSourceRectChanged: scheduleUpdate()
+            onSourceItemChanged: scheduleUpdate()
+        }
+    }
+}
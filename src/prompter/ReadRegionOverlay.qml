@@ -70,6 +70,7 @@ Item {
     property alias __readRegionPlacement: readRegion.__placement
     property alias enabled: readRegion.enabled
     property bool disableOverlayContrast: false
+    property bool wordHighlight: false
     property string positionState: ReadRegionOverlay.PositionStates.Middle
     property string styleState: ReadRegionOverlay.PointerStates.All
     function toggleLinesInRegion(reverse) {
@@ -109,6 +110,7 @@ Item {
         property alias enabled: readRegion.enabled
         property alias linesInRegion: overlay.linesInRegion
         property alias disableOverlayContrast: overlay.disableOverlayContrast
+        property alias wordHighlight: overlay.wordHighlight
     }
     MouseArea {
         id: overlayMouseArea
@@ -121,6 +123,29 @@ Item {
         id: pointerShadowSource
         sourceItem: readRegion
     }
+    // Marks the word being read, like a karaoke cursor. Drawn over the text rather than formatting it, so it costs the
+    // same on every frame regardless of the script's length, and doesn't touch the document or its undo history.
+    Rectangle {
+        id: wordHighlight
+        readonly property rect word: {
+            if (!overlay.wordHighlight || parseInt(prompter.state) !== Prompter.States.Prompting)
+                return Qt.rect(0, 0, 0, 0);
+            const editor = prompter.editor;
+            const word = prompter.document.wordAt(prompter.position + readRegion.y + readRegion.height / 2 - editor.topPadding);
+            if (word.width <= 0)
+                return Qt.rect(0, 0, 0, 0);
+            // Placement dependencies, so the mapping follows horizontal moves as well as scrolling.
+            prompter.editorXOffset; prompter.editorXWidth;
+            return editor.mapToItem(overlay, word.x + editor.leftPadding, word.y + editor.topPadding, word.width, word.height);
+        }
+        visible: word.width > 0
+        x: word.x - radius
+        y: word.y
+        width: word.width + 2 * radius
+        height: word.height
+        radius: prompter.fontSize / 10
+        color: "#403d9ef3"
+    }
     Item {
         id: readRegion
 
@@ -153,12 +178,15 @@ Item {
             readonly property size delta: Qt.size(offset.x / width,
                                                   offset.y / height)
             readonly property real darkness: 0.5
+            // Blurred at half resolution, see Prompter.qml
             readonly property ShaderEffectSource shadow: ShaderEffectSource {
+                textureSize: Qt.size(Math.ceil(readRegion.width / 2), Math.ceil(readRegion.height / 2))
                 sourceItem: ShaderEffect {
                     width: readRegion.width
                     height: readRegion.height
                     readonly property size delta: Qt.size(0.0, 4.0 / height)
                     readonly property ShaderEffectSource source: ShaderEffectSource {
+                        textureSize: Qt.size(Math.ceil(readRegion.width / 2), Math.ceil(readRegion.height / 2))
                         sourceItem: ShaderEffect {
                             width: readRegion.width
                             height: readRegion.height
@@ -20,12 +20,59 @@
  ****************************************************************************/
 
 import QtQuick 2.12
-import QtQuick.Controls 2.12
-import QtQuick.Controls.Material 2.12
-import QtQuick.Layouts 1.12
+import QtCore 6.5
 
-import org.kde.kirigami 2.11 as Kirigami
+import com.cuperino.qprompt 1.0
 
+// Serves the prompter to remote control clients. Commands arrive already decoded and are applied like their keyboard
+// equivalents.
 Item {
+    id: remote
 
+    property alias server: remoteControl
+    property alias active: remoteControl.active
+    property alias address: remoteControl.address
+    property alias port: remoteControl.port
+
+    Settings {
+        category: "remote"
+        property alias enabled: remoteControl.active
+        property alias address: remoteControl.address
+        property alias port: remoteControl.port
+    }
+
+    RemoteControl {
+        id: remoteControl
+        document: prompter.document
+        target: prompter
+        readOffset: prompter.topMargin
+        end: editor.height + prompter.fontSize - prompter.topMargin - 1
+        velocity: prompter.__i
+        playing: prompter.__play
+        prompting: parseInt(prompter.state) === Prompter.States.Prompting
+        remaining: timer.enabled && timer.eta ? timer.remaining : -1
+        // Velocity and pause act only while prompting, as their key bindings do. setVelocity keeps the velocity within the speed limit.
+        onVelocityRequested: function (velocity) {
+            if (parseInt(prompter.state) === Prompter.States.Prompting)
+                prompter.setVelocity(velocity, null)
+        }
+        onPauseRequested: function (paused) {
+            if (parseInt(prompter.state) === Prompter.States.Prompting && prompter.__play === paused)
+                prompter.togglePause()
+        }
+        onMarkerRequested: function (step) {
+            for (let i = 0; i < Math.abs(step); i++) {
+                if (step > 0)
+                    prompter.goToNextMarker()
+                else
+                    prompter.goToPreviousMarker()
+            }
+        }
+        onGoToRequested: function (progress) {
+            prompter.position = progress * end
+        }
+        onError: function (message) {
+            showPassiveNotification(message)
+        }
+    }
 }
@@ -26,65 +26,24 @@ import QtQuick.Layouts 1.12
 import QtCore 6.5
 import Qt.labs.platform 1.1 as Labs
 
-//import com.cuperino.qprompt 1.0
+import com.cuperino.qprompt 1.0
 
 Item {
     id: clock
 
     property bool running: false
-    property double elapsedMilliseconds: 0
-    property double startTime: new Date().getTime() - elapsedMilliseconds
-    property double lastTime: startTime
+    property double elapsedMilliseconds: prompterTimer.elapsed
     property bool stopwatch: true
     property bool eta: true
+    // Seconds left until the end, estimated while the ETA is shown
+    readonly property alias remaining: prompterTimer.remaining
     property real size: 0.5
     property alias textColor: timerSettings.color
     readonly property real centreX: prompter.centreX;
     readonly property real centreY: prompter.centreY;
 
-    function getTimeString(timeInSeconds) {
-        const digitalSeconds = Math.ceil(timeInSeconds) % 60 / 100;
-        const minutes = (timeInSeconds+1) / 60
-        const digitalMinutes = Math.floor(minutes % 60) / 100;
-        const digitalHours = Math.floor((minutes / 60) % 100) / 100;
-        return (digitalHours).toFixed(2).toString().slice(2)+":"+(digitalMinutes).toFixed(2).toString().slice(2)+":"+(digitalSeconds).toFixed(2).toString().slice(2);
-    }
-    function startTimer() {
-        //console.log("Start timer")
-        startTime = new Date().getTime() - elapsedMilliseconds
-    }
-    function stopTimer() {
-        //console.log("Stop timer")
-        const currentTime = new Date().getTime()
-        elapsedMilliseconds = currentTime - startTime
-    }
-    function updateTimer() {
-        // Update ETA only if ETA is meant to be shown.
-        if (clock.eta) {
-            let timeToEnd = prompter.__timeToEnd;
-            if (!isFinite(timeToEnd) || prompter.__i<0) {
-                timeToEnd = 2 * (Math.floor(editor.height+prompter.fontSize-prompter.topMargin-1)-prompter.position) / (prompter.__baseSpeed * Math.pow(Math.abs(prompter.__iDefault), prompter.__curvature) * prompter.fontSize/2 * ((prompter.__vw-prompter.__evw/2) / prompter.__vw));
-                if (prompter.__atEnd)
-                    timeToEnd = 0
-            }
-            etaTimer.text = timer.getTimeString(timeToEnd);
-        }
-
-        // Update stopwatch timer regardless of stopwatch being shown. This allows getting desired value for talent after a run has been completed with the stopwatch hidden.
-        const newLastTime = new Date().getTime()
-        if (!running)
-            startTime = startTime + newLastTime - lastTime
-        lastTime = newLastTime
-        elapsedMilliseconds = lastTime - startTime
-
-        // Update stopwatch only if stopwatch is meant to be shown.
-        if (clock.stopwatch)
-            promptTime.text = timer.getTimeString(elapsedMilliseconds/1000);
-    }
     function reset() {
-        timer.elapsedMilliseconds = 0;
-        startTime = new Date().getTime() - elapsedMilliseconds
-        lastTime = startTime
+        prompterTimer.reset();
     }
     function setColor() {
         timerColorDialog.open()
@@ -145,7 +104,7 @@ Item {
             Label {
                 id: promptTime
                 visible: clock.stopwatch
-                text: /*i18n("SW") + " " +*/ "00:00:00"
+                text: /*i18n("SW") + " " +*/ prompterTimer.chronometer
                 font.family: "Monospace"
                 font.pixelSize: stopwatch.fontSize
                 color: clock.textColor
@@ -157,7 +116,7 @@ Item {
             Label {
                 id: etaTimer
                 visible: clock.eta
-                text: /*i18n("ET") + " " +*/ "00:00:00"
+                text: /*i18n("ET") + " " +*/ prompterTimer.eta
                 font.family: "Monospace"
                 font.pixelSize: stopwatch.fontSize
                 color: clock.textColor
@@ -187,12 +146,26 @@ Item {
         }
     }
 
-    Timer {
-        running: clock.enabled
-        repeat: true
-        triggeredOnStart: true
-        interval: 333; // Keep updates at no more than 3fps to improve frame rate.
-        onTriggered: updateTimer();
+    // The stopwatch keeps time regardless of being shown, so the talent may still get the duration of a run that was
+    // completed with it hidden. The ETA is only estimated while shown.
+    PrompterTimer {
+        id: prompterTimer
+        target: clock.enabled && clock.eta ? prompter : null
+        running: clock.running
+        end: editor.height + prompter.fontSize - prompter.topMargin - 1
+        velocity: prompter.__replaySteered ? prompter.__replayVelocity : parseInt(prompter.state) === Prompter.States.Prompting && prompter.__play && !prompter.__voiceHold ? (prompter.__possitiveDirection ? 1 : -1) * prompter.__relativeSpeed / 2 : 0
+        defaultVelocity: {
+            // Prefer the pace the talent actually read at in the last recorded session over the configured speed.
+            const analytics = root.pageStack.currentItem ? root.pageStack.currentItem.sessionAnalytics : undefined
+            if (analytics && analytics.velocity > 0)
+                return analytics.velocity
+            return prompter.__baseSpeed * Math.pow(Math.abs(prompter.__iDefault), prompter.__curvature) * prompter.fontSize / 4 * ((prompter.__vw - prompter.__evw / 2) / prompter.__vw)
+        }
+        onChronometerChanged: {
+            const monitor = root.pageStack.currentItem ? root.pageStack.currentItem.wakeupMonitor : undefined
+            if (running && monitor)
+                monitor.wake(i18nc("Subsystem name in frame statistics", "Timers"));
+        }
     }
 
     Labs.ColorDialog {
@@ -1,13 +1,11 @@
 /****************************************************************************
  **
  ** QPrompt
- ** Copyright (C) 2020-2021 Javier O. Cordero Pérez
- **
- ** This file is part of QPrompt.
+ ** Copyright (C) 2020 Javier O. Cordero Pérez
  **
  ** This program is free software: you can redistribute it and/or modify
  ** it under the terms of the GNU General Public License as published by
- ** the Free Software Foundation,  version 3 of the License.
+ ** the Free Software Foundation, version 3 of the License.
  **
  ** This program is distributed in the hope that it will be useful,
  ** but WITHOUT ANY WARRANTY; without even the implied warranty of
@@ -20,50 +18,240 @@
  ****************************************************************************/
 
 #include "promptertimer.h"
-#include <QObject>
-#include <QString>
 
-PrompterTimer::PrompterTimer(QObject *parent) : QObject(parent)
+#include <QQuickWindow>
+#include <QtMath>
+
+// Seconds for the measured scroll rate to settle after a change in speed
+static constexpr qreal RATE_TIME_CONSTANT = 1.5;
+// The estimate is kept within this factor of the commanded velocity, which bounds the ETA's error while stalls and
+// dropped frames are averaged out.
+static constexpr qreal MAX_RATE_ERROR = 1.5;
+// Frames further apart than this are idle time, not scrolling.
+static constexpr qint64 MAX_SAMPLE_GAP = 250;
+
+PrompterTimer::PrompterTimer(QObject *parent)
+    : QObject(parent)
+    , m_running(false)
+    , m_accumulated(0)
+    , m_runningSince(0)
+    , m_chronometerSeconds(0)
+    , m_chronometer(format(0))
+    , m_end(0)
+    , m_velocity(0)
+    , m_defaultVelocity(0)
+    , m_rate(0)
+    , m_lastPosition(0)
+    , m_lastSample(-1)
+    , m_remaining(0)
+    , m_etaSeconds(0)
+    , m_eta(format(0))
+{
+    m_clock.start();
+    m_secondTimer.setSingleShot(true);
+    m_secondTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_secondTimer, &QTimer::timeout, this, &PrompterTimer::updateChronometer);
+}
+
+QQuickItem *PrompterTimer::target() const
+{
+    return m_target;
+}
+
+void PrompterTimer::setTarget(QQuickItem *target)
+{
+    if (target == m_target)
+        return;
+
+    if (m_target)
+        disconnect(m_target, &QQuickItem::windowChanged, this, &PrompterTimer::windowChanged);
+    m_target = target;
+    if (m_target)
+        connect(m_target, &QQuickItem::windowChanged, this, &PrompterTimer::windowChanged);
+    windowChanged(m_target ? m_target->window() : nullptr);
+    updateEta();
+    Q_EMIT targetChanged();
+}
+
+bool PrompterTimer::running() const
+{
+    return m_running;
+}
+
+void PrompterTimer::setRunning(bool running)
+{
+    if (running == m_running)
+        return;
+
+    if (running)
+        m_runningSince = m_clock.elapsed();
+    else
+        m_accumulated += m_clock.elapsed() - m_runningSince;
+    m_running = running;
+    updateChronometer();
+    Q_EMIT runningChanged();
+}
+
+qreal PrompterTimer::end() const
+{
+    return m_end;
+}
+
+void PrompterTimer::setEnd(qreal end)
+{
+    if (qFuzzyCompare(end, m_end))
+        return;
+
+    m_end = end;
+    updateEta();
+    Q_EMIT estimateChanged();
+}
+
+qreal PrompterTimer::velocity() const
+{
+    return m_velocity;
+}
+
+void PrompterTimer::setVelocity(qreal velocity)
 {
+    if (qFuzzyCompare(velocity, m_velocity))
+        return;
 
+    m_velocity = velocity;
+    // Measurements start over from the commanded velocity whenever it changes, rather than lagging behind it.
+    m_rate = qMax<qreal>(0, velocity);
+    m_lastSample = -1;
+    updateEta();
+    Q_EMIT estimateChanged();
 }
 
-// void PrompterTimer::chronometerChanged() {
-//
-// }
-//
-// void PrompterTimer::etaChanged() {
-//
-// }
+qreal PrompterTimer::defaultVelocity() const
+{
+    return m_defaultVelocity;
+}
+
+void PrompterTimer::setDefaultVelocity(qreal defaultVelocity)
+{
+    if (qFuzzyCompare(defaultVelocity, m_defaultVelocity))
+        return;
+
+    m_defaultVelocity = defaultVelocity;
+    updateEta();
+    Q_EMIT estimateChanged();
+}
 
-void PrompterTimer::start() {
+qint64 PrompterTimer::elapsed() const
+{
+    return m_accumulated + (m_running ? m_clock.elapsed() - m_runningSince : 0);
+}
 
+QString PrompterTimer::chronometer() const
+{
+    return m_chronometer;
 }
 
-void PrompterTimer::stop() {
+qreal PrompterTimer::remaining() const
+{
+    return m_remaining;
+}
 
+QString PrompterTimer::eta() const
+{
+    return m_eta;
 }
 
-void PrompterTimer::reset() {
+QString PrompterTimer::format(qint64 seconds)
+{
+    if (seconds < 0)
+        return QStringLiteral("--:--:--");
+    return QStringLiteral("%1:%2:%3")
+        .arg(seconds / 3600 % 100, 2, 10, QLatin1Char('0'))
+        .arg(seconds / 60 % 60, 2, 10, QLatin1Char('0'))
+        .arg(seconds % 60, 2, 10, QLatin1Char('0'));
+}
 
+void PrompterTimer::start()
+{
+    setRunning(true);
 }
 
-void PrompterTimer::toggle(bool value) {
+void PrompterTimer::stop()
+{
+    setRunning(false);
+}
 
+void PrompterTimer::reset()
+{
+    m_accumulated = 0;
+    m_runningSince = m_clock.elapsed();
+    updateChronometer();
 }
 
-void PrompterTimer::setChronometer(QString value) {
+void PrompterTimer::toggle(bool value)
+{
+    setRunning(value);
+}
 
+void PrompterTimer::windowChanged(QQuickWindow *window)
+{
+    if (m_window)
+        disconnect(m_window, &QQuickWindow::afterAnimating, this, &PrompterTimer::frame);
+    m_window = window;
+    if (m_window)
+        connect(m_window, &QQuickWindow::afterAnimating, this, &PrompterTimer::frame);
+    m_lastSample = -1;
 }
 
-void PrompterTimer::setETA(QString value) {
+void PrompterTimer::frame()
+{
+    if (!m_target)
+        return;
 
+    const qreal position = m_target->property("contentY").toReal();
+    const qint64 now = m_clock.elapsed();
+    if (m_velocity > 0 && m_lastSample >= 0 && now > m_lastSample && now - m_lastSample <= MAX_SAMPLE_GAP) {
+        const qreal dt = (now - m_lastSample) / 1000.0;
+        const qreal alpha = 1 - qExp(-dt / RATE_TIME_CONSTANT);
+        m_rate += alpha * ((position - m_lastPosition) / dt - m_rate);
+    }
+    m_lastSample = now;
+    m_lastPosition = position;
+    updateEta();
 }
 
-QString PrompterTimer::chronometer() {
-    return this->m_chronometer;
+void PrompterTimer::updateChronometer()
+{
+    const qint64 elapsed = this->elapsed();
+    const qint64 seconds = (elapsed + 999) / 1000;
+    if (seconds != m_chronometerSeconds) {
+        m_chronometerSeconds = seconds;
+        m_chronometer = format(seconds);
+        Q_EMIT chronometerChanged();
+    }
+    // Wake up once per displayed second, just after the digits change.
+    if (m_running)
+        m_secondTimer.start(int(1000 - elapsed % 1000) + 1);
+    else
+        m_secondTimer.stop();
 }
 
-QString PrompterTimer::eta() {
-    return this->m_eta;
+void PrompterTimer::updateEta()
+{
+    if (!m_target)
+        return;
+
+    const qreal rate = m_velocity > 0 ? qBound(m_velocity / MAX_RATE_ERROR, m_rate, m_velocity * MAX_RATE_ERROR) : m_defaultVelocity;
+    const qreal distance = qMax<qreal>(0, m_end - m_target->property("contentY").toReal());
+    const qreal remaining = distance <= 0 ? 0 : (rate > 0 ? distance / rate : qInf());
+    if (remaining == m_remaining)
+        return;
+    m_remaining = remaining;
+    Q_EMIT remainingChanged();
+
+    const qint64 seconds = qIsFinite(m_remaining) ? qCeil(m_remaining) : -1;
+    if (seconds == m_etaSeconds)
+        return;
+    m_etaSeconds = seconds;
+    m_eta = format(seconds);
+    Q_EMIT etaChanged();
 }
@@ -17,77 +17,107 @@
  **
  ****************************************************************************/
 
-#ifndef TIMER_H
-#define TIMER_H
+#ifndef PROMPTERTIMER_H
+#define PROMPTERTIMER_H
 
-// #include <QTime>
+#include <QElapsedTimer>
 #include <QObject>
-#include <QTimer>
-#include <QTimerEvent> 
+#include <QPointer>
+#include <QQmlEngine>
+#include <QQuickItem>
 #include <QString>
-#include <iostream>
+#include <QTimer>
+
+class QQuickWindow;
 
-/**
- * @todo write docs
- */
+// Stopwatch and estimated time of arrival for a prompter. Time is measured with a monotonic clock. The ETA divides the
+// distance left by a smoothed measure of how fast the target actually scrolls, sampled once per frame, and display
+// strings are only formatted when the digits they show change.
 class PrompterTimer : public QObject
 {
     Q_OBJECT
-    
-    Q_PROPERTY(QString chronometer READ chronometer WRITE setChronometer NOTIFY chronometerChanged)
-    Q_PROPERTY(QString eta READ eta WRITE setETA NOTIFY etaChanged)
-    
+    QML_ELEMENT
+
+    // Flickable whose contentY is measured. Set to null to stop estimating.
+    Q_PROPERTY(QQuickItem *target READ target WRITE setTarget NOTIFY targetChanged)
+    Q_PROPERTY(bool running READ running WRITE setRunning NOTIFY runningChanged)
+    // contentY at which prompting ends
+    Q_PROPERTY(qreal end READ end WRITE setEnd NOTIFY estimateChanged)
+    // Commanded scroll velocity in pixels per second, 0 or negative while not moving forward
+    Q_PROPERTY(qreal velocity READ velocity WRITE setVelocity NOTIFY estimateChanged)
+    // Velocity the ETA assumes while not moving forward, in pixels per second
+    Q_PROPERTY(qreal defaultVelocity READ defaultVelocity WRITE setDefaultVelocity NOTIFY estimateChanged)
+    Q_PROPERTY(qint64 elapsed READ elapsed NOTIFY chronometerChanged)
+    Q_PROPERTY(QString chronometer READ chronometer NOTIFY chronometerChanged)
+    // Seconds until the end is reached
+    Q_PROPERTY(qreal remaining READ remaining NOTIFY remainingChanged)
+    Q_PROPERTY(QString eta READ eta NOTIFY etaChanged)
+
 public:
-    /**
-     * Default constructor
-     */
     explicit PrompterTimer(QObject *parent = nullptr);
 
-signals:
-    void chronometerChanged();
-    void etaChanged();
-    
-public slots:
+    QQuickItem *target() const;
+    void setTarget(QQuickItem *target);
+    bool running() const;
+    void setRunning(bool running);
+    qreal end() const;
+    void setEnd(qreal end);
+    qreal velocity() const;
+    void setVelocity(qreal velocity);
+    qreal defaultVelocity() const;
+    void setDefaultVelocity(qreal defaultVelocity);
+
+    // Milliseconds
+    qint64 elapsed() const;
+    QString chronometer() const;
+    qreal remaining() const;
+    QString eta() const;
+
+    // Formats whole seconds as hh:mm:ss
+    static QString format(qint64 seconds);
+
+public Q_SLOTS:
     void start();
     void stop();
     void reset();
     void toggle(bool value);
 
-// protected:
-//     void timerEvent(QTimerEvent *)
-//     {
-//         if(mRunning)
-//         {
-//             qint64 ms = mStartTime.msecsTo(QTime::currentTime());
-//             int h = ms / 1000 / 60 / 60;
-//             int m = (ms / 1000 / 60) - (h * 60);
-//             int s = (ms / 1000) - (m * 60);
-//             ms = ms - (s * 1000) - (m * 60000) - (h * 3600000);
-//             QString diff = QString("%1:%2:%3:%4").
-//             arg(h, 3, 10, 0).
-//             arg(m, 2, 10, 0).
-//             arg(s, 2, 10, 0).
-//             arg(ms, 3, 10, 0);
-//             //mLabel->setText(diff);
-//         }
-//     }
-    
+Q_SIGNALS:
+    void targetChanged();
+    void runningChanged();
+    void estimateChanged();
+    void chronometerChanged();
+    void remainingChanged();
+    void etaChanged();
+
 private:
-    // Tut
-    //QTimer m_timer;
-    //QElapsedTimer m_watch;
-    QString m_chronometer;
-    QString m_eta;
+    void windowChanged(QQuickWindow *window);
+    void frame();
+    void updateChronometer();
+    void updateEta();
 
-    QString chronometer();
-    QString eta();
-    void setChronometer(QString value);
-    void setETA(QString value);
-    
-    // Git
-//     bool mRunning;
-//     QTime mStartTime;
-//     const QChar zero;    
+    QPointer<QQuickItem> m_target;
+    QPointer<QQuickWindow> m_window;
+    QElapsedTimer m_clock;
+    QTimer m_secondTimer;
 
+    // Stopwatch, in milliseconds of m_clock
+    bool m_running;
+    qint64 m_accumulated;
+    qint64 m_runningSince;
+    qint64 m_chronometerSeconds;
+    QString m_chronometer;
+
+    // Scroll rate measurement
+    qreal m_end;
+    qreal m_velocity;
+    qreal m_defaultVelocity;
+    qreal m_rate;
+    qreal m_lastPosition;
+    qint64 m_lastSample;
+    qreal m_remaining;
+    qint64 m_etaSeconds;
+    QString m_eta;
 };
+
 #endif // PROMPTERTIMER_H
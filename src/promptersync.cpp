@@ -0,0 +1,740 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+#include "promptersync.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QNetworkDatagram>
+#include <QQuickTextDocument>
+#include <QQuickWindow>
+#include <QTextDocument>
+#include <QTextStream>
+#include <QtEndian>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+
+static constexpr char MAGIC[4] = {'Q', 'P', 'S', 'Y'};
+static constexpr quint8 VERSION = 2;
+static constexpr int DEFAULT_PORT = 8790;
+// Milliseconds between states sent by leaders
+static constexpr int STATE_INTERVAL = 100;
+// Milliseconds between clock exchanges, faster until the first few have been made
+static constexpr int SYNC_INTERVAL = 1000;
+static constexpr int FAST_SYNC_INTERVAL = 250;
+static constexpr int FAST_SYNC_EXCHANGES = 8;
+// Nanoseconds after which a leader that stopped sending is no longer followed
+static constexpr qint64 STALE_STATE = 1000000000;
+static constexpr qint64 SUBSCRIBER_TIMEOUT = 5000000000;
+// Pixels off from what followers extrapolate, and pixels per second of velocity change, that leaders send right away
+static constexpr qreal JUMP_DISTANCE = 2;
+static constexpr qreal VELOCITY_CHANGE = 0.5;
+// Followers further off than this snap to the leader instead of steering toward it
+static constexpr qreal SNAP_DISTANCE = 200;
+// Fraction of the distance to the leader that followers make up per second, and the most speed spent doing so
+static constexpr qreal CORRECTION_RATE = 4;
+static constexpr qreal MAX_CORRECTION = 400;
+
+namespace
+{
+class Writer
+{
+public:
+    explicit Writer(quint8 type)
+        : m_stream(&m_packet, QIODevice::WriteOnly)
+    {
+        m_stream.setVersion(QDataStream::Qt_6_0);
+        m_stream.setByteOrder(QDataStream::LittleEndian);
+        m_stream.writeRawData(MAGIC, sizeof(MAGIC));
+        m_stream << VERSION << type;
+    }
+
+    template<typename T>
+    Writer &operator<<(const T &value)
+    {
+        m_stream << value;
+        return *this;
+    }
+
+    const QByteArray &packet() const
+    {
+        return m_packet;
+    }
+
+private:
+    QByteArray m_packet;
+    QDataStream m_stream;
+};
+
+// Returns the type of message that follows, or 0 if the datagram isn't one
+quint8 readHeader(QDataStream &in)
+{
+    in.setVersion(QDataStream::Qt_6_0);
+    in.setByteOrder(QDataStream::LittleEndian);
+    char magic[sizeof(MAGIC)];
+    quint8 version = 0;
+    quint8 type = 0;
+    if (in.readRawData(magic, sizeof(MAGIC)) != sizeof(MAGIC) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        return 0;
+    in >> version >> type;
+    return in.status() == QDataStream::Ok && version == VERSION ? type : 0;
+}
+
+// Splits host:port, defaulting to the standard port
+bool parseEndpoint(const QString &endpoint, QHostAddress &address, quint16 &port)
+{
+    const qsizetype separator = endpoint.lastIndexOf(QLatin1Char(':'));
+    address = QHostAddress(separator > 0 ? endpoint.left(separator) : endpoint);
+    port = separator > 0 ? quint16(endpoint.mid(separator + 1).toUInt()) : quint16(DEFAULT_PORT);
+    return !address.isNull() && port;
+}
+}
+
+void ClockOffset::add(qint64 t0, qint64 t1, qint64 t2, qint64 t3)
+{
+    const qint64 delay = (t3 - t0) - (t2 - t1);
+    if (delay < 0)
+        return;
+    m_exchanges.append({((t1 - t0) + (t2 - t3)) / 2, delay});
+    if (m_exchanges.size() > Window)
+        m_exchanges.removeFirst();
+    ++m_count;
+}
+
+void ClockOffset::clear()
+{
+    m_exchanges.clear();
+    m_count = 0;
+}
+
+bool ClockOffset::valid() const
+{
+    return !m_exchanges.isEmpty();
+}
+
+qint64 ClockOffset::offset() const
+{
+    const auto best = std::min_element(m_exchanges.cbegin(), m_exchanges.cend(), [](const Exchange &a, const Exchange &b) {
+        return a.delay < b.delay;
+    });
+    return best != m_exchanges.cend() ? best->offset : 0;
+}
+
+qint64 ClockOffset::delay() const
+{
+    const auto best = std::min_element(m_exchanges.cbegin(), m_exchanges.cend(), [](const Exchange &a, const Exchange &b) {
+        return a.delay < b.delay;
+    });
+    return best != m_exchanges.cend() ? best->delay : 0;
+}
+
+int ClockOffset::exchanges() const
+{
+    return m_count;
+}
+
+PrompterSync::PrompterSync(QObject *parent)
+    : QObject(parent)
+    , m_role(Off)
+    , m_port(DEFAULT_PORT)
+    , m_readOffset(0)
+    , m_prompting(false)
+    , m_leaderVelocity(0)
+    , m_following(false)
+    , m_documentMatches(true)
+    , m_velocity(0)
+    , m_drift(0)
+    , m_frameTimestamp(0)
+    , m_framePosition(0)
+    , m_sentTimestamp(0)
+    , m_sentPosition(0)
+    , m_sentVelocity(0)
+    , m_revisionDirty(true)
+    , m_revision(0)
+{
+    connect(&m_socket, &QUdpSocket::readyRead, this, &PrompterSync::read);
+    connect(&m_timer, &QTimer::timeout, this, [this]() {
+        if (m_role == Leader)
+            broadcast();
+        else
+            synchronize();
+    });
+}
+
+PrompterSync::Role PrompterSync::role() const
+{
+    return m_role;
+}
+
+void PrompterSync::setRole(Role role)
+{
+    if (role == m_role)
+        return;
+
+    m_role = role;
+    restart();
+    Q_EMIT roleChanged();
+}
+
+QString PrompterSync::leader() const
+{
+    return m_leader;
+}
+
+void PrompterSync::setLeader(const QString &leader)
+{
+    if (leader == m_leader)
+        return;
+
+    m_leader = leader;
+    if (m_role == Follower)
+        restart();
+    Q_EMIT leaderChanged();
+}
+
+int PrompterSync::port() const
+{
+    return m_port;
+}
+
+void PrompterSync::setPort(int port)
+{
+    if (port == m_port)
+        return;
+
+    m_port = port;
+    if (m_role != Off)
+        restart();
+    Q_EMIT portChanged();
+}
+
+DocumentHandler *PrompterSync::document() const
+{
+    return m_document;
+}
+
+void PrompterSync::setDocument(DocumentHandler *document)
+{
+    if (document == m_document)
+        return;
+
+    m_document = document;
+    m_revisionDirty = true;
+    Q_EMIT documentChanged();
+}
+
+QQuickItem *PrompterSync::target() const
+{
+    return m_target;
+}
+
+void PrompterSync::setTarget(QQuickItem *target)
+{
+    if (target == m_target)
+        return;
+
+    if (m_target)
+        disconnect(m_target, &QQuickItem::windowChanged, this, &PrompterSync::windowChanged);
+    m_target = target;
+    if (m_target)
+        connect(m_target, &QQuickItem::windowChanged, this, &PrompterSync::windowChanged);
+    windowChanged(m_target ? m_target->window() : nullptr);
+    Q_EMIT targetChanged();
+}
+
+qreal PrompterSync::readOffset() const
+{
+    return m_readOffset;
+}
+
+void PrompterSync::setReadOffset(qreal readOffset)
+{
+    if (qFuzzyCompare(readOffset, m_readOffset))
+        return;
+
+    m_readOffset = readOffset;
+    Q_EMIT readOffsetChanged();
+}
+
+bool PrompterSync::prompting() const
+{
+    return m_prompting;
+}
+
+void PrompterSync::setPrompting(bool prompting)
+{
+    if (prompting == m_prompting)
+        return;
+
+    m_prompting = prompting;
+    if (m_role == Leader)
+        broadcast();
+    else
+        updateFollowing();
+    Q_EMIT promptingChanged();
+}
+
+qreal PrompterSync::leaderVelocity() const
+{
+    return m_leaderVelocity;
+}
+
+void PrompterSync::setLeaderVelocity(qreal leaderVelocity)
+{
+    if (qFuzzyCompare(leaderVelocity, m_leaderVelocity))
+        return;
+
+    m_leaderVelocity = leaderVelocity;
+    Q_EMIT leaderVelocityChanged();
+}
+
+bool PrompterSync::following() const
+{
+    return m_following;
+}
+
+bool PrompterSync::documentMatches() const
+{
+    return m_documentMatches;
+}
+
+qreal PrompterSync::velocity() const
+{
+    return m_velocity;
+}
+
+qreal PrompterSync::drift() const
+{
+    return m_drift;
+}
+
+int PrompterSync::followers() const
+{
+    return int(m_subscribers.size());
+}
+
+qint64 PrompterSync::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PrompterSync::restart()
+{
+    m_socket.close();
+    m_timer.stop();
+    m_subscribers.clear();
+    m_clock.clear();
+    m_state = LeaderState();
+    m_sentTimestamp = 0;
+    updateFollowing();
+    Q_EMIT followersChanged();
+
+    if (m_role == Leader) {
+        if (!m_socket.bind(QHostAddress::AnyIPv4, quint16(m_port))) {
+            Q_EMIT error(tr("Cannot listen for followers on port %1").arg(m_port));
+            return;
+        }
+        m_timer.start(STATE_INTERVAL);
+    }
+    else if (m_role == Follower) {
+        m_leaderAddress = QHostAddress(m_leader);
+        if (m_leaderAddress.isNull()) {
+            Q_EMIT error(tr("The leader's address must be an IP address"));
+            return;
+        }
+        if (!m_socket.bind(QHostAddress::AnyIPv4, 0)) {
+            Q_EMIT error(tr("Cannot open a socket to follow %1").arg(m_leader));
+            return;
+        }
+        m_timer.start(FAST_SYNC_INTERVAL);
+        synchronize();
+    }
+}
+
+void PrompterSync::read()
+{
+    while (m_socket.hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_socket.receiveDatagram();
+        const qint64 received = now();
+        const QByteArray data = datagram.data();
+        QDataStream in(data);
+        const quint8 type = readHeader(in);
+        const QHostAddress sender = datagram.senderAddress();
+        const quint16 senderPort = quint16(datagram.senderPort());
+        const bool fromLeader = m_role == Follower && senderPort == m_port && sender.isEqual(m_leaderAddress, QHostAddress::ConvertV4MappedToIPv4);
+
+        switch (type) {
+        case TimeRequest: {
+            qint64 t0 = 0;
+            bool subscribe = false;
+            in >> t0 >> subscribe;
+            if (in.status() != QDataStream::Ok)
+                break;
+            m_socket.writeDatagram((Writer(TimeReply) << t0 << received << now()).packet(), sender, senderPort);
+            if (m_role != Leader || !subscribe)
+                break;
+            const auto subscriber = std::find_if(m_subscribers.begin(), m_subscribers.end(), [&](const Subscriber &subscriber) {
+                return subscriber.port == senderPort && subscriber.address.isEqual(sender, QHostAddress::ConvertV4MappedToIPv4);
+            });
+            if (subscriber != m_subscribers.end()) {
+                subscriber->lastSeen = received;
+                break;
+            }
+            m_subscribers.append({sender, senderPort, received});
+            // New followers shouldn't wait for the next state
+            m_socket.writeDatagram(stateMessage(), sender, senderPort);
+            Q_EMIT followersChanged();
+            break;
+        }
+        case TimeReply: {
+            qint64 t0 = 0, t1 = 0, t2 = 0;
+            in >> t0 >> t1 >> t2;
+            if (!fromLeader || in.status() != QDataStream::Ok)
+                break;
+            m_clock.add(t0, t1, t2, received);
+            if (m_clock.exchanges() == FAST_SYNC_EXCHANGES)
+                m_timer.setInterval(SYNC_INTERVAL);
+            updateFollowing();
+            break;
+        }
+        case State: {
+            LeaderState state;
+            in >> state.timestamp >> state.line >> state.lineOffset >> state.velocity >> state.revision >> state.prompting;
+            if (!fromLeader || in.status() != QDataStream::Ok)
+                break;
+            // Datagrams may arrive out of order. Older states are dropped, unless the leader went quiet and may have restarted.
+            if (state.timestamp < m_state.timestamp && received - m_state.received < STALE_STATE)
+                break;
+            state.received = received;
+            m_state = state;
+            const bool documentMatches = m_state.revision == revision();
+            if (documentMatches != m_documentMatches) {
+                m_documentMatches = documentMatches;
+                Q_EMIT documentMatchesChanged();
+            }
+            updateFollowing();
+            break;
+        }
+        case Probe: {
+            quint32 token = 0;
+            in >> token;
+            if (in.status() != QDataStream::Ok)
+                break;
+            const qreal velocity = m_role == Leader ? m_leaderVelocity : (m_following ? m_velocity : 0);
+            m_socket.writeDatagram((Writer(ProbeReply) << token << m_frameTimestamp << m_framePosition << velocity).packet(), sender, senderPort);
+            break;
+        }
+        case Subscribers: {
+            if (m_role != Leader)
+                break;
+            Writer reply(SubscribersReply);
+            reply << quint32(m_subscribers.size());
+            for (const Subscriber &subscriber : std::as_const(m_subscribers))
+                reply << subscriber.address << subscriber.port;
+            m_socket.writeDatagram(reply.packet(), sender, senderPort);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void PrompterSync::synchronize()
+{
+    m_socket.writeDatagram((Writer(TimeRequest) << now() << true).packet(), m_leaderAddress, quint16(m_port));
+    updateFollowing();
+}
+
+void PrompterSync::broadcast()
+{
+    const qint64 timestamp = now();
+    const qsizetype subscribers = m_subscribers.size();
+    m_subscribers.removeIf([timestamp](const Subscriber &subscriber) {
+        return timestamp - subscriber.lastSeen > SUBSCRIBER_TIMEOUT;
+    });
+    if (m_subscribers.size() != subscribers)
+        Q_EMIT followersChanged();
+    if (m_subscribers.isEmpty())
+        return;
+
+    // Nothing is animating, so the last frame may be long gone.
+    if (timestamp - m_frameTimestamp > qint64(STATE_INTERVAL) * 1000000) {
+        m_frameTimestamp = timestamp;
+        m_framePosition = m_target ? m_target->property("contentY").toReal() : 0;
+    }
+    const QByteArray state = stateMessage();
+    for (const Subscriber &subscriber : std::as_const(m_subscribers))
+        m_socket.writeDatagram(state, subscriber.address, subscriber.port);
+    m_sentTimestamp = m_frameTimestamp;
+    m_sentPosition = m_framePosition;
+    m_sentVelocity = m_leaderVelocity;
+}
+
+void PrompterSync::windowChanged(QQuickWindow *window)
+{
+    if (window == m_window)
+        return;
+
+    if (m_window)
+        disconnect(m_window, &QQuickWindow::afterAnimating, this, &PrompterSync::frame);
+    m_window = window;
+    if (m_window)
+        connect(m_window, &QQuickWindow::afterAnimating, this, &PrompterSync::frame);
+}
+
+void PrompterSync::frame()
+{
+    if (m_role == Off || !m_target)
+        return;
+
+    const qint64 timestamp = now();
+    m_frameTimestamp = timestamp;
+    m_framePosition = m_target->property("contentY").toReal();
+
+    if (m_role == Leader) {
+        // Jumps and velocity changes go out right away, the rest is left to extrapolation.
+        const qreal expected = m_sentPosition + m_sentVelocity * (timestamp - m_sentTimestamp) / 1e9;
+        if (!m_subscribers.isEmpty() && (qAbs(m_framePosition - expected) > JUMP_DISTANCE || qAbs(m_leaderVelocity - m_sentVelocity) > VELOCITY_CHANGE))
+            broadcast();
+        return;
+    }
+
+    updateFollowing();
+    if (!m_following)
+        return;
+
+    // The leader's line is placed in this instance's own layout.
+    const qreal lineHeight = m_document ? m_document->cursorLineHeight(m_state.line) : 0;
+    const qreal position = m_document ? m_document->cursorY(m_state.line) + m_state.lineOffset * lineHeight - m_readOffset : 0;
+    const qreal velocity = m_state.velocity * lineHeight;
+    const qreal leaderPosition = position + velocity * (timestamp + m_clock.offset() - m_state.timestamp) / 1e9;
+    m_drift = leaderPosition - m_framePosition;
+    Q_EMIT driftChanged();
+    if (qAbs(m_drift) > SNAP_DISTANCE) {
+        m_target->setProperty("contentY", leaderPosition);
+        m_framePosition = leaderPosition;
+        setVelocity(velocity);
+        return;
+    }
+    setVelocity(velocity + qBound(-MAX_CORRECTION, m_drift * CORRECTION_RATE, MAX_CORRECTION));
+}
+
+void PrompterSync::updateFollowing()
+{
+    const bool following = m_role == Follower && m_prompting && m_clock.valid() && m_state.received && now() - m_state.received < STALE_STATE
+        && m_state.prompting && m_documentMatches;
+    if (following == m_following)
+        return;
+
+    m_following = following;
+    if (!m_following)
+        setVelocity(0);
+    Q_EMIT followingChanged();
+}
+
+void PrompterSync::setVelocity(qreal velocity)
+{
+    if (qFuzzyCompare(velocity, m_velocity))
+        return;
+
+    m_velocity = velocity;
+    Q_EMIT velocityChanged();
+}
+
+quint32 PrompterSync::revision()
+{
+    QTextDocument *textDocument = m_document && m_document->document() ? m_document->document()->textDocument() : nullptr;
+    if (textDocument != m_textDocument) {
+        if (m_textDocument)
+            disconnect(m_textDocument, &QTextDocument::contentsChanged, this, nullptr);
+        m_textDocument = textDocument;
+        if (m_textDocument)
+            connect(m_textDocument, &QTextDocument::contentsChanged, this, [this]() {
+                m_revisionDirty = true;
+            });
+        m_revisionDirty = true;
+    }
+    if (m_revisionDirty) {
+        m_revisionDirty = false;
+        const QByteArray hash = QCryptographicHash::hash(m_textDocument ? m_textDocument->toPlainText().toUtf8() : QByteArray(), QCryptographicHash::Sha1);
+        m_revision = qFromLittleEndian<quint32>(hash.constData());
+    }
+    return m_revision;
+}
+
+QByteArray PrompterSync::stateMessage()
+{
+    qint32 line = 0;
+    qreal lineOffset = 0;
+    qreal velocity = 0;
+    if (m_document) {
+        const qreal y = m_framePosition + m_readOffset;
+        line = m_document->lineStart(y);
+        const qreal lineHeight = m_document->cursorLineHeight(line);
+        if (lineHeight > 0) {
+            lineOffset = (y - m_document->cursorY(line)) / lineHeight;
+            velocity = m_leaderVelocity / lineHeight;
+        }
+    }
+    return (Writer(State) << m_frameTimestamp << line << lineOffset << velocity << revision() << m_prompting).packet();
+}
+
+int PrompterSync::measureDrift(const QString &leader, int seconds)
+{
+    QTextStream out(stdout);
+    QHostAddress leaderAddress;
+    quint16 leaderPort = 0;
+    if (!parseEndpoint(leader, leaderAddress, leaderPort)) {
+        out << "Expected the leader as host:port\n";
+        return 1;
+    }
+    QUdpSocket socket;
+    if (!socket.bind(QHostAddress::AnyIPv4, 0)) {
+        out << "Cannot open a UDP socket: " << socket.errorString() << '\n';
+        return 1;
+    }
+
+    struct Peer {
+        QHostAddress address;
+        quint16 port;
+        ClockOffset clock;
+        // Last probe, with its timestamp converted to local time
+        bool probed = false;
+        qint64 timestamp = 0;
+        qreal position = 0;
+        qreal velocity = 0;
+        QList<qreal> drift;
+    };
+    QList<Peer> peers;
+    peers.append({leaderAddress, leaderPort, {}});
+
+    // Waits up to the given milliseconds for datagrams, handing each to the callback
+    const auto receive = [&socket](int milliseconds, const std::function<void(const QNetworkDatagram &, qint64)> &handle) {
+        QElapsedTimer clock;
+        clock.start();
+        while (clock.elapsed() < milliseconds && socket.waitForReadyRead(int(qMax<qint64>(1, milliseconds - clock.elapsed())))) {
+            while (socket.hasPendingDatagrams()) {
+                const QNetworkDatagram datagram = socket.receiveDatagram();
+                handle(datagram, now());
+            }
+        }
+    };
+
+    socket.writeDatagram(Writer(Subscribers).packet(), leaderAddress, leaderPort);
+    bool answered = false;
+    receive(1000, [&](const QNetworkDatagram &datagram, qint64) {
+        const QByteArray data = datagram.data();
+        QDataStream in(data);
+        quint32 count = 0;
+        if (answered || readHeader(in) != SubscribersReply || (in >> count, in.status() != QDataStream::Ok))
+            return;
+        answered = true;
+        for (quint32 i = 0; i < count; i++) {
+            Peer follower;
+            in >> follower.address >> follower.port;
+            if (in.status() != QDataStream::Ok)
+                break;
+            // Followers on the leader's machine may only be reachable through the address the leader was contacted at
+            if (follower.address.isLoopback())
+                follower.address = leaderAddress;
+            peers.append(follower);
+        }
+    });
+    if (!answered) {
+        out << "No answer from a leader at " << leader << '\n';
+        return 1;
+    }
+    if (peers.size() == 1) {
+        out << "The leader at " << leader << " has no followers\n";
+        return 1;
+    }
+
+    // Ten rounds a second of clock exchanges and probes. Positions are compared after extrapolating each to the same
+    // local instant.
+    for (quint32 round = 0; round < quint32(seconds * 10); round++) {
+        for (Peer &peer : peers) {
+            peer.probed = false;
+            socket.writeDatagram((Writer(TimeRequest) << now() << false).packet(), peer.address, peer.port);
+            socket.writeDatagram((Writer(Probe) << round).packet(), peer.address, peer.port);
+        }
+        receive(100, [&](const QNetworkDatagram &datagram, qint64 received) {
+            const auto peer = std::find_if(peers.begin(), peers.end(), [&datagram](const Peer &peer) {
+                return peer.port == datagram.senderPort() && peer.address.isEqual(datagram.senderAddress(), QHostAddress::ConvertV4MappedToIPv4);
+            });
+            if (peer == peers.end())
+                return;
+            const QByteArray data = datagram.data();
+            QDataStream in(data);
+            const quint8 type = readHeader(in);
+            if (type == TimeReply) {
+                qint64 t0 = 0, t1 = 0, t2 = 0;
+                in >> t0 >> t1 >> t2;
+                if (in.status() == QDataStream::Ok)
+                    peer->clock.add(t0, t1, t2, received);
+            }
+            else if (type == ProbeReply) {
+                quint32 token = 0;
+                qint64 timestamp = 0;
+                in >> token >> timestamp >> peer->position >> peer->velocity;
+                if (in.status() == QDataStream::Ok && token == round && peer->clock.valid()) {
+                    peer->timestamp = timestamp - peer->clock.offset();
+                    peer->probed = true;
+                }
+            }
+        });
+
+        const Peer &leaderPeer = peers.first();
+        if (!leaderPeer.probed)
+            continue;
+        const qint64 instant = now();
+        const qreal leaderPosition = leaderPeer.position + leaderPeer.velocity * (instant - leaderPeer.timestamp) / 1e9;
+        for (qsizetype i = 1; i < peers.size(); i++) {
+            Peer &follower = peers[i];
+            if (follower.probed)
+                follower.drift.append(follower.position + follower.velocity * (instant - follower.timestamp) / 1e9 - leaderPosition);
+        }
+    }
+
+    for (qsizetype i = 1; i < peers.size(); i++) {
+        Peer &follower = peers[i];
+        out << "Follower " << follower.address.toString() << ':' << follower.port << ": ";
+        if (follower.drift.isEmpty()) {
+            out << "no measurements\n";
+            continue;
+        }
+        QList<qreal> distances;
+        qreal sum = 0;
+        for (const qreal drift : std::as_const(follower.drift)) {
+            distances.append(qAbs(drift));
+            sum += drift;
+        }
+        std::sort(distances.begin(), distances.end());
+        out << distances.size() << " measurements, mean " << sum / distances.size() << " px, 95th percentile "
+            << distances.at(qMin(distances.size() - 1, qsizetype(0.95 * distances.size()))) << " px, maximum " << distances.last() << " px\n";
+    }
+    return 0;
+}
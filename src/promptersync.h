@@ -0,0 +1,230 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef PROMPTERSYNC_H
+#define PROMPTERSYNC_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QString>
+#include <QTimer>
+#include <QUdpSocket>
+
+#include "documenthandler.h"
+
+class QQuickWindow;
+class QTextDocument;
+
+// Offset of a remote steady clock from the local one, estimated NTP style. Of the recent exchanges, the one with the
+// shortest round trip is trusted, as it had the least room for asymmetric delays.
+class ClockOffset
+{
+public:
+    // Request sent at t0 local time, received at t1 and answered at t2 remote time, answer received at t3 local time
+    void add(qint64 t0, qint64 t1, qint64 t2, qint64 t3);
+    void clear();
+    bool valid() const;
+    // Nanoseconds to add to local time to get remote time
+    qint64 offset() const;
+    qint64 delay() const;
+    int exchanges() const;
+
+private:
+    static constexpr int Window = 8;
+
+    struct Exchange {
+        qint64 offset;
+        qint64 delay;
+    };
+    QList<Exchange> m_exchanges;
+    int m_count = 0;
+};
+
+// Keeps prompters on several machines scrolling in lockstep. Followers subscribe to a leader, which sends them its
+// position, velocity and document revision ten times a second and on every jump or change of velocity. Followers don't
+// chase those packets: they align their clocks to the leader's and, every frame, steer toward where the leader is
+// extrapolated to be, snapping only across jumps.
+//
+// Positions are shared as the line at the reading line, which works across different fonts, sizes and window widths.
+// A line is given by the cursor position at its start, and the rest as a fraction of its height. Velocities are in
+// line heights per second.
+//
+// Datagrams start with "QPSY", a version and a type, followed by little endian fields:
+//   TimeRequest  t0, subscribe flag            TimeReply    t0, t1, t2
+//   State        timestamp, line, line offset, velocity, revision, prompting
+//   Probe        token                         ProbeReply   token, timestamp, position, velocity
+//   Subscribers                                SubscribersReply  count, then address and port of each follower
+// Timestamps are nanoseconds on the sender's steady clock. Probes answer in pixels, so the drift measured between
+// instances is what shows on screen when they share a layout.
+class PrompterSync : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(Role role READ role WRITE setRole NOTIFY roleChanged)
+    // Host of the leader, for followers
+    Q_PROPERTY(QString leader READ leader WRITE setLeader NOTIFY leaderChanged)
+    // Port the leader listens on
+    Q_PROPERTY(int port READ port WRITE setPort NOTIFY portChanged)
+    Q_PROPERTY(DocumentHandler *document READ document WRITE setDocument NOTIFY documentChanged)
+    // Flickable showing the document
+    Q_PROPERTY(QQuickItem *target READ target WRITE setTarget NOTIFY targetChanged)
+    // Distance from the top of the target to the reading line
+    Q_PROPERTY(qreal readOffset READ readOffset WRITE setReadOffset NOTIFY readOffsetChanged)
+    Q_PROPERTY(bool prompting READ prompting WRITE setPrompting NOTIFY promptingChanged)
+    // The leader's own velocity, in pixels per second
+    Q_PROPERTY(qreal leaderVelocity READ leaderVelocity WRITE setLeaderVelocity NOTIFY leaderVelocityChanged)
+    // Whether a follower is steering toward its leader
+    Q_PROPERTY(bool following READ following NOTIFY followingChanged)
+    // Whether a follower's document matches its leader's
+    Q_PROPERTY(bool documentMatches READ documentMatches NOTIFY documentMatchesChanged)
+    // Velocity a follower steers at, in pixels per second
+    Q_PROPERTY(qreal velocity READ velocity NOTIFY velocityChanged)
+    // Pixels a follower was behind its leader at the last frame
+    Q_PROPERTY(qreal drift READ drift NOTIFY driftChanged)
+    Q_PROPERTY(int followers READ followers NOTIFY followersChanged)
+
+public:
+    enum Role { Off, Leader, Follower };
+    Q_ENUM(Role)
+
+    explicit PrompterSync(QObject *parent = nullptr);
+
+    Role role() const;
+    void setRole(Role role);
+    QString leader() const;
+    void setLeader(const QString &leader);
+    int port() const;
+    void setPort(int port);
+    DocumentHandler *document() const;
+    void setDocument(DocumentHandler *document);
+    QQuickItem *target() const;
+    void setTarget(QQuickItem *target);
+    qreal readOffset() const;
+    void setReadOffset(qreal readOffset);
+    bool prompting() const;
+    void setPrompting(bool prompting);
+    qreal leaderVelocity() const;
+    void setLeaderVelocity(qreal leaderVelocity);
+    bool following() const;
+    bool documentMatches() const;
+    qreal velocity() const;
+    qreal drift() const;
+    int followers() const;
+
+    static qint64 now();
+
+    // Measures how far the followers of a leader at host:port are from it over a number of seconds, by probing all of
+    // them from a common clock, and prints the results. Returns a process exit code.
+    static int measureDrift(const QString &leader, int seconds);
+
+Q_SIGNALS:
+    void roleChanged();
+    void leaderChanged();
+    void portChanged();
+    void documentChanged();
+    void targetChanged();
+    void readOffsetChanged();
+    void promptingChanged();
+    void leaderVelocityChanged();
+    void followingChanged();
+    void documentMatchesChanged();
+    void velocityChanged();
+    void driftChanged();
+    void followersChanged();
+    void error(const QString &message);
+
+private:
+    enum MessageType : quint8 { TimeRequest = 1, TimeReply, State, Probe, ProbeReply, Subscribers, SubscribersReply };
+
+    struct Subscriber {
+        QHostAddress address;
+        quint16 port;
+        qint64 lastSeen;
+    };
+
+    struct LeaderState {
+        qint64 timestamp = 0;
+        qint32 line = 0;
+        qreal lineOffset = 0;
+        qreal velocity = 0;
+        quint32 revision = 0;
+        bool prompting = false;
+        // Local time of reception
+        qint64 received = 0;
+    };
+
+    void restart();
+    void read();
+    void synchronize();
+    void broadcast();
+    void windowChanged(QQuickWindow *window);
+    void frame();
+    void updateFollowing();
+    void setVelocity(qreal velocity);
+    quint32 revision();
+    QByteArray stateMessage();
+
+    Role m_role;
+    QString m_leader;
+    int m_port;
+    QPointer<DocumentHandler> m_document;
+    QPointer<QQuickItem> m_target;
+    QPointer<QQuickWindow> m_window;
+    qreal m_readOffset;
+    bool m_prompting;
+    qreal m_leaderVelocity;
+    bool m_following;
+    bool m_documentMatches;
+    qreal m_velocity;
+    qreal m_drift;
+
+    QUdpSocket m_socket;
+    // Sends states as a leader, and time requests as a follower
+    QTimer m_timer;
+
+    // Position at the last frame, and when it was prepared
+    qint64 m_frameTimestamp;
+    qreal m_framePosition;
+
+    // Leader
+    QList<Subscriber> m_subscribers;
+    qint64 m_sentTimestamp;
+    qreal m_sentPosition;
+    qreal m_sentVelocity;
+
+    // Follower
+    QHostAddress m_leaderAddress;
+    ClockOffset m_clock;
+    LeaderState m_state;
+
+    // Hash of the document's text, updated when it changes
+    QPointer<QTextDocument> m_textDocument;
+    bool m_revisionDirty;
+    quint32 m_revision;
+};
+
+#endif // PROMPTERSYNC_H
@@ -21,18 +21,37 @@
 
 #include "promptsession.h"
 
+#include <algorithm>
+
+#include "telemetry.h"
+
+// How long appended points may wait before views are updated, in milliseconds
+static constexpr int REFRESH_INTERVAL = 100;
+
 // #include <QDebug>
 SessionModel::SessionModel(QObject *parent)
     : QAbstractListModel(parent)
+    , m_partialPoints(0)
+    , m_points(0)
+    , m_firstTime(0)
+    , m_lastTime(0)
+    , m_minimumPosition(0)
+    , m_maximumPosition(0)
+    , m_windowStart(0)
+    , m_windowLength(0)
+    , m_follow(false)
+    , m_resolution(500)
 {
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(REFRESH_INTERVAL);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &SessionModel::refresh);
 }
 
 int SessionModel::rowCount(const QModelIndex &parent) const
 {
-    if (!parent.isValid())
-        return m_data.size();
-        //return 0;
-    return m_data.size();
+    if (parent.isValid())
+        return 0;
+    return m_view.size();
 }
 
 QVariant SessionModel::data(const QModelIndex &index, int role) const
@@ -40,17 +59,21 @@ QVariant SessionModel::data(const QModelIndex &index, int role) const
     if ( !index.isValid() )
         return QVariant();
 
-    const DataPoint &data = m_data.at(index.row());
+    const SessionNode &node = m_view.at(index.row());
     if ( role == TimeRole )
-        return data.time;
+        return (node.firstTime + node.lastTime) / 2;
     else if ( role == PositionRole )
-        return data.position;
+        return node.lastPosition;
+    else if ( role == MinimumPositionRole )
+        return node.minimumPosition;
+    else if ( role == MaximumPositionRole )
+        return node.maximumPosition;
     else if ( role == PrompterWidthRole )
-        return data.prompterWidth;
+        return node.prompterWidth;
     else if ( role == LineWidthRole )
-        return data.lineWidth;
+        return node.lineWidth;
     else if ( role == LineHeightRole )
-        return data.lineHeight;
+        return node.lineHeight;
     else
         return QVariant();
 }
@@ -61,6 +84,8 @@ QHash<int, QByteArray> SessionModel::roleNames() const
     static QHash<int, QByteArray> mapping {
         {TimeRole, "time"},
         {PositionRole, "position"},
+        {MinimumPositionRole, "minimumPosition"},
+        {MaximumPositionRole, "maximumPosition"},
         {PrompterWidthRole, "prompterWidth"},
         {LineWidthRole, "lineWidth"},
         {LineHeightRole, "lineHeight"}
@@ -68,9 +93,94 @@ QHash<int, QByteArray> SessionModel::roleNames() const
     return mapping;
 }
 
-void SessionModel::resetInternalData()
+int SessionModel::windowStart() const
+{
+    return m_windowStart;
+}
+
+void SessionModel::setWindowStart(int windowStart)
+{
+    if (windowStart == m_windowStart)
+        return;
+
+    m_windowStart = windowStart;
+    Q_EMIT windowChanged();
+    refresh();
+}
+
+int SessionModel::windowLength() const
 {
-    this->m_data.clear();
+    return m_windowLength;
+}
+
+void SessionModel::setWindowLength(int windowLength)
+{
+    if (windowLength == m_windowLength)
+        return;
+
+    m_windowLength = windowLength;
+    Q_EMIT windowChanged();
+    refresh();
+}
+
+bool SessionModel::follow() const
+{
+    return m_follow;
+}
+
+void SessionModel::setFollow(bool follow)
+{
+    if (follow == m_follow)
+        return;
+
+    m_follow = follow;
+    Q_EMIT windowChanged();
+    refresh();
+}
+
+int SessionModel::resolution() const
+{
+    return m_resolution;
+}
+
+void SessionModel::setResolution(int resolution)
+{
+    resolution = qMax(1, resolution);
+    if (resolution == m_resolution)
+        return;
+
+    m_resolution = resolution;
+    Q_EMIT resolutionChanged();
+    refresh();
+}
+
+int SessionModel::points() const
+{
+    return m_points;
+}
+
+int SessionModel::duration() const
+{
+    return m_lastTime - m_firstTime;
+}
+
+qreal SessionModel::minimumPosition() const
+{
+    return m_minimumPosition;
+}
+
+qreal SessionModel::maximumPosition() const
+{
+    return m_maximumPosition;
+}
+
+bool SessionModel::load(const QString &filePath)
+{
+    const QList<DataPoint> points = Telemetry::loadSession(filePath);
+    clearDataPoints();
+    appendDataPoints(points);
+    refresh();
+    return !points.isEmpty();
 }
 
 // void SessionModel::insertRow(int row, const QModelIndex &parent)
@@ -78,20 +188,152 @@ void SessionModel::resetInternalData()
 
 void SessionModel::clearDataPoints()
 {
-    beginRemoveRows(QModelIndex(), 0, rowCount());
-    this->resetInternalData();
-    endRemoveRows();
+    m_levels.clear();
+    m_partialPoints = 0;
+    m_points = 0;
+    m_firstTime = 0;
+    m_lastTime = 0;
+    m_minimumPosition = 0;
+    m_maximumPosition = 0;
+    refresh();
+    Q_EMIT pointsChanged();
+}
+
+void SessionModel::appendDataPoint(const DataPoint &data)
+{
+    append(data);
+    Q_EMIT pointsChanged();
+    if (!m_refreshTimer.isActive())
+        m_refreshTimer.start();
+}
+
+void SessionModel::appendDataPoints(const QList<DataPoint> &data)
+{
+    if (data.isEmpty())
+        return;
+
+    for (const DataPoint &point : data)
+        append(point);
+    Q_EMIT pointsChanged();
+    if (!m_refreshTimer.isActive())
+        m_refreshTimer.start();
+}
+
+void SessionModel::append(const DataPoint &data)
+{
+    SessionNode node;
+    node.firstTime = node.lastTime = data.time;
+    node.minimumPosition = node.maximumPosition = node.lastPosition = data.position;
+    node.prompterWidth = data.prompterWidth;
+    node.lineWidth = data.lineWidth;
+    node.lineHeight = data.lineHeight;
+
+    if (!m_points) {
+        m_firstTime = data.time;
+        m_minimumPosition = m_maximumPosition = data.position;
+    }
+    m_lastTime = data.time;
+    m_minimumPosition = qMin(m_minimumPosition, data.position);
+    m_maximumPosition = qMax(m_maximumPosition, data.position);
+    ++m_points;
+    if (m_partialPoints)
+        merge(m_partial, node);
+    else
+        m_partial = node;
+    if (++m_partialPoints == BaseNodeSize) {
+        appendNode(0, m_partial);
+        m_partialPoints = 0;
+    }
 }
 
-void SessionModel::appendDataPoint(DataPoint &data)
+void SessionModel::appendNode(int level, const SessionNode &node)
 {
-    const int listPosition = m_data.size();
-    beginInsertRows(QModelIndex(), listPosition, listPosition);
-    m_data.append(data);
-    endInsertRows();
+    if (m_levels.size() == level)
+        m_levels.append(QList<SessionNode>());
+    QList<SessionNode> &nodes = m_levels[level];
+    nodes.append(node);
+    if (nodes.size() % NodeFanout)
+        return;
+
+    SessionNode parent = nodes.at(nodes.size() - NodeFanout);
+    for (qsizetype i = nodes.size() - NodeFanout + 1; i < nodes.size(); i++)
+        merge(parent, nodes.at(i));
+    appendNode(level + 1, parent);
 }
 
-// Telemetry::Telemetry(QObject *parent)
-//     : QObject(parent)
-// {
-// }
+bool SessionModel::tail(int level, SessionNode &node) const
+{
+    if (level == 0) {
+        node = m_partial;
+        return m_partialPoints > 0;
+    }
+
+    const QList<SessionNode> &below = m_levels.at(level - 1);
+    bool found = false;
+    for (qsizetype i = (level < m_levels.size() ? m_levels.at(level).size() : 0) * NodeFanout; i < below.size(); i++) {
+        if (found)
+            merge(node, below.at(i));
+        else
+            node = below.at(i);
+        found = true;
+    }
+    SessionNode rest;
+    if (tail(level - 1, rest)) {
+        if (found)
+            merge(node, rest);
+        else
+            node = rest;
+        found = true;
+    }
+    return found;
+}
+
+void SessionModel::merge(SessionNode &node, const SessionNode &next)
+{
+    node.lastTime = next.lastTime;
+    node.minimumPosition = qMin(node.minimumPosition, next.minimumPosition);
+    node.maximumPosition = qMax(node.maximumPosition, next.maximumPosition);
+    node.lastPosition = next.lastPosition;
+    node.prompterWidth = next.prompterWidth;
+    node.lineWidth = next.lineWidth;
+    node.lineHeight = next.lineHeight;
+}
+
+void SessionModel::refresh()
+{
+    m_refreshTimer.stop();
+
+    int from = m_firstTime;
+    int to = m_lastTime;
+    if (m_windowLength > 0) {
+        from = m_follow ? m_lastTime - m_windowLength : m_windowStart;
+        to = from + m_windowLength;
+    }
+
+    // Coarsest level that still has as many nodes over the window as requested
+    int level = 0;
+    if (m_lastTime > m_firstTime) {
+        qreal nodeDuration = qreal(m_lastTime - m_firstTime) / m_points * BaseNodeSize * NodeFanout;
+        while (level + 1 < m_levels.size() && (to - from) / nodeDuration >= m_resolution) {
+            ++level;
+            nodeDuration *= NodeFanout;
+        }
+    }
+
+    QList<SessionNode> view;
+    if (level < m_levels.size()) {
+        const QList<SessionNode> &nodes = m_levels.at(level);
+        auto node = std::lower_bound(nodes.cbegin(), nodes.cend(), from, [](const SessionNode &node, int time) {
+            return node.lastTime < time;
+        });
+        for (; node != nodes.cend() && node->firstTime <= to; ++node)
+            view.append(*node);
+    }
+    SessionNode last;
+    if (tail(level, last) && last.lastTime >= from && last.firstTime <= to)
+        view.append(last);
+
+    beginResetModel();
+    m_view.swap(view);
+    endResetModel();
+}
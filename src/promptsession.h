@@ -23,6 +23,9 @@
 #define PROMPTSESSION_H
 
 #include <QAbstractListModel>
+#include <QList>
+#include <QQmlEngine>
+#include <QTimer>
 
 struct DataPoint {
     Q_GADGET
@@ -41,14 +44,46 @@ struct DataPoint {
 };
 Q_DECLARE_METATYPE(DataPoint)
 
+// Summary of consecutive data points, keeping the extremes of their positions so plots don't lose peaks.
+struct SessionNode {
+    int firstTime = 0;
+    int lastTime = 0;
+    float minimumPosition = 0;
+    float maximumPosition = 0;
+    float lastPosition = 0;
+    int prompterWidth = 0;
+    int lineWidth = 0;
+    int lineHeight = 0;
+};
+
+// Serves a session at the resolution a view asks for. Data points are summarized into a pyramid of nodes, where each
+// level holds a node per NodeFanout nodes of the level below and the base holds a node per BaseNodeSize points. Rows
+// are the nodes of the coarsest level that still gives the requested resolution over the visible window, so views
+// get O(resolution) rows regardless of the session's length. Points themselves aren't kept; they stay in the session
+// file.
 class SessionModel : public QAbstractListModel
 {
     Q_OBJECT
+    QML_ELEMENT
+
+    // Visible window, in milliseconds. A length of 0 shows the whole session.
+    Q_PROPERTY(int windowStart READ windowStart WRITE setWindowStart NOTIFY windowChanged)
+    Q_PROPERTY(int windowLength READ windowLength WRITE setWindowLength NOTIFY windowChanged)
+    // Keep the window at the end of the session as points are appended
+    Q_PROPERTY(bool follow READ follow WRITE setFollow NOTIFY windowChanged)
+    // Rows wanted over the visible window. Up to NodeFanout times as many may be given.
+    Q_PROPERTY(int resolution READ resolution WRITE setResolution NOTIFY resolutionChanged)
+    Q_PROPERTY(int points READ points NOTIFY pointsChanged)
+    Q_PROPERTY(int duration READ duration NOTIFY pointsChanged)
+    Q_PROPERTY(qreal minimumPosition READ minimumPosition NOTIFY pointsChanged)
+    Q_PROPERTY(qreal maximumPosition READ maximumPosition NOTIFY pointsChanged)
 
 public:
     enum Roles {
-        TimeRole,
-        PositionRole = Qt::UserRole,
+        TimeRole = Qt::UserRole,
+        PositionRole,
+        MinimumPositionRole,
+        MaximumPositionRole,
         PrompterWidthRole,
         LineWidthRole,
         LineHeightRole
@@ -63,25 +98,62 @@ public:
 
     QHash<int, QByteArray> roleNames() const override;
 
-    bool dirty;
+    int windowStart() const;
+    void setWindowStart(int windowStart);
+    int windowLength() const;
+    void setWindowLength(int windowLength);
+    bool follow() const;
+    void setFollow(bool follow);
+    int resolution() const;
+    void setResolution(int resolution);
+    int points() const;
+    int duration() const;
+    qreal minimumPosition() const;
+    qreal maximumPosition() const;
+
+    // Replaces the model's contents with a recorded session.
+    Q_INVOKABLE bool load(const QString &filePath);
 
 public slots:
 //     void insertRow(int row, const QModelIndex &parent);
     void clearDataPoints();
-    void appendDataPoint(DataPoint &data);
+    void appendDataPoint(const DataPoint &data);
+    void appendDataPoints(const QList<DataPoint> &data);
 
+Q_SIGNALS:
+    void windowChanged();
+    void resolutionChanged();
+    void pointsChanged();
 
 private slots:
-    void resetInternalData();
+    void refresh();
 
 private:
-    QList <DataPoint> m_data;
+    static constexpr int BaseNodeSize = 8;
+    static constexpr int NodeFanout = 4;
+
+    void append(const DataPoint &data);
+    void appendNode(int level, const SessionNode &node);
+    // Summary of the points after the last node of a level, if any
+    bool tail(int level, SessionNode &node) const;
+    static void merge(SessionNode &node, const SessionNode &next);
+
+    QList<QList<SessionNode>> m_levels;
+    SessionNode m_partial;
+    int m_partialPoints;
+    int m_points;
+    int m_firstTime;
+    int m_lastTime;
+    qreal m_minimumPosition;
+    qreal m_maximumPosition;
+
+    int m_windowStart;
+    int m_windowLength;
+    bool m_follow;
+    int m_resolution;
+    QList<SessionNode> m_view;
+    // Coalesces refreshes while points are appended
+    QTimer m_refreshTimer;
 };
 
-
-// class Telemetry : public QObject
-// {
-// Q_OBJECT
-// };
-
 #endif // PROMPTSESSION_H
@@ -0,0 +1,819 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+#include "remotecontrol.h"
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QNetworkInterface>
+#include <QQuickWindow>
+#include <QRandomGenerator>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QUrl>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+
+#include "markersmodel.h"
+
+static constexpr int DEFAULT_PORT = 8780;
+// Largest frame accepted from clients. Commands take a few bytes, so extended payload lengths are never needed.
+static constexpr int MAX_FRAME_PAYLOAD = 125;
+static constexpr int MAX_REQUEST_SIZE = 8192;
+static constexpr char WEBSOCKET_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+static constexpr quint8 BINARY_FRAME = 0x2;
+static constexpr quint8 CLOSE_FRAME = 0x8;
+static constexpr quint8 PING_FRAME = 0x9;
+static constexpr quint8 PONG_FRAME = 0xA;
+
+static const char CONTROL_PAGE[] = R"html(<!DOCTYPE html>
+<html>
+<head>
+<meta charset="utf-8">
+<meta name="viewport" content="width=device-width, initial-scale=1">
+<title>QPrompt Remote</title>
+<style>
+body { font-family: sans-serif; background: #222; color: #eee; margin: 1em; text-align: center; }
+button { font-size: 1.5em; min-width: 3.5em; margin: 0.2em; padding: 0.4em; }
+input { width: 100%; margin-top: 1em; }
+#state { font-size: 1.2em; margin: 1em 0; }
+#velocity { display: inline-block; min-width: 2em; font-size: 1.5em; }
+</style>
+</head>
+<body>
+<div id="state">Connecting</div>
+<div><button data-marker="-1">&#x23EE;</button><button id="pause">&#x23EF;</button><button data-marker="1">&#x23ED;</button></div>
+<div><button data-step="-1">&minus;</button><span id="velocity">0</span><button data-step="1">+</button></div>
+<input id="progress" type="range" min="0" max="1000" value="0">
+<script>
+let socket, velocity = 0, markers = [], seeking = false;
+const progress = document.getElementById("progress");
+function send(type, size, write) {
+    const view = new DataView(new ArrayBuffer(1 + size));
+    view.setUint8(0, type);
+    write(view);
+    if (socket && socket.readyState === WebSocket.OPEN)
+        socket.send(view.buffer);
+}
+function connect() {
+    socket = new WebSocket("ws://" + location.host + "/control");
+    socket.binaryType = "arraybuffer";
+    socket.onmessage = function (event) {
+        const view = new DataView(event.data);
+        if (view.getUint8(0) === 0x80) {
+            const flags = view.getUint8(1), marker = view.getInt32(4, true), remaining = view.getFloat32(16, true);
+            velocity = view.getInt8(2);
+            document.getElementById("velocity").textContent = velocity;
+            if (!seeking)
+                progress.value = view.getFloat32(12, true) * 1000;
+            let text = !(flags & 1) ? "Editing" : (flags & 2) ? "Prompting" : "Paused";
+            if (marker >= 0 && marker < markers.length)
+                text += " - " + markers[marker];
+            if (remaining >= 0)
+                text += " - " + Math.floor(remaining / 60) + ":" + String(Math.floor(remaining % 60)).padStart(2, "0");
+            document.getElementById("state").textContent = text;
+        }
+        else if (view.getUint8(0) === 0x81) {
+            const decoder = new TextDecoder();
+            markers = [];
+            for (let i = view.getUint16(1, true), offset = 3; i > 0; i--) {
+                const length = view.getUint16(offset, true);
+                markers.push(decoder.decode(new Uint8Array(event.data, offset + 2, length)));
+                offset += 2 + length;
+            }
+        }
+    };
+    socket.onclose = function () {
+        document.getElementById("state").textContent = "Disconnected";
+        setTimeout(connect, 1000);
+    };
+}
+document.querySelectorAll("[data-step]").forEach(function (button) {
+    button.onclick = function () {
+        send(0x01, 1, function (view) { view.setInt8(1, velocity + parseInt(button.dataset.step)); });
+    };
+});
+document.querySelectorAll("[data-marker]").forEach(function (button) {
+    button.onclick = function () {
+        send(0x03, 1, function (view) { view.setInt8(1, parseInt(button.dataset.marker)); });
+    };
+});
+document.getElementById("pause").onclick = function () {
+    send(0x02, 1, function (view) { view.setUint8(1, 2); });
+};
+progress.oninput = function () {
+    seeking = true;
+    send(0x04, 4, function (view) { view.setFloat32(1, progress.value / 1000, true); });
+};
+progress.onchange = function () {
+    seeking = false;
+};
+connect();
+</script>
+</body>
+</html>
+)html";
+
+namespace
+{
+// Frames from clients must be masked, frames from servers must not.
+QByteArray websocketFrame(quint8 opcode, const QByteArray &payload, bool masked = false)
+{
+    QByteArray frame;
+    frame.reserve(payload.size() + 14);
+    frame.append(char(0x80 | opcode));
+    const char mask = masked ? char(0x80) : char(0);
+    if (payload.size() < 126)
+        frame.append(char(mask | char(payload.size())));
+    else if (payload.size() <= 0xFFFF) {
+        char length[2];
+        qToBigEndian<quint16>(quint16(payload.size()), length);
+        frame.append(char(mask | 126)).append(length, 2);
+    }
+    else {
+        char length[8];
+        qToBigEndian<quint64>(quint64(payload.size()), length);
+        frame.append(char(mask | 127)).append(length, 8);
+    }
+    if (!masked)
+        return frame.append(payload);
+
+    char key[4];
+    qToLittleEndian<quint32>(QRandomGenerator::global()->generate(), key);
+    frame.append(key, 4);
+    for (qsizetype i = 0; i < payload.size(); i++)
+        frame.append(char(payload.at(i) ^ key[i % 4]));
+    return frame;
+}
+}
+
+RemoteControl::RemoteControl(QObject *parent)
+    : QObject(parent)
+    , m_active(false)
+    , m_address(QStringLiteral("127.0.0.1"))
+    , m_port(DEFAULT_PORT)
+    , m_readOffset(0)
+    , m_end(0)
+    , m_velocity(0)
+    , m_playing(false)
+    , m_prompting(false)
+    , m_remaining(-1)
+    , m_frameRequested(false)
+    , m_markersDirty(true)
+    , m_lastReadY(qQNaN())
+    , m_marker(-1)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &RemoteControl::connection);
+}
+
+RemoteControl::~RemoteControl()
+{
+    // Sockets are destroyed along with the server, after the members tracking them.
+    const QList<QTcpSocket *> sockets = m_pending.keys();
+    for (QTcpSocket *socket : sockets) {
+        socket->disconnect(this);
+        socket->abort();
+    }
+}
+
+bool RemoteControl::active() const
+{
+    return m_active;
+}
+
+void RemoteControl::setActive(bool active)
+{
+    if (active == m_active)
+        return;
+
+    m_active = active;
+    if (m_active)
+        listen();
+    else
+        close();
+    Q_EMIT activeChanged();
+}
+
+QString RemoteControl::address() const
+{
+    return m_address;
+}
+
+void RemoteControl::setAddress(const QString &address)
+{
+    if (address == m_address)
+        return;
+
+    m_address = address;
+    if (m_active) {
+        close();
+        listen();
+    }
+    Q_EMIT addressChanged();
+}
+
+int RemoteControl::port() const
+{
+    return m_port;
+}
+
+void RemoteControl::setPort(int port)
+{
+    if (port == m_port)
+        return;
+
+    m_port = port;
+    if (m_active) {
+        close();
+        listen();
+    }
+    Q_EMIT portChanged();
+}
+
+bool RemoteControl::listening() const
+{
+    return m_server.isListening();
+}
+
+QString RemoteControl::url() const
+{
+    if (!m_server.isListening())
+        return QString();
+
+    QHostAddress host = m_server.serverAddress();
+    if (host == QHostAddress::AnyIPv4 || host == QHostAddress::Any) {
+        const QStringList addresses = availableAddresses();
+        host = QHostAddress(addresses.size() > 2 ? addresses.at(1) : addresses.first());
+    }
+    return QStringLiteral("http://%1:%2/").arg(host.toString()).arg(m_server.serverPort());
+}
+
+int RemoteControl::clients() const
+{
+    return int(m_clients.size());
+}
+
+DocumentHandler *RemoteControl::document() const
+{
+    return m_document;
+}
+
+void RemoteControl::setDocument(DocumentHandler *document)
+{
+    if (document == m_document)
+        return;
+
+    if (m_document)
+        disconnect(m_document->markers(), nullptr, this, nullptr);
+    m_document = document;
+    if (m_document) {
+        MarkersModel *markers = m_document->markers();
+        connect(markers, &QAbstractItemModel::rowsInserted, this, &RemoteControl::markersChanged);
+        connect(markers, &QAbstractItemModel::rowsRemoved, this, &RemoteControl::markersChanged);
+        connect(markers, &QAbstractItemModel::modelReset, this, &RemoteControl::markersChanged);
+        connect(markers, &QAbstractItemModel::dataChanged, this, &RemoteControl::markersChanged);
+    }
+    markersChanged();
+    Q_EMIT documentChanged();
+}
+
+QQuickItem *RemoteControl::target() const
+{
+    return m_target;
+}
+
+void RemoteControl::setTarget(QQuickItem *target)
+{
+    if (target == m_target)
+        return;
+
+    if (m_target)
+        disconnect(m_target, &QQuickItem::windowChanged, this, &RemoteControl::windowChanged);
+    m_target = target;
+    if (m_target)
+        connect(m_target, &QQuickItem::windowChanged, this, &RemoteControl::windowChanged);
+    windowChanged(m_target ? m_target->window() : nullptr);
+    Q_EMIT targetChanged();
+}
+
+qreal RemoteControl::readOffset() const
+{
+    return m_readOffset;
+}
+
+void RemoteControl::setReadOffset(qreal readOffset)
+{
+    if (qFuzzyCompare(readOffset, m_readOffset))
+        return;
+
+    m_readOffset = readOffset;
+    requestFrame();
+    Q_EMIT stateChanged();
+}
+
+qreal RemoteControl::end() const
+{
+    return m_end;
+}
+
+void RemoteControl::setEnd(qreal end)
+{
+    if (qFuzzyCompare(end, m_end))
+        return;
+
+    m_end = end;
+    requestFrame();
+    Q_EMIT stateChanged();
+}
+
+int RemoteControl::velocity() const
+{
+    return m_velocity;
+}
+
+void RemoteControl::setVelocity(int velocity)
+{
+    if (velocity == m_velocity)
+        return;
+
+    m_velocity = velocity;
+    requestFrame();
+    Q_EMIT stateChanged();
+}
+
+bool RemoteControl::playing() const
+{
+    return m_playing;
+}
+
+void RemoteControl::setPlaying(bool playing)
+{
+    if (playing == m_playing)
+        return;
+
+    m_playing = playing;
+    requestFrame();
+    Q_EMIT stateChanged();
+}
+
+bool RemoteControl::prompting() const
+{
+    return m_prompting;
+}
+
+void RemoteControl::setPrompting(bool prompting)
+{
+    if (prompting == m_prompting)
+        return;
+
+    m_prompting = prompting;
+    requestFrame();
+    Q_EMIT stateChanged();
+}
+
+qreal RemoteControl::remaining() const
+{
+    return m_remaining;
+}
+
+void RemoteControl::setRemaining(qreal remaining)
+{
+    // Only whole seconds are shown
+    if (std::floor(remaining) == std::floor(m_remaining))
+        return;
+
+    m_remaining = remaining;
+    requestFrame();
+    Q_EMIT stateChanged();
+}
+
+QStringList RemoteControl::availableAddresses()
+{
+    QStringList addresses = {QStringLiteral("127.0.0.1")};
+    const QList<QHostAddress> interfaces = QNetworkInterface::allAddresses();
+    for (const QHostAddress &address : interfaces)
+        if (address.protocol() == QAbstractSocket::IPv4Protocol && !address.isLoopback())
+            addresses.append(address.toString());
+    addresses.append(QStringLiteral("0.0.0.0"));
+    return addresses;
+}
+
+void RemoteControl::listen()
+{
+    const QHostAddress address(m_address);
+    if (address.isNull() || !m_server.listen(address, quint16(m_port)))
+        Q_EMIT error(tr("Cannot listen for remote control on %1:%2").arg(m_address).arg(m_port));
+    Q_EMIT listeningChanged();
+}
+
+void RemoteControl::close()
+{
+    const QList<QTcpSocket *> sockets = m_pending.keys();
+    for (QTcpSocket *socket : sockets) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+    m_pending.clear();
+    m_clients.clear();
+    m_pings.clear();
+    m_server.close();
+    Q_EMIT listeningChanged();
+    Q_EMIT clientsChanged();
+}
+
+void RemoteControl::connection()
+{
+    while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+        // Messages are a few bytes each, don't let Nagle's algorithm hold them back.
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        m_pending.insert(socket, QByteArray());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            read(socket);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            disconnected(socket);
+        });
+    }
+}
+
+void RemoteControl::read(QTcpSocket *socket)
+{
+    QByteArray &pending = m_pending[socket];
+    pending.append(socket->readAll());
+    if (m_clients.contains(socket)) {
+        receive(socket);
+        return;
+    }
+
+    const qsizetype end = pending.indexOf("\r\n\r\n");
+    if (end < 0) {
+        if (pending.size() > MAX_REQUEST_SIZE)
+            socket->abort();
+        return;
+    }
+    const QByteArray request = pending.left(end);
+    pending.remove(0, end + 4);
+    respond(socket, request);
+    if (m_clients.contains(socket))
+        receive(socket);
+}
+
+void RemoteControl::respond(QTcpSocket *socket, const QByteArray &request)
+{
+    const QList<QByteArray> lines = request.split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    const QByteArray method = requestLine.value(0);
+    const QByteArray path = requestLine.value(1);
+    QHash<QByteArray, QByteArray> headers;
+    for (qsizetype i = 1; i < lines.size(); i++) {
+        const qsizetype separator = lines.at(i).indexOf(':');
+        if (separator > 0)
+            headers.insert(lines.at(i).left(separator).trimmed().toLower(), lines.at(i).mid(separator + 1).trimmed());
+    }
+
+    if (method == "GET" && path == "/control" && headers.value("upgrade").toLower() == "websocket" && headers.contains("sec-websocket-key")) {
+        // Browsers send the page's origin with every WebSocket upgrade, and let any page connect anywhere. Only the page
+        // served here may drive the prompter, or any site open in the operator's browser could, loopback or not.
+        // Clients that aren't browsers send no origin.
+        if (headers.contains("origin") && headers.value("origin").toLower() != "http://" + headers.value("host").toLower()) {
+            const QByteArray body = "Forbidden\n";
+            socket->write("HTTP/1.1 403 Forbidden\r\nContent-Type: text/plain\r\nContent-Length: " + QByteArray::number(body.size())
+                          + "\r\nConnection: close\r\n\r\n" + body);
+            socket->disconnectFromHost();
+            return;
+        }
+        const QByteArray accept = QCryptographicHash::hash(headers.value("sec-websocket-key") + WEBSOCKET_GUID, QCryptographicHash::Sha1).toBase64();
+        socket->write("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: " + accept + "\r\n\r\n");
+        m_clients.append(socket);
+        // Markers pending an update go to everyone with the next frame
+        if (!m_markersDirty)
+            send(socket, m_markersMessage);
+        // Have the next frame send the state to everyone, the new client included
+        m_lastState.clear();
+        requestFrame();
+        Q_EMIT clientsChanged();
+        return;
+    }
+
+    QByteArray status = "404 Not Found";
+    QByteArray type = "text/plain";
+    QByteArray body = "Not found\n";
+    if (method == "GET" && (path == "/" || path == "/index.html")) {
+        status = "200 OK";
+        type = "text/html; charset=utf-8";
+        body = CONTROL_PAGE;
+    }
+    socket->write("HTTP/1.1 " + status + "\r\nContent-Type: " + type + "\r\nContent-Length: " + QByteArray::number(body.size())
+                  + "\r\nCache-Control: no-store\r\nConnection: close\r\n\r\n" + body);
+    socket->disconnectFromHost();
+}
+
+void RemoteControl::receive(QTcpSocket *socket)
+{
+    QByteArray &pending = m_pending[socket];
+    while (pending.size() >= 2) {
+        const quint8 opcode = quint8(pending.at(0)) & 0x0F;
+        const bool masked = quint8(pending.at(1)) & 0x80;
+        const int length = quint8(pending.at(1)) & 0x7F;
+        if (!masked || length > MAX_FRAME_PAYLOAD) {
+            socket->abort();
+            return;
+        }
+        if (pending.size() < 6 + length)
+            return;
+
+        QByteArray payload = pending.mid(6, length);
+        for (int i = 0; i < length; i++)
+            payload[i] = char(payload.at(i) ^ pending.at(2 + i % 4));
+        pending.remove(0, 6 + length);
+
+        switch (opcode) {
+        case BINARY_FRAME:
+            command(socket, payload);
+            break;
+        case CLOSE_FRAME:
+            socket->write(websocketFrame(CLOSE_FRAME, payload.left(2)));
+            socket->disconnectFromHost();
+            return;
+        case PING_FRAME:
+            socket->write(websocketFrame(PONG_FRAME, payload));
+            break;
+        default:
+            // Text and continuation frames carry no commands
+            break;
+        }
+    }
+}
+
+void RemoteControl::command(QTcpSocket *socket, const QByteArray &payload)
+{
+    if (payload.size() < 2)
+        return;
+
+    const char *data = payload.constData();
+    switch (quint8(data[0])) {
+    case VelocityCommand:
+        Q_EMIT velocityRequested(qint8(data[1]));
+        break;
+    case PauseCommand:
+        Q_EMIT pauseRequested(quint8(data[1]) == 2 ? m_playing : quint8(data[1]) == 1);
+        break;
+    case MarkerCommand:
+        if (data[1])
+            Q_EMIT markerRequested(qint8(data[1]));
+        break;
+    case GoToCommand:
+        if (payload.size() >= 5) {
+            const float progress = qFromLittleEndian<float>(data + 1);
+            if (std::isfinite(progress))
+                Q_EMIT goToRequested(qBound<qreal>(0, progress, 1));
+        }
+        break;
+    case PingCommand:
+        if (payload.size() >= 5)
+            m_pings.append({socket, qFromLittleEndian<quint32>(data + 1)});
+        break;
+    default:
+        break;
+    }
+    requestFrame();
+}
+
+void RemoteControl::disconnected(QTcpSocket *socket)
+{
+    m_pending.remove(socket);
+    m_pings.removeIf([socket](const QPair<QTcpSocket *, quint32> &ping) {
+        return ping.first == socket;
+    });
+    if (m_clients.removeOne(socket))
+        Q_EMIT clientsChanged();
+    socket->deleteLater();
+}
+
+void RemoteControl::markersChanged()
+{
+    m_markersDirty = true;
+    requestFrame();
+}
+
+void RemoteControl::windowChanged(QQuickWindow *window)
+{
+    if (window == m_window)
+        return;
+
+    if (m_window)
+        disconnect(m_window, &QQuickWindow::afterAnimating, this, &RemoteControl::frame);
+    m_window = window;
+    if (m_window)
+        connect(m_window, &QQuickWindow::afterAnimating, this, &RemoteControl::frame);
+}
+
+void RemoteControl::requestFrame()
+{
+    if (m_frameRequested || m_clients.isEmpty())
+        return;
+
+    m_frameRequested = true;
+    // Hidden windows don't render, so nothing would be sent until they're shown again.
+    if (m_window && m_window->isExposed())
+        m_window->update();
+    else
+        QMetaObject::invokeMethod(this, &RemoteControl::frame, Qt::QueuedConnection);
+}
+
+// Sends whatever changed since the last frame, in one message per kind
+void RemoteControl::frame()
+{
+    m_frameRequested = false;
+    if (m_clients.isEmpty())
+        return;
+
+    if (m_markersDirty) {
+        m_markersDirty = false;
+        indexMarkers();
+        for (QTcpSocket *client : std::as_const(m_clients))
+            send(client, m_markersMessage);
+        m_lastReadY = qQNaN();
+    }
+
+    const qreal position = m_target ? m_target->property("contentY").toReal() : 0;
+    const qreal readY = position + m_readOffset;
+    if (readY != m_lastReadY) {
+        m_lastReadY = readY;
+        m_marker = currentMarker(readY);
+    }
+
+    QByteArray state(20, 0);
+    char *data = state.data();
+    data[0] = char(StateMessage);
+    data[1] = char((m_prompting ? 1 : 0) | (m_playing ? 2 : 0));
+    data[2] = char(qBound(-128, m_velocity, 127));
+    qToLittleEndian<qint32>(m_marker, data + 4);
+    qToLittleEndian<float>(float(position), data + 8);
+    qToLittleEndian<float>(float(m_end > 0 ? qBound<qreal>(0, position / m_end, 1) : 0), data + 12);
+    qToLittleEndian<float>(float(std::isfinite(m_remaining) && m_remaining >= 0 ? m_remaining : -1), data + 16);
+    if (state != m_lastState) {
+        m_lastState = state;
+        for (QTcpSocket *client : std::as_const(m_clients))
+            send(client, state);
+    }
+
+    for (const auto &ping : std::as_const(m_pings)) {
+        QByteArray pong(5, 0);
+        pong[0] = char(PongMessage);
+        qToLittleEndian<quint32>(ping.second, pong.data() + 1);
+        send(ping.first, pong);
+    }
+    m_pings.clear();
+}
+
+void RemoteControl::indexMarkers()
+{
+    m_markerPositions.clear();
+    m_markersMessage = QByteArray(3, 0);
+    m_markersMessage[0] = char(MarkersMessage);
+    MarkersModel *markers = m_document ? m_document->markers() : nullptr;
+    const int count = markers ? qMin(markers->rowCount(), 0xFFFF) : 0;
+    for (int row = 0; row < count; row++) {
+        const QModelIndex index = markers->index(row);
+        m_markerPositions.append(markers->data(index, MarkersModel::PositionRole).toInt());
+        const QByteArray name = markers->data(index, MarkersModel::TextRole).toString().toUtf8().left(0xFFFF);
+        char length[2];
+        qToLittleEndian<quint16>(quint16(name.size()), length);
+        m_markersMessage.append(length, 2).append(name);
+    }
+    qToLittleEndian<quint16>(quint16(count), m_markersMessage.data() + 1);
+}
+
+// Index of the last marker at or above the reading line, found without laying out every marker
+int RemoteControl::currentMarker(qreal readY) const
+{
+    if (!m_document)
+        return -1;
+
+    const auto passed = std::partition_point(m_markerPositions.cbegin(), m_markerPositions.cend(), [this, readY](int position) {
+        return m_document->cursorY(position) <= readY;
+    });
+    return int(passed - m_markerPositions.cbegin()) - 1;
+}
+
+void RemoteControl::send(QTcpSocket *socket, const QByteArray &message)
+{
+    socket->write(websocketFrame(BINARY_FRAME, message));
+}
+
+int RemoteControl::benchmark(const QString &url, int count)
+{
+    QTextStream out(stdout);
+    const QUrl address(url);
+    QTcpSocket socket;
+    socket.connectToHost(address.host(), quint16(address.port(DEFAULT_PORT)));
+    if (!socket.waitForConnected(5000)) {
+        out << "Cannot connect to " << url << ": " << socket.errorString() << '\n';
+        return 1;
+    }
+    socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    const QByteArray key = QByteArray::number(QRandomGenerator::global()->generate64()).toBase64();
+    const QByteArray path = address.path().isEmpty() || address.path() == QStringLiteral("/") ? QByteArray("/control") : address.path().toUtf8();
+    socket.write("GET " + path + " HTTP/1.1\r\nHost: " + address.host().toUtf8() + "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: " + key
+                 + "\r\nSec-WebSocket-Version: 13\r\n\r\n");
+    QByteArray received;
+    while (!received.contains("\r\n\r\n")) {
+        if (!socket.waitForReadyRead(5000)) {
+            out << "No handshake from " << url << '\n';
+            return 1;
+        }
+        received.append(socket.readAll());
+    }
+    if (!received.startsWith("HTTP/1.1 101")) {
+        out << "Handshake refused by " << url << '\n';
+        return 1;
+    }
+    received.remove(0, received.indexOf("\r\n\r\n") + 4);
+
+    // Round trips from sending a ping to receiving its pong, which waits for the next broadcast like any command's effect
+    QList<qint64> latencies;
+    latencies.reserve(count);
+    QElapsedTimer clock;
+    for (quint32 token = 0; token < quint32(count); token++) {
+        QByteArray ping(5, 0);
+        ping[0] = char(PingCommand);
+        qToLittleEndian<quint32>(token, ping.data() + 1);
+        clock.start();
+        socket.write(websocketFrame(BINARY_FRAME, ping, true));
+        socket.flush();
+
+        bool ponged = false;
+        while (!ponged) {
+            while (!ponged && received.size() >= 2) {
+                qsizetype length = quint8(received.at(1)) & 0x7F;
+                int header = 2;
+                if (length == 126) {
+                    if (received.size() < 4)
+                        break;
+                    length = qFromBigEndian<quint16>(received.constData() + 2);
+                    header = 4;
+                }
+                else if (length == 127) {
+                    if (received.size() < 10)
+                        break;
+                    length = qsizetype(qFromBigEndian<quint64>(received.constData() + 2));
+                    header = 10;
+                }
+                if (received.size() < header + length)
+                    break;
+                const QByteArray payload = received.mid(header, length);
+                received.remove(0, header + length);
+                if (payload.size() == 5 && quint8(payload.at(0)) == PongMessage && qFromLittleEndian<quint32>(payload.constData() + 1) == token) {
+                    latencies.append(clock.nsecsElapsed());
+                    ponged = true;
+                }
+            }
+            if (!ponged) {
+                if (!socket.waitForReadyRead(5000)) {
+                    out << "No reply from " << url << '\n';
+                    return 1;
+                }
+                received.append(socket.readAll());
+            }
+        }
+    }
+    socket.disconnectFromHost();
+
+    if (latencies.isEmpty())
+        return 0;
+    std::sort(latencies.begin(), latencies.end());
+    const auto milliseconds = [&latencies](qreal quantile) {
+        return latencies.at(qMin(latencies.size() - 1, qsizetype(quantile * latencies.size()))) / 1e6;
+    };
+    out << "Round trips: " << latencies.size() << '\n';
+    out << "Minimum: " << milliseconds(0) << " ms\n";
+    out << "Median: " << milliseconds(0.5) << " ms\n";
+    out << "95th percentile: " << milliseconds(0.95) << " ms\n";
+    out << "Maximum: " << milliseconds(1) << " ms\n";
+    return 0;
+}
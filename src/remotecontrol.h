@@ -0,0 +1,190 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef REMOTECONTROL_H
+#define REMOTECONTROL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QObject>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QString>
+#include <QStringList>
+#include <QTcpServer>
+
+#include "documenthandler.h"
+
+class QQuickWindow;
+class QTcpSocket;
+
+// Lets operators drive the prompter from other devices. One port serves a small control page over HTTP and a WebSocket
+// at /control, which takes binary commands and broadcasts the prompter's state at most once per frame. Commands are
+// decoded here and reach QML as typed signals.
+//
+// Commands, one per binary message from clients:
+//   0x01 velocity  int8 velocity step
+//   0x02 pause     uint8 0 to resume, 1 to pause, 2 to toggle
+//   0x03 marker    int8 markers to move by, negative to go back
+//   0x04 goTo      float32 progress through the script, from 0 to 1
+//   0x05 ping      uint32 token, echoed once the next state is broadcast
+// Messages to clients:
+//   0x80 state     uint8 flags (1 prompting, 2 playing), int8 velocity step, uint8 0, int32 current marker (-1 before
+//                  the first), float32 position in pixels, float32 progress, float32 remaining seconds (-1 if unknown)
+//   0x81 markers   uint16 count, then each marker's name as uint16 byte length and UTF-8
+//   0x82 pong      uint32 token
+// Numbers are little endian.
+class RemoteControl : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    // Interface to listen on
+    Q_PROPERTY(QString address READ address WRITE setAddress NOTIFY addressChanged)
+    Q_PROPERTY(int port READ port WRITE setPort NOTIFY portChanged)
+    Q_PROPERTY(bool listening READ listening NOTIFY listeningChanged)
+    // Address of the control page, once listening
+    Q_PROPERTY(QString url READ url NOTIFY listeningChanged)
+    Q_PROPERTY(int clients READ clients NOTIFY clientsChanged)
+
+    Q_PROPERTY(DocumentHandler *document READ document WRITE setDocument NOTIFY documentChanged)
+    // Flickable showing the document
+    Q_PROPERTY(QQuickItem *target READ target WRITE setTarget NOTIFY targetChanged)
+    // Distance from the top of the target to the middle of the reading region
+    Q_PROPERTY(qreal readOffset READ readOffset WRITE setReadOffset NOTIFY stateChanged)
+    // Position at which the script ends
+    Q_PROPERTY(qreal end READ end WRITE setEnd NOTIFY stateChanged)
+    Q_PROPERTY(int velocity READ velocity WRITE setVelocity NOTIFY stateChanged)
+    Q_PROPERTY(bool playing READ playing WRITE setPlaying NOTIFY stateChanged)
+    Q_PROPERTY(bool prompting READ prompting WRITE setPrompting NOTIFY stateChanged)
+    // Seconds until the end is reached, negative when unknown
+    Q_PROPERTY(qreal remaining READ remaining WRITE setRemaining NOTIFY stateChanged)
+
+public:
+    explicit RemoteControl(QObject *parent = nullptr);
+    ~RemoteControl();
+
+    bool active() const;
+    void setActive(bool active);
+    QString address() const;
+    void setAddress(const QString &address);
+    int port() const;
+    void setPort(int port);
+    bool listening() const;
+    QString url() const;
+    int clients() const;
+
+    DocumentHandler *document() const;
+    void setDocument(DocumentHandler *document);
+    QQuickItem *target() const;
+    void setTarget(QQuickItem *target);
+    qreal readOffset() const;
+    void setReadOffset(qreal readOffset);
+    qreal end() const;
+    void setEnd(qreal end);
+    int velocity() const;
+    void setVelocity(int velocity);
+    bool playing() const;
+    void setPlaying(bool playing);
+    bool prompting() const;
+    void setPrompting(bool prompting);
+    qreal remaining() const;
+    void setRemaining(qreal remaining);
+
+    // Addresses of this machine's network interfaces that can be listened on
+    Q_INVOKABLE static QStringList availableAddresses();
+
+    // Connects to a control socket as a client, pings it count times and prints round trip latencies. Returns a process
+    // exit code.
+    static int benchmark(const QString &url, int count);
+
+Q_SIGNALS:
+    void activeChanged();
+    void addressChanged();
+    void portChanged();
+    void listeningChanged();
+    void clientsChanged();
+    void documentChanged();
+    void targetChanged();
+    void stateChanged();
+    void error(const QString &message);
+
+    void velocityRequested(int velocity);
+    void pauseRequested(bool paused);
+    void markerRequested(int step);
+    void goToRequested(qreal progress);
+
+private:
+    enum Command : quint8 { VelocityCommand = 0x01, PauseCommand = 0x02, MarkerCommand = 0x03, GoToCommand = 0x04, PingCommand = 0x05 };
+    enum Message : quint8 { StateMessage = 0x80, MarkersMessage = 0x81, PongMessage = 0x82 };
+
+    void listen();
+    void close();
+    void connection();
+    void read(QTcpSocket *socket);
+    void respond(QTcpSocket *socket, const QByteArray &request);
+    void receive(QTcpSocket *socket);
+    void command(QTcpSocket *socket, const QByteArray &payload);
+    void disconnected(QTcpSocket *socket);
+    void markersChanged();
+    void windowChanged(QQuickWindow *window);
+    void requestFrame();
+    void frame();
+    void indexMarkers();
+    int currentMarker(qreal readY) const;
+    void send(QTcpSocket *socket, const QByteArray &message);
+
+    bool m_active;
+    QString m_address;
+    int m_port;
+
+    QPointer<DocumentHandler> m_document;
+    QPointer<QQuickItem> m_target;
+    QPointer<QQuickWindow> m_window;
+    qreal m_readOffset;
+    qreal m_end;
+    int m_velocity;
+    bool m_playing;
+    bool m_prompting;
+    qreal m_remaining;
+
+    QTcpServer m_server;
+    // Bytes received and not yet handled, per connection. Upgraded connections are also in m_clients.
+    QHash<QTcpSocket *, QByteArray> m_pending;
+    QList<QTcpSocket *> m_clients;
+
+    // Coalesced until the next frame
+    bool m_frameRequested;
+    bool m_markersDirty;
+    QList<QPair<QTcpSocket *, quint32>> m_pings;
+    QByteArray m_lastState;
+    qreal m_lastReadY;
+    int m_marker;
+    // Cursor position of each marker
+    QList<int> m_markerPositions;
+    QByteArray m_markersMessage;
+};
+
+#endif // REMOTECONTROL_H
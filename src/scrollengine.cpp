@@ -0,0 +1,435 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#include "scrollengine.h"
+
+#include <QMutexLocker>
+#include <QQuickWindow>
+#include <QScreen>
+#include <QtMath>
+
+// Frames that take longer than this are treated as stalls, and don't advance position by more than this.
+static constexpr qreal MAX_FRAME_TIME = 0.1;
+// Measured intervals within this fraction of a whole number of refresh periods get snapped to it.
+static constexpr qreal SNAP_TOLERANCE = 0.25;
+// Milliseconds between statistics updates, so bindings on them don't cost a re-evaluation every frame.
+static constexpr qint64 STATISTICS_INTERVAL = 500;
+
+void ScrollEngine::RunningStatistic::add(qreal value)
+{
+    // Welford's online algorithm
+    ++count;
+    const qreal delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+qreal ScrollEngine::RunningStatistic::deviation() const
+{
+    return count > 1 ? qSqrt(m2 / (count - 1)) : 0;
+}
+
+ScrollEngine::ScrollEngine(QObject *parent)
+    : QObject(parent)
+    , m_running(false)
+    , m_step(0)
+    , m_baseSpeed(1)
+    , m_curvature(1)
+    , m_speedScale(1)
+    , m_steered(false)
+    , m_steeredVelocity(0)
+    , m_minimum(0)
+    , m_maximum(0)
+    , m_resting(false)
+    , m_recording(false)
+    , m_lastSwap(-1)
+    , m_contentTime(-1)
+    , m_position(0)
+    , m_written(0)
+    , m_generation(0)
+    , m_statisticsEmitted(0)
+{
+    m_clock.start();
+}
+
+QQuickItem *ScrollEngine::target() const
+{
+    return m_target;
+}
+
+void ScrollEngine::setTarget(QQuickItem *target)
+{
+    if (target == m_target)
+        return;
+
+    if (m_target)
+        disconnect(m_target, &QQuickItem::windowChanged, this, &ScrollEngine::windowChanged);
+    m_target = target;
+    if (m_target)
+        connect(m_target, &QQuickItem::windowChanged, this, &ScrollEngine::windowChanged);
+    windowChanged(m_target ? m_target->window() : nullptr);
+    Q_EMIT targetChanged();
+}
+
+bool ScrollEngine::running() const
+{
+    return m_running;
+}
+
+void ScrollEngine::setRunning(bool running)
+{
+    if (running == m_running)
+        return;
+
+    m_running = running;
+    m_resting = false;
+    m_contentTime = -1;
+    ++m_generation;
+    {
+        QMutexLocker locker(&m_frameMutex);
+        m_recording = m_running;
+        m_preparedFrame = Frame();
+        m_presentedFrames.clear();
+    }
+    if (m_running) {
+        resetStatistics();
+        m_position = m_written = m_target ? m_target->property("contentY").toReal() : 0;
+        scheduleFrame();
+    }
+    else
+        Q_EMIT statisticsChanged();
+    Q_EMIT runningChanged();
+}
+
+int ScrollEngine::step() const
+{
+    return m_step;
+}
+
+void ScrollEngine::setStep(int step)
+{
+    if (step == m_step)
+        return;
+
+    m_step = step;
+    resume();
+    Q_EMIT velocityChanged();
+}
+
+qreal ScrollEngine::baseSpeed() const
+{
+    return m_baseSpeed;
+}
+
+void ScrollEngine::setBaseSpeed(qreal baseSpeed)
+{
+    if (qFuzzyCompare(baseSpeed, m_baseSpeed))
+        return;
+
+    m_baseSpeed = baseSpeed;
+    resume();
+    Q_EMIT velocityChanged();
+}
+
+qreal ScrollEngine::curvature() const
+{
+    return m_curvature;
+}
+
+void ScrollEngine::setCurvature(qreal curvature)
+{
+    if (qFuzzyCompare(curvature, m_curvature))
+        return;
+
+    m_curvature = curvature;
+    resume();
+    Q_EMIT velocityChanged();
+}
+
+qreal ScrollEngine::speedScale() const
+{
+    return m_speedScale;
+}
+
+void ScrollEngine::setSpeedScale(qreal speedScale)
+{
+    if (qFuzzyCompare(speedScale, m_speedScale))
+        return;
+
+    m_speedScale = speedScale;
+    resume();
+    Q_EMIT velocityChanged();
+}
+
+bool ScrollEngine::steered() const
+{
+    return m_steered;
+}
+
+void ScrollEngine::setSteered(bool steered)
+{
+    if (steered == m_steered)
+        return;
+
+    m_steered = steered;
+    resume();
+    Q_EMIT velocityChanged();
+}
+
+qreal ScrollEngine::steeredVelocity() const
+{
+    return m_steeredVelocity;
+}
+
+void ScrollEngine::setSteeredVelocity(qreal steeredVelocity)
+{
+    if (qFuzzyCompare(steeredVelocity, m_steeredVelocity))
+        return;
+
+    m_steeredVelocity = steeredVelocity;
+    resume();
+    Q_EMIT velocityChanged();
+}
+
+qreal ScrollEngine::velocity() const
+{
+    if (m_steered)
+        return m_steeredVelocity;
+    // Same curve as the prompter's speed: baseSpeed * |step| ^ curvature
+    const qreal speed = m_baseSpeed * qPow(qAbs(m_step), m_curvature) * m_speedScale;
+    return m_step < 0 ? -speed : speed;
+}
+
+qreal ScrollEngine::minimum() const
+{
+    return m_minimum;
+}
+
+void ScrollEngine::setMinimum(qreal minimum)
+{
+    if (qFuzzyCompare(minimum, m_minimum))
+        return;
+
+    m_minimum = minimum;
+    resume();
+    Q_EMIT boundsChanged();
+}
+
+qreal ScrollEngine::maximum() const
+{
+    return m_maximum;
+}
+
+void ScrollEngine::setMaximum(qreal maximum)
+{
+    if (qFuzzyCompare(maximum, m_maximum))
+        return;
+
+    m_maximum = maximum;
+    resume();
+    Q_EMIT boundsChanged();
+}
+
+int ScrollEngine::frames() const
+{
+    return m_intervals.count;
+}
+
+qreal ScrollEngine::frameInterval() const
+{
+    return m_intervals.mean;
+}
+
+qreal ScrollEngine::frameIntervalJitter() const
+{
+    return m_intervals.deviation();
+}
+
+qreal ScrollEngine::motionJitter() const
+{
+    return m_motionError.deviation();
+}
+
+void ScrollEngine::resetStatistics()
+{
+    m_intervals = RunningStatistic();
+    m_motionError = RunningStatistic();
+    m_previousFrame = Frame();
+    m_statisticsEmitted = m_clock.elapsed();
+    Q_EMIT statisticsChanged();
+}
+
+void ScrollEngine::tick()
+{
+    // Frames rendered for other reasons while at rest have nothing to move.
+    if (!m_running || !m_target || m_resting)
+        return;
+
+    QList<Frame> presented;
+    qint64 lastSwap;
+    {
+        QMutexLocker locker(&m_frameMutex);
+        presented.swap(m_presentedFrames);
+        lastSwap = m_lastSwap;
+    }
+    account(presented);
+
+    // The frame being prepared is shown a refresh period after the latest swap. When no swap happened since the
+    // previous frame was prepared, it's shown a period after that one.
+    const qint64 period = qRound64(refreshInterval() * 1e9);
+    qint64 expected = (lastSwap >= 0 ? lastSwap : m_clock.nsecsElapsed()) + period;
+    if (m_contentTime < 0) {
+        // First frame only establishes the time base.
+        m_contentTime = expected;
+        prepare(false);
+        scheduleFrame();
+        return;
+    }
+    if (expected <= m_contentTime)
+        expected = m_contentTime + period;
+    const qreal measured = (expected - m_contentTime) / 1e9;
+    m_contentTime = expected;
+
+    // Frames are presented on whole refresh periods. Snap to the nearest one when close enough, which absorbs the
+    // noise in swap timestamps.
+    const qreal periods = qRound(measured * 1e9 / period);
+    qreal dt = measured;
+    if (periods >= 1 && qAbs(measured * 1e9 - periods * period) < SNAP_TOLERANCE * period)
+        dt = periods * period / 1e9;
+    dt = qMin(dt, MAX_FRAME_TIME);
+
+    // Pick up any position changes made by others since the last frame.
+    const qreal current = m_target->property("contentY").toReal();
+    if (!qFuzzyCompare(current, m_written)) {
+        m_position = current;
+        ++m_generation;
+    }
+
+    const qreal v = velocity();
+    m_position = qBound(m_minimum, m_position + v * dt, m_maximum);
+    m_written = m_position;
+    m_target->setProperty("contentY", m_position);
+
+    const bool atBoundary = (v > 0 && m_position >= m_maximum) || (v < 0 && m_position <= m_minimum);
+    prepare(!atBoundary && dt < MAX_FRAME_TIME);
+
+    if (m_clock.elapsed() - m_statisticsEmitted >= STATISTICS_INTERVAL) {
+        m_statisticsEmitted = m_clock.elapsed();
+        Q_EMIT statisticsChanged();
+    }
+
+    // Stop requesting frames while there's nothing to move, so a paused or held prompter lets the window go idle.
+    // Velocity and bounds changes resume motion.
+    m_resting = atBoundary || qFuzzyIsNull(v);
+    if (!m_resting)
+        scheduleFrame();
+    if (atBoundary)
+        Q_EMIT boundaryReached();
+}
+
+void ScrollEngine::resume()
+{
+    if (m_resting) {
+        // Time spent at rest isn't elapsed motion time, and frames presented meanwhile don't count towards jitter.
+        m_resting = false;
+        m_contentTime = -1;
+        ++m_generation;
+        QMutexLocker locker(&m_frameMutex);
+        m_presentedFrames.clear();
+    }
+    scheduleFrame();
+}
+
+void ScrollEngine::prepare(bool moving)
+{
+    QMutexLocker locker(&m_frameMutex);
+    m_preparedFrame.position = m_position;
+    m_preparedFrame.velocity = velocity();
+    m_preparedFrame.generation = m_generation;
+    m_preparedFrame.moving = moving;
+}
+
+void ScrollEngine::account(const QList<Frame> &presented)
+{
+    // Compares what consecutive frames showed against when they were shown, so both timer noise and uneven steps count.
+    for (const Frame &frame : presented) {
+        if (m_previousFrame.timestamp >= 0 && frame.generation == m_previousFrame.generation) {
+            const qreal interval = (frame.timestamp - m_previousFrame.timestamp) / 1e9;
+            m_intervals.add(interval * 1000);
+            if (frame.moving)
+                m_motionError.add((frame.position - m_previousFrame.position) - frame.velocity * interval);
+        }
+        m_previousFrame = frame;
+    }
+}
+
+void ScrollEngine::windowChanged(QQuickWindow *window)
+{
+    if (m_window)
+        disconnect(m_window, nullptr, this, nullptr);
+    m_window = window;
+    m_resting = false;
+    if (m_window) {
+        connect(m_window, &QQuickWindow::afterAnimating, this, &ScrollEngine::tick);
+        // Direct connections, so what each frame shows is recorded on the render thread as it happens.
+        connect(m_window, &QQuickWindow::afterSynchronizing, this, &ScrollEngine::afterSynchronizing, Qt::DirectConnection);
+        connect(m_window, &QQuickWindow::frameSwapped, this, &ScrollEngine::frameSwapped, Qt::DirectConnection);
+    }
+    m_contentTime = -1;
+    ++m_generation;
+    {
+        QMutexLocker locker(&m_frameMutex);
+        m_lastSwap = -1;
+        m_preparedFrame = Frame();
+        m_presentedFrames.clear();
+    }
+    scheduleFrame();
+}
+
+void ScrollEngine::afterSynchronizing()
+{
+    QMutexLocker locker(&m_frameMutex);
+    m_synchronizedFrame = m_preparedFrame;
+    // A frame synchronized again without being prepared anew shows nothing new.
+    m_preparedFrame.moving = false;
+}
+
+void ScrollEngine::frameSwapped()
+{
+    QMutexLocker locker(&m_frameMutex);
+    m_lastSwap = m_clock.nsecsElapsed();
+    if (!m_recording)
+        return;
+    m_synchronizedFrame.timestamp = m_lastSwap;
+    m_presentedFrames.append(m_synchronizedFrame);
+}
+
+qreal ScrollEngine::refreshInterval() const
+{
+    const qreal rate = m_window && m_window->screen() ? m_window->screen()->refreshRate() : 60;
+    return 1 / (rate > 0 ? rate : 60);
+}
+
+void ScrollEngine::scheduleFrame()
+{
+    if (m_running && m_window)
+        m_window->update();
+}
@@ -0,0 +1,178 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef SCROLLENGINE_H
+#define SCROLLENGINE_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QQuickItem>
+
+class QQuickWindow;
+
+// Moves a Flickable's contentY at a constant velocity, integrated once per presented frame. Each step covers the time
+// between the window's frame swaps, snapped to whole refresh periods, rather than time measured on the GUI thread.
+class ScrollEngine : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(QQuickItem *target READ target WRITE setTarget NOTIFY targetChanged)
+    Q_PROPERTY(bool running READ running WRITE setRunning NOTIFY runningChanged)
+    Q_PROPERTY(int step READ step WRITE setStep NOTIFY velocityChanged)
+    Q_PROPERTY(qreal baseSpeed READ baseSpeed WRITE setBaseSpeed NOTIFY velocityChanged)
+    Q_PROPERTY(qreal curvature READ curvature WRITE setCurvature NOTIFY velocityChanged)
+    Q_PROPERTY(qreal speedScale READ speedScale WRITE setSpeedScale NOTIFY velocityChanged)
+    // Follow steeredVelocity instead of the velocity step, baseSpeed and curvature give
+    Q_PROPERTY(bool steered READ steered WRITE setSteered NOTIFY velocityChanged)
+    Q_PROPERTY(qreal steeredVelocity READ steeredVelocity WRITE setSteeredVelocity NOTIFY velocityChanged)
+    Q_PROPERTY(qreal velocity READ velocity NOTIFY velocityChanged)
+    Q_PROPERTY(qreal minimum READ minimum WRITE setMinimum NOTIFY boundsChanged)
+    Q_PROPERTY(qreal maximum READ maximum WRITE setMaximum NOTIFY boundsChanged)
+    // Jitter statistics of presented frames, gathered since motion last started and updated a couple of times a second
+    Q_PROPERTY(int frames READ frames NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal frameInterval READ frameInterval NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal frameIntervalJitter READ frameIntervalJitter NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal motionJitter READ motionJitter NOTIFY statisticsChanged)
+
+public:
+    explicit ScrollEngine(QObject *parent = nullptr);
+
+    QQuickItem *target() const;
+    void setTarget(QQuickItem *target);
+
+    bool running() const;
+    void setRunning(bool running);
+
+    int step() const;
+    void setStep(int step);
+    qreal baseSpeed() const;
+    void setBaseSpeed(qreal baseSpeed);
+    qreal curvature() const;
+    void setCurvature(qreal curvature);
+    qreal speedScale() const;
+    void setSpeedScale(qreal speedScale);
+    bool steered() const;
+    void setSteered(bool steered);
+    qreal steeredVelocity() const;
+    void setSteeredVelocity(qreal steeredVelocity);
+    // Pixels per second, signed
+    qreal velocity() const;
+
+    qreal minimum() const;
+    void setMinimum(qreal minimum);
+    qreal maximum() const;
+    void setMaximum(qreal maximum);
+
+    int frames() const;
+    // Milliseconds between frame swaps
+    qreal frameInterval() const;
+    qreal frameIntervalJitter() const;
+    // Pixels, standard deviation of each presented frame's displacement from velocity times the time since the previous
+    // frame was presented
+    qreal motionJitter() const;
+
+    Q_INVOKABLE void resetStatistics();
+
+Q_SIGNALS:
+    void targetChanged();
+    void runningChanged();
+    void velocityChanged();
+    void boundsChanged();
+    void statisticsChanged();
+    void boundaryReached();
+
+private Q_SLOTS:
+    void tick();
+    void windowChanged(QQuickWindow *window);
+
+private:
+    // What a frame showed, and when it was swapped in
+    struct Frame {
+        qint64 timestamp = -1;
+        qreal position = 0;
+        qreal velocity = 0;
+        // Changes whenever the position is moved by something other than this engine
+        int generation = 0;
+        // Moved freely by velocity, not held at a boundary or establishing the time base
+        bool moving = false;
+    };
+
+    struct RunningStatistic {
+        qint64 count = 0;
+        qreal mean = 0;
+        qreal m2 = 0;
+        void add(qreal value);
+        qreal deviation() const;
+    };
+
+    qreal refreshInterval() const;
+    void scheduleFrame();
+    void resume();
+    void prepare(bool moving);
+    void account(const QList<Frame> &presented);
+    // Render thread
+    void afterSynchronizing();
+    void frameSwapped();
+
+    QPointer<QQuickItem> m_target;
+    QPointer<QQuickWindow> m_window;
+    bool m_running;
+    int m_step;
+    qreal m_baseSpeed;
+    qreal m_curvature;
+    qreal m_speedScale;
+    bool m_steered;
+    qreal m_steeredVelocity;
+    qreal m_minimum;
+    qreal m_maximum;
+    // Reached a boundary or has no velocity, so no frames are being requested
+    bool m_resting;
+
+    // Shared by both threads
+    QElapsedTimer m_clock;
+    // Guards the frame records below, handed between the GUI and render threads
+    QMutex m_frameMutex;
+    bool m_recording;
+    Frame m_preparedFrame;
+    Frame m_synchronizedFrame;
+    QList<Frame> m_presentedFrames;
+    qint64 m_lastSwap;
+
+    // GUI thread
+    // Presentation time the position has been advanced to
+    qint64 m_contentTime;
+    // Sub-pixel position, kept separately because other code may also move the target
+    qreal m_position;
+    qreal m_written;
+    int m_generation;
+    Frame m_previousFrame;
+    qint64 m_statisticsEmitted;
+
+    RunningStatistic m_intervals;
+    RunningStatistic m_motionError;
+};
+
+#endif // SCROLLENGINE_H
@@ -0,0 +1,355 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+#include "sessionanalytics.h"
+
+#include <QVariantMap>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "markersmodel.h"
+#include "telemetry.h"
+
+static constexpr int PACE_BUCKET = 1000;
+
+SessionAnalytics::SessionAnalytics(QObject *parent)
+    : QObject(parent)
+    , m_lineWidth(0)
+    , m_lineHeight(0)
+    , m_readOffset(0)
+    , m_paceWindow(10000)
+    , m_pauseThreshold(2000)
+{
+    clear();
+}
+
+DocumentHandler *SessionAnalytics::document() const
+{
+    return m_document;
+}
+
+void SessionAnalytics::setDocument(DocumentHandler *document)
+{
+    if (document == m_document)
+        return;
+
+    m_document = document;
+    Q_EMIT documentChanged();
+}
+
+QString SessionAnalytics::file() const
+{
+    return m_file;
+}
+
+void SessionAnalytics::setFile(const QString &file)
+{
+    if (file == m_file)
+        return;
+
+    m_file = file;
+    Q_EMIT fileChanged();
+}
+
+qreal SessionAnalytics::lineWidth() const
+{
+    return m_lineWidth;
+}
+
+void SessionAnalytics::setLineWidth(qreal lineWidth)
+{
+    if (qFuzzyCompare(lineWidth, m_lineWidth))
+        return;
+
+    m_lineWidth = lineWidth;
+    Q_EMIT layoutChanged();
+    Q_EMIT velocityChanged();
+}
+
+qreal SessionAnalytics::lineHeight() const
+{
+    return m_lineHeight;
+}
+
+void SessionAnalytics::setLineHeight(qreal lineHeight)
+{
+    if (qFuzzyCompare(lineHeight, m_lineHeight))
+        return;
+
+    m_lineHeight = lineHeight;
+    Q_EMIT layoutChanged();
+    Q_EMIT velocityChanged();
+}
+
+qreal SessionAnalytics::readOffset() const
+{
+    return m_readOffset;
+}
+
+void SessionAnalytics::setReadOffset(qreal readOffset)
+{
+    if (qFuzzyCompare(readOffset, m_readOffset))
+        return;
+
+    m_readOffset = readOffset;
+    Q_EMIT layoutChanged();
+}
+
+int SessionAnalytics::paceWindow() const
+{
+    return m_paceWindow;
+}
+
+void SessionAnalytics::setPaceWindow(int paceWindow)
+{
+    if (paceWindow == m_paceWindow)
+        return;
+
+    m_paceWindow = paceWindow;
+    Q_EMIT paceWindowChanged();
+}
+
+int SessionAnalytics::pauseThreshold() const
+{
+    return m_pauseThreshold;
+}
+
+void SessionAnalytics::setPauseThreshold(int pauseThreshold)
+{
+    if (pauseThreshold == m_pauseThreshold)
+        return;
+
+    m_pauseThreshold = pauseThreshold;
+    Q_EMIT pauseThresholdChanged();
+}
+
+bool SessionAnalytics::ready() const
+{
+    return m_ready;
+}
+
+qreal SessionAnalytics::duration() const
+{
+    return m_duration;
+}
+
+qreal SessionAnalytics::readingTime() const
+{
+    return m_readingTime;
+}
+
+int SessionAnalytics::pauses() const
+{
+    return m_pauses;
+}
+
+qreal SessionAnalytics::pausedTime() const
+{
+    return m_pausedTime;
+}
+
+qreal SessionAnalytics::wordsPerMinute() const
+{
+    return m_wordsPerMinute;
+}
+
+qreal SessionAnalytics::paceDeviation() const
+{
+    return m_paceDeviation;
+}
+
+qreal SessionAnalytics::velocity() const
+{
+    return m_lineWidth > 0 ? m_layoutVelocity * m_lineHeight * m_lineHeight / m_lineWidth : 0;
+}
+
+QList<QPointF> SessionAnalytics::pace() const
+{
+    return m_pace;
+}
+
+QVariantList SessionAnalytics::sections() const
+{
+    return m_sections;
+}
+
+void SessionAnalytics::clear()
+{
+    m_ready = false;
+    m_duration = 0;
+    m_readingTime = 0;
+    m_pauses = 0;
+    m_pausedTime = 0;
+    m_wordsPerMinute = 0;
+    m_paceDeviation = 0;
+    m_layoutVelocity = 0;
+    m_pace.clear();
+    m_sections.clear();
+    Q_EMIT analysed();
+    Q_EMIT velocityChanged();
+}
+
+// Each step is a single pass over flat columns, so sessions hours long are analysed in milliseconds.
+bool SessionAnalytics::analyse()
+{
+    const QList<DataPoint> points = Telemetry::loadSession(m_file);
+    if (points.size() < 2 || !m_document || m_lineWidth <= 0 || m_lineHeight <= 0) {
+        clear();
+        return false;
+    }
+
+    // Reading region position in the current layout, where lines hold lineWidth / lineHeight worth of text and
+    // take lineHeight each. Positions therefore scale by lineHeight² / lineWidth between layouts.
+    const size_t n = points.size();
+    std::vector<double> time(n), y(n), words(n);
+    const double layout = m_lineHeight * m_lineHeight / m_lineWidth;
+    for (size_t i = 0; i < n; i++) {
+        const DataPoint &point = points.at(i);
+        const double scale = point.lineWidth > 0 && point.lineHeight > 0 ? layout * point.lineWidth / (double(point.lineHeight) * point.lineHeight) : 1;
+        time[i] = point.time;
+        // Only the recorded scroll position belongs to the recorded layout. The reading region's offset is the current one.
+        y[i] = point.position * scale + m_readOffset;
+    }
+
+    // Words read by each point. Positions mostly advance by less than a line per frame, so walking from the previous
+    // point's line takes amortized constant time.
+    const QList<QPointF> progress = m_document->wordProgress();
+    if (!progress.isEmpty()) {
+        const qsizetype last = progress.size() - 1;
+        qsizetype line = 0;
+        for (size_t i = 0; i < n; i++) {
+            while (line < last && progress.at(line + 1).x() <= y[i])
+                ++line;
+            while (line > 0 && progress.at(line).x() > y[i])
+                --line;
+            const QPointF &from = progress.at(line);
+            if (y[i] < from.x())
+                words[i] = 0;
+            else if (line == last)
+                words[i] = from.y();
+            else {
+                const QPointF &to = progress.at(line + 1);
+                words[i] = from.y() + (to.y() - from.y()) * (y[i] - from.x()) / (to.x() - from.x());
+            }
+        }
+    }
+
+    // Pauses are stretches where the reading region stays within a quarter line for at least the threshold. Frames
+    // aren't recorded while nothing moves, so a pause may be a single long gap between two points.
+    const double stillness = m_lineHeight / 4;
+    std::vector<char> paused(n, 0);
+    m_pauses = 0;
+    m_pausedTime = 0;
+    for (size_t start = 0, i = 1; i <= n; i++) {
+        if (i < n && std::abs(y[i] - y[start]) <= stillness)
+            continue;
+        const double stopped = time[i - 1] - time[start];
+        if (stopped >= m_pauseThreshold) {
+            ++m_pauses;
+            m_pausedTime += stopped;
+            std::fill(paused.begin() + start + 1, paused.begin() + i, 1);
+        }
+        start = i;
+    }
+
+    // Forward progress while not paused, in one second buckets
+    m_duration = time[n - 1] - time[0];
+    const size_t buckets = size_t(m_duration / PACE_BUCKET) + 1;
+    std::vector<double> bucketTime(buckets, 0), bucketWords(buckets, 0);
+    double readWords = 0, readDistance = 0;
+    m_readingTime = 0;
+    for (size_t i = 1; i < n; i++) {
+        if (paused[i])
+            continue;
+        const double elapsed = time[i] - time[i - 1];
+        const double read = std::max(0.0, words[i] - words[i - 1]);
+        const size_t bucket = size_t((time[i] - time[0]) / PACE_BUCKET);
+        bucketTime[bucket] += elapsed;
+        bucketWords[bucket] += read;
+        m_readingTime += elapsed;
+        readWords += read;
+        readDistance += std::max(0.0, y[i] - y[i - 1]);
+    }
+    m_wordsPerMinute = m_readingTime > 0 ? readWords * 60000 / m_readingTime : 0;
+    m_layoutVelocity = m_readingTime > 0 ? readDistance * 1000 / m_readingTime / layout : 0;
+
+    // Sliding window pace. Windows mostly spent paused are left out of the deviation.
+    const size_t window = size_t(std::max(1, m_paceWindow / PACE_BUCKET));
+    double windowTime = 0, windowWords = 0, sum = 0, sumOfSquares = 0;
+    int samples = 0;
+    m_pace.clear();
+    m_pace.reserve(buckets);
+    for (size_t bucket = 0; bucket < buckets; bucket++) {
+        windowTime += bucketTime[bucket];
+        windowWords += bucketWords[bucket];
+        if (bucket >= window) {
+            windowTime -= bucketTime[bucket - window];
+            windowWords -= bucketWords[bucket - window];
+        }
+        const double wordsPerMinute = windowTime > 0 ? windowWords * 60000 / windowTime : 0;
+        m_pace.append(QPointF(bucket + 1, wordsPerMinute));
+        if (windowTime >= window * PACE_BUCKET / 2) {
+            sum += wordsPerMinute;
+            sumOfSquares += wordsPerMinute * wordsPerMinute;
+            ++samples;
+        }
+    }
+    m_paceDeviation = samples > 1 ? std::sqrt(std::max(0.0, (sumOfSquares - sum * sum / samples) / (samples - 1))) : 0;
+
+    // Time and pace per marker section. Markers are kept in document order.
+    std::vector<double> boundaries;
+    QStringList names = {QString()};
+    if (MarkersModel *markers = m_document->markers()) {
+        for (int row = 0; row < markers->rowCount(); row++) {
+            const QModelIndex index = markers->index(row);
+            boundaries.push_back(m_document->cursorY(markers->data(index, MarkersModel::PositionRole).toInt()));
+            names.append(markers->data(index, MarkersModel::TextRole).toString());
+        }
+    }
+    std::vector<double> sectionTime(names.size(), 0), sectionReadingTime(names.size(), 0), sectionWords(names.size(), 0);
+    size_t section = 0;
+    for (size_t i = 1; i < n; i++) {
+        while (section < boundaries.size() && boundaries[section] <= y[i - 1])
+            ++section;
+        while (section > 0 && boundaries[section - 1] > y[i - 1])
+            --section;
+        const double elapsed = time[i] - time[i - 1];
+        sectionTime[section] += elapsed;
+        if (!paused[i]) {
+            sectionReadingTime[section] += elapsed;
+            sectionWords[section] += std::max(0.0, words[i] - words[i - 1]);
+        }
+    }
+    m_sections.clear();
+    for (qsizetype i = 0; i < names.size(); i++)
+        if (sectionTime[i] > 0)
+            m_sections.append(QVariantMap({{QStringLiteral("name"), names.at(i)},
+                                           {QStringLiteral("time"), sectionTime[i]},
+                                           {QStringLiteral("wordsPerMinute"), sectionReadingTime[i] > 0 ? sectionWords[i] * 60000 / sectionReadingTime[i] : 0}}));
+
+    m_ready = true;
+    Q_EMIT analysed();
+    Q_EMIT velocityChanged();
+    return true;
+}
@@ -0,0 +1,136 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef SESSIONANALYTICS_H
+#define SESSIONANALYTICS_H
+
+#include <QList>
+#include <QObject>
+#include <QPointF>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QString>
+#include <QVariantList>
+
+#include "documenthandler.h"
+
+// Reading pace statistics over a recorded session. Recorded positions are rescaled to the document's current layout
+// and mapped to words through it, assuming words per line grow with line width and shrink with line height.
+class SessionAnalytics : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(DocumentHandler *document READ document WRITE setDocument NOTIFY documentChanged)
+    Q_PROPERTY(QString file READ file WRITE setFile NOTIFY fileChanged)
+    // Current width and height of lines, which recorded positions are rescaled to
+    Q_PROPERTY(qreal lineWidth READ lineWidth WRITE setLineWidth NOTIFY layoutChanged)
+    Q_PROPERTY(qreal lineHeight READ lineHeight WRITE setLineHeight NOTIFY layoutChanged)
+    // Distance from the top of the prompter to the reading region
+    Q_PROPERTY(qreal readOffset READ readOffset WRITE setReadOffset NOTIFY layoutChanged)
+    // Length of the sliding window pace is measured over, in milliseconds
+    Q_PROPERTY(int paceWindow READ paceWindow WRITE setPaceWindow NOTIFY paceWindowChanged)
+    // Shortest stop counted as a pause, in milliseconds
+    Q_PROPERTY(int pauseThreshold READ pauseThreshold WRITE setPauseThreshold NOTIFY pauseThresholdChanged)
+
+    Q_PROPERTY(bool ready READ ready NOTIFY analysed)
+    // Times are in milliseconds
+    Q_PROPERTY(qreal duration READ duration NOTIFY analysed)
+    Q_PROPERTY(qreal readingTime READ readingTime NOTIFY analysed)
+    Q_PROPERTY(int pauses READ pauses NOTIFY analysed)
+    Q_PROPERTY(qreal pausedTime READ pausedTime NOTIFY analysed)
+    // Mean pace while not paused, and the standard deviation of the sliding window pace around it
+    Q_PROPERTY(qreal wordsPerMinute READ wordsPerMinute NOTIFY analysed)
+    Q_PROPERTY(qreal paceDeviation READ paceDeviation NOTIFY analysed)
+    // Mean reading velocity while not paused, in pixels per second of the current layout. Follows layout changes without
+    // analysing again.
+    Q_PROPERTY(qreal velocity READ velocity NOTIFY velocityChanged)
+    // Sliding window pace, as (seconds, words per minute) points once per second
+    Q_PROPERTY(QList<QPointF> pace READ pace NOTIFY analysed)
+    // Time spent and pace per marker section, as maps with name, time and wordsPerMinute keys. The section before the
+    // first marker has no name.
+    Q_PROPERTY(QVariantList sections READ sections NOTIFY analysed)
+
+public:
+    explicit SessionAnalytics(QObject *parent = nullptr);
+
+    DocumentHandler *document() const;
+    void setDocument(DocumentHandler *document);
+    QString file() const;
+    void setFile(const QString &file);
+    qreal lineWidth() const;
+    void setLineWidth(qreal lineWidth);
+    qreal lineHeight() const;
+    void setLineHeight(qreal lineHeight);
+    qreal readOffset() const;
+    void setReadOffset(qreal readOffset);
+    int paceWindow() const;
+    void setPaceWindow(int paceWindow);
+    int pauseThreshold() const;
+    void setPauseThreshold(int pauseThreshold);
+
+    bool ready() const;
+    qreal duration() const;
+    qreal readingTime() const;
+    int pauses() const;
+    qreal pausedTime() const;
+    qreal wordsPerMinute() const;
+    qreal paceDeviation() const;
+    qreal velocity() const;
+    QList<QPointF> pace() const;
+    QVariantList sections() const;
+
+public Q_SLOTS:
+    bool analyse();
+    void clear();
+
+Q_SIGNALS:
+    void documentChanged();
+    void fileChanged();
+    void layoutChanged();
+    void paceWindowChanged();
+    void pauseThresholdChanged();
+    void analysed();
+    void velocityChanged();
+
+private:
+    QPointer<DocumentHandler> m_document;
+    QString m_file;
+    qreal m_lineWidth;
+    qreal m_lineHeight;
+    qreal m_readOffset;
+    int m_paceWindow;
+    int m_pauseThreshold;
+
+    bool m_ready;
+    qreal m_duration;
+    qreal m_readingTime;
+    int m_pauses;
+    qreal m_pausedTime;
+    qreal m_wordsPerMinute;
+    qreal m_paceDeviation;
+    // Velocity in units of lineHeight² / lineWidth, which is how far positions scale between layouts
+    qreal m_layoutVelocity;
+    QList<QPointF> m_pace;
+    QVariantList m_sections;
+};
+
+#endif // SESSIONANALYTICS_H
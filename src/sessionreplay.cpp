@@ -0,0 +1,257 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+#include "sessionreplay.h"
+
+#include <QDebug>
+#include <QQuickWindow>
+#include <QTextStream>
+#include <QUrl>
+
+#include "telemetry.h"
+
+SessionReplay::SessionReplay(QObject *parent)
+    : QObject(parent)
+    , m_realtime(false)
+    , m_index(0)
+    , m_velocity(0)
+{
+}
+
+QQuickItem *SessionReplay::target() const
+{
+    return m_target;
+}
+
+void SessionReplay::setTarget(QQuickItem *target)
+{
+    if (target == m_target)
+        return;
+
+    m_target = target;
+    Q_EMIT targetChanged();
+}
+
+QString SessionReplay::file() const
+{
+    return m_file;
+}
+
+void SessionReplay::setFile(const QString &file)
+{
+    if (file == m_file)
+        return;
+
+    m_file = file;
+    Q_EMIT fileChanged();
+}
+
+bool SessionReplay::realtime() const
+{
+    return m_realtime;
+}
+
+void SessionReplay::setRealtime(bool realtime)
+{
+    if (realtime == m_realtime)
+        return;
+
+    m_realtime = realtime;
+    Q_EMIT realtimeChanged();
+}
+
+FrameProfiler *SessionReplay::profiler() const
+{
+    return m_profiler;
+}
+
+void SessionReplay::setProfiler(FrameProfiler *profiler)
+{
+    if (profiler == m_profiler)
+        return;
+
+    m_profiler = profiler;
+    Q_EMIT profilerChanged();
+}
+
+QString SessionReplay::report() const
+{
+    return m_report;
+}
+
+void SessionReplay::setReport(const QString &report)
+{
+    if (report == m_report)
+        return;
+
+    m_report = report;
+    Q_EMIT reportChanged();
+}
+
+QString SessionReplay::label() const
+{
+    return m_label;
+}
+
+void SessionReplay::setLabel(const QString &label)
+{
+    if (label == m_label)
+        return;
+
+    m_label = label;
+    Q_EMIT labelChanged();
+}
+
+bool SessionReplay::running() const
+{
+    return !m_window.isNull();
+}
+
+qreal SessionReplay::velocity() const
+{
+    return m_velocity;
+}
+
+void SessionReplay::setVelocity(qreal velocity)
+{
+    if (qFuzzyCompare(velocity, m_velocity))
+        return;
+
+    m_velocity = velocity;
+    Q_EMIT velocityChanged();
+}
+
+void SessionReplay::start()
+{
+    if (running() || !m_target || !m_target->window())
+        return;
+
+    m_points = Telemetry::loadSession(m_file);
+    if (m_points.isEmpty()) {
+        qWarning() << "No data points to replay in" << m_file;
+        Q_EMIT finished();
+        return;
+    }
+
+    m_window = m_target->window();
+    // Match the recorded prompter width, keeping whatever surrounds the prompter.
+    const int margin = m_window->width() - qRound(m_target->width());
+    m_window->resize(m_points.first().prompterWidth + margin, m_window->height());
+    if (m_profiler) {
+        m_profiler->setWindow(m_window);
+        m_profiler->setEnabled(true);
+        m_profiler->reset();
+    }
+    m_index = 0;
+    m_target->setProperty("contentY", m_points.first().position);
+    m_clock.start();
+    connect(m_window, &QQuickWindow::afterAnimating, this, &SessionReplay::frame);
+    m_window->update();
+    Q_EMIT runningChanged();
+}
+
+void SessionReplay::stop()
+{
+    if (!running())
+        return;
+
+    disconnect(m_window, &QQuickWindow::afterAnimating, this, &SessionReplay::frame);
+    m_window = nullptr;
+    m_points.clear();
+    setVelocity(0);
+    Q_EMIT runningChanged();
+}
+
+void SessionReplay::frame()
+{
+    if (!m_target) {
+        stop();
+        return;
+    }
+    if (m_index >= m_points.size())
+        return;
+
+    if (m_realtime) {
+        const qint64 time = m_points.first().time + m_clock.elapsed();
+        while (m_index + 1 < m_points.size() && m_points.at(m_index + 1).time <= time)
+            ++m_index;
+        const DataPoint &from = m_points.at(m_index);
+        qreal position = from.position;
+        qreal velocity = 0;
+        if (m_index + 1 < m_points.size()) {
+            const DataPoint &to = m_points.at(m_index + 1);
+            if (to.time > from.time) {
+                velocity = (to.position - from.position) * 1000 / (to.time - from.time);
+                position += velocity * (time - from.time) / 1000;
+            }
+        }
+        else
+            ++m_index;
+        setVelocity(velocity);
+        // The prompter's motion integrates the velocity, so positions only need correcting once they drift apart.
+        const qreal tolerance = from.lineHeight > 0 ? from.lineHeight / 2. : 1;
+        if (qAbs(m_target->property("contentY").toReal() - position) > tolerance)
+            m_target->setProperty("contentY", position);
+    }
+    else {
+        const DataPoint &point = m_points.at(m_index);
+        if (m_index + 1 < m_points.size()) {
+            const DataPoint &next = m_points.at(m_index + 1);
+            setVelocity(next.time > point.time ? (next.position - point.position) * 1000 / (next.time - point.time) : 0);
+        }
+        else
+            setVelocity(0);
+        m_target->setProperty("contentY", point.position);
+        ++m_index;
+    }
+
+    if (m_index < m_points.size())
+        m_window->update();
+    else
+        // Let the frame for the last point render before finishing.
+        QMetaObject::invokeMethod(this, &SessionReplay::finish, Qt::QueuedConnection);
+}
+
+void SessionReplay::finish()
+{
+    if (!running())
+        return;
+
+    const qsizetype points = m_points.size();
+    const qint64 duration = m_clock.elapsed();
+    stop();
+
+    QTextStream out(stdout);
+    out << "Replayed " << points << " points from " << m_file << " in " << duration << " ms";
+    if (!m_label.isEmpty())
+        out << " (" << m_label << ')';
+    out << '\n';
+    if (m_profiler) {
+        m_profiler->collect();
+        out << "Frames: " << m_profiler->frames() << ", mean interval: " << m_profiler->meanInterval()
+            << " ms, 99th percentile sync: " << m_profiler->p99Sync() << " ms, 99th percentile render: " << m_profiler->p99Render() << " ms\n";
+        if (!m_report.isEmpty() && !m_profiler->save(QUrl::fromLocalFile(m_report)))
+            qWarning() << "Failed to save replay report to" << m_report;
+    }
+    out.flush();
+    Q_EMIT finished();
+}
@@ -0,0 +1,110 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef SESSIONREPLAY_H
+#define SESSIONREPLAY_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QString>
+
+#include "frameprofiler.h"
+#include "promptsession.h"
+
+// Plays a recorded session back into a Flickable, so rendering can be benchmarked on real scroll patterns. Running as
+// fast as possible, every frame jumps to the next recorded point. Running in real time, the recorded velocity steers
+// the prompter's own motion, so pacing, ETA and motion statistics go through the same path as a show, and the
+// position is only written when it drifts from the recording by more than half a line.
+class SessionReplay : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(QQuickItem *target READ target WRITE setTarget NOTIFY targetChanged)
+    Q_PROPERTY(QString file READ file WRITE setFile NOTIFY fileChanged)
+    Q_PROPERTY(bool realtime READ realtime WRITE setRealtime NOTIFY realtimeChanged)
+    // Measures render cost while replaying
+    Q_PROPERTY(FrameProfiler *profiler READ profiler WRITE setProfiler NOTIFY profilerChanged)
+    // Where frame samples are saved to once done, as JSON when the file name ends in .json and as CSV otherwise
+    Q_PROPERTY(QString report READ report WRITE setReport NOTIFY reportChanged)
+    // Tells results apart when replaying more than once
+    Q_PROPERTY(QString label READ label WRITE setLabel NOTIFY labelChanged)
+    Q_PROPERTY(bool running READ running NOTIFY runningChanged)
+    // Recorded velocity at the replayed point, in pixels per second
+    Q_PROPERTY(qreal velocity READ velocity NOTIFY velocityChanged)
+
+public:
+    explicit SessionReplay(QObject *parent = nullptr);
+
+    QQuickItem *target() const;
+    void setTarget(QQuickItem *target);
+    QString file() const;
+    void setFile(const QString &file);
+    bool realtime() const;
+    void setRealtime(bool realtime);
+    FrameProfiler *profiler() const;
+    void setProfiler(FrameProfiler *profiler);
+    QString report() const;
+    void setReport(const QString &report);
+    QString label() const;
+    void setLabel(const QString &label);
+    bool running() const;
+    qreal velocity() const;
+
+public Q_SLOTS:
+    void start();
+    void stop();
+
+Q_SIGNALS:
+    void targetChanged();
+    void fileChanged();
+    void realtimeChanged();
+    void profilerChanged();
+    void reportChanged();
+    void labelChanged();
+    void runningChanged();
+    void velocityChanged();
+    void finished();
+
+private:
+    void frame();
+    void finish();
+    void setVelocity(qreal velocity);
+
+    QPointer<QQuickItem> m_target;
+    QPointer<QQuickWindow> m_window;
+    QString m_file;
+    bool m_realtime;
+    QPointer<FrameProfiler> m_profiler;
+    QString m_report;
+    QString m_label;
+
+    QList<DataPoint> m_points;
+    qsizetype m_index;
+    qreal m_velocity;
+    QElapsedTimer m_clock;
+};
+
+#endif // SESSIONREPLAY_H
@@ -0,0 +1,137 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+#include "speechaligner.h"
+
+// Band searched around the last aligned word, in words
+static constexpr int BAND_BEHIND = 8;
+static constexpr int BAND_AHEAD = 40;
+// Band searched after repeated misses
+static constexpr int RECOVERY_BAND = 400;
+static constexpr int MAX_MISSES = 4;
+// Words closer than this are considered the same
+static constexpr qreal MATCH_SIMILARITY = 0.7;
+static constexpr qreal MATCH_SCORE = 2;
+static constexpr qreal MISMATCH_PENALTY = 1;
+static constexpr qreal GAP_PENALTY = 1;
+// About two words matched in a row
+static constexpr qreal MIN_SCORE = 3;
+
+SpeechAligner::SpeechAligner()
+    : m_position(0)
+    , m_misses(0)
+{
+}
+
+void SpeechAligner::setWords(const QStringList &words)
+{
+    m_words = words;
+    m_position = 0;
+    m_misses = 0;
+}
+
+int SpeechAligner::position() const
+{
+    return m_position;
+}
+
+void SpeechAligner::setPosition(int position)
+{
+    m_position = qBound(0, position, qMax(0, int(m_words.size()) - 1));
+    m_misses = 0;
+}
+
+int SpeechAligner::align(const QStringList &recognized)
+{
+    if (m_words.isEmpty() || recognized.isEmpty())
+        return -1;
+
+    const int band = m_misses >= MAX_MISSES ? RECOVERY_BAND : 0;
+    const int first = qMax(0, m_position - BAND_BEHIND - band);
+    const int end = qMin(int(m_words.size()), m_position + BAND_AHEAD + band);
+    const int columns = end - first + 1;
+
+    // Smith-Waterman over the band. Only the last row is needed, since the alignment must end at the newest word.
+    m_previousRow.fill(0, columns);
+    m_row.fill(0, columns);
+    for (const QString &word : recognized) {
+        for (int column = 1; column < columns; column++) {
+            const qreal match = similarity(word, m_words.at(first + column - 1)) >= MATCH_SIMILARITY ? MATCH_SCORE : -MISMATCH_PENALTY;
+            m_row[column] = qMax<qreal>(0, qMax(m_previousRow.at(column - 1) + match, qMax(m_previousRow.at(column), m_row.at(column - 1)) - GAP_PENALTY));
+        }
+        m_previousRow.swap(m_row);
+    }
+
+    // Best alignment, preferring the one closest to the last position on ties
+    int best = -1;
+    qreal bestScore = MIN_SCORE - 1e-6;
+    for (int column = 1; column < columns; column++) {
+        const qreal score = m_previousRow.at(column);
+        const int index = first + column - 1;
+        if (score > bestScore || (best >= 0 && qFuzzyCompare(score, bestScore) && qAbs(index - m_position) < qAbs(best - m_position))) {
+            best = index;
+            bestScore = score;
+        }
+    }
+    if (best < 0) {
+        ++m_misses;
+        return -1;
+    }
+    m_position = best;
+    m_misses = 0;
+    return best;
+}
+
+QString SpeechAligner::normalize(const QString &word)
+{
+    const QString decomposed = word.normalized(QString::NormalizationForm_KD);
+    QString normalized;
+    normalized.reserve(decomposed.size());
+    for (const QChar character : decomposed)
+        if (character.isLetterOrNumber())
+            normalized.append(character.toLower());
+    return normalized;
+}
+
+qreal SpeechAligner::similarity(const QString &a, const QString &b)
+{
+    if (a == b)
+        return 1;
+    const int length = qMax(a.size(), b.size());
+    if (!length || qAbs(a.size() - b.size()) > length * (1 - MATCH_SIMILARITY))
+        return 0;
+
+    // Levenshtein distance over a single row
+    m_distances.resize(b.size() + 1);
+    for (int j = 0; j <= b.size(); j++)
+        m_distances[j] = j;
+    for (int i = 1; i <= a.size(); i++) {
+        int diagonal = m_distances.at(0);
+        m_distances[0] = i;
+        for (int j = 1; j <= b.size(); j++) {
+            const int above = m_distances.at(j);
+            m_distances[j] = qMin(qMin(above, m_distances.at(j - 1)) + 1, diagonal + (a.at(i - 1) == b.at(j - 1) ? 0 : 1));
+            diagonal = above;
+        }
+    }
+    return 1 - qreal(m_distances.at(b.size())) / length;
+}
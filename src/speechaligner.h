@@ -0,0 +1,62 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef SPEECHALIGNER_H
+#define SPEECHALIGNER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Finds where recognized speech is in a script. Recently recognized words are aligned to the script through local
+// alignment with fuzzy word matching, restricted to a band around the last aligned word so each update costs the same
+// however long the script is. The band widens after repeated misses, to recover from skipped passages.
+class SpeechAligner
+{
+public:
+    SpeechAligner();
+
+    // Script words in reading order, normalized
+    void setWords(const QStringList &words);
+    int position() const;
+    void setPosition(int position);
+
+    // Aligns recognized words, oldest first. Returns the index of the script word the newest one aligns to, or -1 if
+    // nothing aligns well enough.
+    int align(const QStringList &recognized);
+
+    // Lower case letters and digits only, without diacritics, so spelling and punctuation differences don't matter.
+    static QString normalize(const QString &word);
+
+private:
+    // 1 for equal words, towards 0 as their edit distance grows
+    qreal similarity(const QString &a, const QString &b);
+
+    QStringList m_words;
+    int m_position;
+    int m_misses;
+    // Reused between calls
+    QList<qreal> m_previousRow;
+    QList<qreal> m_row;
+    QList<int> m_distances;
+};
+
+#endif // SPEECHALIGNER_H
@@ -0,0 +1,392 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+#include "speechfollower.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QQuickTextDocument>
+#include <QTextDocument>
+
+#include <algorithm>
+
+#if defined(Vosk_FOUND)
+#include <vosk_api.h>
+#endif
+
+// Recognized words aligned at a time
+static constexpr int CONTEXT_WORDS = 8;
+// Audio between partial recognition results, in samples. Partial results are costly, and this bounds how stale the
+// position may get.
+static constexpr int UPDATE_INTERVAL = AudioInput::SampleRate / 10;
+static constexpr int STEER_INTERVAL = 100;
+// Time taken to close the distance between the spoken line and the reading region, in seconds
+static constexpr qreal RESPONSE_TIME = 2;
+// Pace is forgotten after this long without progress, in seconds
+static constexpr qreal SILENCE = 2;
+static constexpr qreal PACE_SMOOTHING = 0.3;
+static constexpr qreal MAX_LINES_PER_SECOND = 4;
+
+// Runs on the audio thread.
+class SpeechRecognizer : public AudioProcessor
+{
+public:
+    SpeechRecognizer(SpeechFollower *follower, const QString &modelPath)
+        : m_follower(follower)
+        , m_modelPath(modelPath)
+        , m_failed(false)
+        , m_sinceUpdate(0)
+    {
+    }
+
+    ~SpeechRecognizer()
+    {
+#if defined(Vosk_FOUND)
+        if (m_recognizer)
+            vosk_recognizer_free(m_recognizer);
+        if (m_model)
+            vosk_model_free(m_model);
+#endif
+    }
+
+    void process(const qint16 *samples, qsizetype count) override
+    {
+#if defined(Vosk_FOUND)
+        if (m_failed)
+            return;
+        if (!m_recognizer) {
+            // Models take a while to load, so that happens here rather than on the GUI thread. Audio captured
+            // meanwhile is dropped.
+            vosk_set_log_level(-1);
+            m_model = vosk_model_new(QFile::encodeName(m_modelPath).constData());
+            if (m_model)
+                m_recognizer = vosk_recognizer_new(m_model, AudioInput::SampleRate);
+            if (!m_recognizer) {
+                m_failed = true;
+                QMetaObject::invokeMethod(m_follower, [follower = m_follower]() {
+                    Q_EMIT follower->error(QObject::tr("Cannot load speech recognition model"));
+                }, Qt::QueuedConnection);
+                return;
+            }
+        }
+
+        // 1 ends an utterance, 0 continues it, and -1 is an error after which results can't be trusted.
+        const int accepted = vosk_recognizer_accept_waveform_s(m_recognizer, samples, int(count));
+        if (accepted < 0) {
+            m_failed = true;
+            QMetaObject::invokeMethod(m_follower, [follower = m_follower]() {
+                Q_EMIT follower->error(QObject::tr("Speech recognition failed"));
+            }, Qt::QueuedConnection);
+            return;
+        }
+        const bool utteranceEnded = accepted == 1;
+        m_sinceUpdate += count;
+        if (!utteranceEnded && m_sinceUpdate < UPDATE_INTERVAL)
+            return;
+        m_sinceUpdate = 0;
+
+        QStringList recent;
+        if (utteranceEnded)
+            m_heard.append(words(vosk_recognizer_result(m_recognizer), "text"));
+        else
+            recent = words(vosk_recognizer_partial_result(m_recognizer), "partial");
+        if (m_heard.size() > CONTEXT_WORDS)
+            m_heard.remove(0, m_heard.size() - CONTEXT_WORDS);
+        recent.prepend(m_heard);
+        if (recent.size() > CONTEXT_WORDS)
+            recent.remove(0, recent.size() - CONTEXT_WORDS);
+        if (recent.isEmpty() || recent == m_sent)
+            return;
+        m_sent = recent;
+        QMetaObject::invokeMethod(m_follower, [follower = m_follower, recent]() {
+            follower->recognized(recent);
+        }, Qt::QueuedConnection);
+#else
+        Q_UNUSED(samples)
+        Q_UNUSED(count)
+#endif
+    }
+
+private:
+    static QStringList words(const char *result, const char *key)
+    {
+        QStringList words;
+        const QString text = QJsonDocument::fromJson(QByteArray(result)).object().value(QLatin1String(key)).toString();
+        for (const QString &word : text.split(QLatin1Char(' '), Qt::SkipEmptyParts)) {
+            const QString normalized = SpeechAligner::normalize(word);
+            if (!normalized.isEmpty())
+                words.append(normalized);
+        }
+        return words;
+    }
+
+    SpeechFollower *m_follower;
+    QString m_modelPath;
+#if defined(Vosk_FOUND)
+    VoskModel *m_model = nullptr;
+    VoskRecognizer *m_recognizer = nullptr;
+#endif
+    bool m_failed;
+    qsizetype m_sinceUpdate;
+    // Last words of finished utterances
+    QStringList m_heard;
+    QStringList m_sent;
+};
+
+SpeechFollower::SpeechFollower(QObject *parent)
+    : QObject(parent)
+    , m_readOffset(0)
+    , m_lineHeight(0)
+    , m_active(false)
+    , m_velocity(0)
+    , m_spokenY(0)
+    , m_pace(0)
+{
+    m_steerTimer.setInterval(STEER_INTERVAL);
+    connect(&m_steerTimer, &QTimer::timeout, this, &SpeechFollower::steer);
+}
+
+SpeechFollower::~SpeechFollower()
+{
+    stop();
+}
+
+DocumentHandler *SpeechFollower::document() const
+{
+    return m_document;
+}
+
+void SpeechFollower::setDocument(DocumentHandler *document)
+{
+    if (document == m_document)
+        return;
+
+    m_document = document;
+    Q_EMIT documentChanged();
+}
+
+QQuickItem *SpeechFollower::target() const
+{
+    return m_target;
+}
+
+void SpeechFollower::setTarget(QQuickItem *target)
+{
+    if (target == m_target)
+        return;
+
+    m_target = target;
+    Q_EMIT targetChanged();
+}
+
+qreal SpeechFollower::readOffset() const
+{
+    return m_readOffset;
+}
+
+void SpeechFollower::setReadOffset(qreal readOffset)
+{
+    if (qFuzzyCompare(readOffset, m_readOffset))
+        return;
+
+    m_readOffset = readOffset;
+    Q_EMIT layoutChanged();
+}
+
+qreal SpeechFollower::lineHeight() const
+{
+    return m_lineHeight;
+}
+
+void SpeechFollower::setLineHeight(qreal lineHeight)
+{
+    if (qFuzzyCompare(lineHeight, m_lineHeight))
+        return;
+
+    m_lineHeight = lineHeight;
+    Q_EMIT layoutChanged();
+}
+
+bool SpeechFollower::active() const
+{
+    return m_active;
+}
+
+void SpeechFollower::setActive(bool active)
+{
+    if (active == m_active)
+        return;
+
+    m_active = active;
+    if (m_active)
+        start();
+    else
+        stop();
+    Q_EMIT activeChanged();
+}
+
+QUrl SpeechFollower::model() const
+{
+    return m_model;
+}
+
+void SpeechFollower::setModel(const QUrl &model)
+{
+    if (model == m_model)
+        return;
+
+    m_model = model;
+    Q_EMIT modelChanged();
+}
+
+QString SpeechFollower::source() const
+{
+    return m_source;
+}
+
+void SpeechFollower::setSource(const QString &source)
+{
+    if (source == m_source)
+        return;
+
+    m_source = source;
+    Q_EMIT sourceChanged();
+}
+
+bool SpeechFollower::available() const
+{
+#if defined(Vosk_FOUND)
+    return true;
+#else
+    return false;
+#endif
+}
+
+qreal SpeechFollower::velocity() const
+{
+    return m_velocity;
+}
+
+void SpeechFollower::start()
+{
+    if (!available()) {
+        Q_EMIT error(tr("This build doesn't include speech recognition"));
+        return;
+    }
+    if (m_model.isEmpty()) {
+        Q_EMIT error(tr("No speech recognition model was chosen"));
+        return;
+    }
+
+    indexDocument();
+    m_pace = 0;
+    m_lastMatch.invalidate();
+    m_spokenY = m_target ? m_target->property("contentY").toReal() + m_readOffset : 0;
+    m_recognizer = std::make_unique<SpeechRecognizer>(this, m_model.toLocalFile());
+    m_input = std::make_unique<AudioInput>(m_recognizer.get());
+    connect(m_input.get(), &AudioInput::error, this, &SpeechFollower::error);
+    m_input->start(m_source);
+    m_steerTimer.start();
+}
+
+void SpeechFollower::stop()
+{
+    m_steerTimer.stop();
+    m_input.reset();
+    m_recognizer.reset();
+    setVelocity(0);
+}
+
+void SpeechFollower::indexDocument()
+{
+    QStringList words;
+    m_wordPositions.clear();
+    if (m_document && m_document->document()) {
+        const QString text = m_document->document()->textDocument()->toPlainText();
+        for (qsizetype i = 0; i < text.size();) {
+            while (i < text.size() && text.at(i).isSpace())
+                i++;
+            const qsizetype start = i;
+            while (i < text.size() && !text.at(i).isSpace())
+                i++;
+            const QString normalized = SpeechAligner::normalize(text.mid(start, i - start));
+            if (normalized.isEmpty())
+                continue;
+            words.append(normalized);
+            m_wordPositions.append(start);
+        }
+    }
+    m_aligner.setWords(words);
+
+    // Start from the first word at or past the reading region.
+    if (!m_target || m_wordPositions.isEmpty())
+        return;
+    const qreal readY = m_target->property("contentY").toReal() + m_readOffset - m_lineHeight / 2;
+    const auto word = std::lower_bound(m_wordPositions.cbegin(), m_wordPositions.cend(), readY, [this](int position, qreal y) {
+        return m_document->cursorY(position) < y;
+    });
+    m_aligner.setPosition(word - m_wordPositions.cbegin());
+}
+
+void SpeechFollower::recognized(const QStringList &words)
+{
+    if (!m_input || !m_document)
+        return;
+
+    const int index = m_aligner.align(words);
+    if (index < 0)
+        return;
+
+    const qreal y = m_document->cursorY(m_wordPositions.at(index)) + m_lineHeight / 2;
+    if (m_lastMatch.isValid()) {
+        const qreal elapsed = m_lastMatch.elapsed() / 1000.;
+        if (y > m_spokenY && elapsed > 0 && elapsed < SILENCE)
+            m_pace += PACE_SMOOTHING * ((y - m_spokenY) / elapsed - m_pace);
+    }
+    if (!m_lastMatch.isValid() || y > m_spokenY)
+        m_lastMatch.start();
+    m_spokenY = y;
+    steer();
+}
+
+void SpeechFollower::steer()
+{
+    if (!m_target)
+        return;
+
+    if (m_lastMatch.isValid() && m_lastMatch.elapsed() / 1000. > SILENCE)
+        m_pace = 0;
+    // Move at the speaking pace, plus whatever closes the distance to the spoken line. Never back up; the talent may be
+    // repeating themselves.
+    const qreal distance = m_spokenY - (m_target->property("contentY").toReal() + m_readOffset);
+    setVelocity(qBound<qreal>(0, m_pace + distance / RESPONSE_TIME, m_lineHeight * MAX_LINES_PER_SECOND));
+}
+
+void SpeechFollower::setVelocity(qreal velocity)
+{
+    if (qFuzzyCompare(velocity, m_velocity))
+        return;
+
+    m_velocity = velocity;
+    Q_EMIT velocityChanged();
+}
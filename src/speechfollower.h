@@ -0,0 +1,131 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef SPEECHFOLLOWER_H
+#define SPEECHFOLLOWER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QString>
+#include <QTimer>
+#include <QUrl>
+
+#include <memory>
+
+#include "audioinput.h"
+#include "documenthandler.h"
+#include "speechaligner.h"
+
+class SpeechRecognizer;
+
+// Steers prompting by speech. Audio is recognized offline on the CPU, on the audio thread, and recognized words are
+// aligned to the script. The resulting velocity keeps the spoken line at the reading region.
+class SpeechFollower : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(DocumentHandler *document READ document WRITE setDocument NOTIFY documentChanged)
+    // Flickable showing the document
+    Q_PROPERTY(QQuickItem *target READ target WRITE setTarget NOTIFY targetChanged)
+    // Distance from the top of the target to the middle of the reading region
+    Q_PROPERTY(qreal readOffset READ readOffset WRITE setReadOffset NOTIFY layoutChanged)
+    Q_PROPERTY(qreal lineHeight READ lineHeight WRITE setLineHeight NOTIFY layoutChanged)
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    // Directory of the speech recognition model
+    Q_PROPERTY(QUrl model READ model WRITE setModel NOTIFY modelChanged)
+    // WAV file to follow instead of the microphone
+    Q_PROPERTY(QString source READ source WRITE setSource NOTIFY sourceChanged)
+    // Whether this build includes speech recognition
+    Q_PROPERTY(bool available READ available CONSTANT)
+    // Pixels per second
+    Q_PROPERTY(qreal velocity READ velocity NOTIFY velocityChanged)
+
+public:
+    explicit SpeechFollower(QObject *parent = nullptr);
+    ~SpeechFollower();
+
+    DocumentHandler *document() const;
+    void setDocument(DocumentHandler *document);
+    QQuickItem *target() const;
+    void setTarget(QQuickItem *target);
+    qreal readOffset() const;
+    void setReadOffset(qreal readOffset);
+    qreal lineHeight() const;
+    void setLineHeight(qreal lineHeight);
+    bool active() const;
+    void setActive(bool active);
+    QUrl model() const;
+    void setModel(const QUrl &model);
+    QString source() const;
+    void setSource(const QString &source);
+    bool available() const;
+    qreal velocity() const;
+
+Q_SIGNALS:
+    void documentChanged();
+    void targetChanged();
+    void layoutChanged();
+    void activeChanged();
+    void modelChanged();
+    void sourceChanged();
+    void velocityChanged();
+    void error(const QString &message);
+
+private:
+    friend class SpeechRecognizer;
+
+    void start();
+    void stop();
+    void indexDocument();
+    void recognized(const QStringList &words);
+    void steer();
+    void setVelocity(qreal velocity);
+
+    QPointer<DocumentHandler> m_document;
+    QPointer<QQuickItem> m_target;
+    qreal m_readOffset;
+    qreal m_lineHeight;
+    bool m_active;
+    QUrl m_model;
+    QString m_source;
+    qreal m_velocity;
+
+    SpeechAligner m_aligner;
+    // Cursor position of each script word
+    QList<int> m_wordPositions;
+    // Destroyed after the input that feeds it
+    std::unique_ptr<SpeechRecognizer> m_recognizer;
+    std::unique_ptr<AudioInput> m_input;
+
+    QTimer m_steerTimer;
+    QElapsedTimer m_lastMatch;
+    // Document y of the middle of the line last spoken
+    qreal m_spokenY;
+    // Smoothed speaking pace, in pixels per second
+    qreal m_pace;
+};
+
+#endif // SPEECHFOLLOWER_H
@@ -12,7 +12,7 @@
  ** This program is distributed in the hope that it will be useful,
  ** but WITHOUT ANY WARRANTY; without even the implied warranty of
  ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- ** GNU General Public License for more details.
+ ** GNU General Public License for more details
  **
  ** You should have received a copy of the GNU General Public License
  ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
@@ -21,6 +21,318 @@
 
 #include "telemetry.h"
 
-#include "promptsession.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QQuickWindow>
+#include <QStandardPaths>
+#include <QtEndian>
 
+static constexpr char FORMAT_MAGIC[] = "QPSN";
+static constexpr quint8 FORMAT_VERSION = 1;
+// Points per block. Bounds the writer's memory and what may be lost if QPrompt doesn't exit cleanly.
+static constexpr int BLOCK_SIZE = 1024;
+// How long the writer sleeps between drains of the ring, in milliseconds
+static constexpr int DRAIN_INTERVAL = 100;
+static constexpr qreal POSITION_UNITS = 64;
+// DataPoint fields stored per point
+static constexpr quint32 COLUMN_COUNT = 5;
 
+static void appendVarint(QByteArray &out, qint64 value)
+{
+    // Zigzag encoding keeps small negative deltas small.
+    quint64 encoded = (quint64(value) << 1) ^ quint64(value >> 63);
+    while (encoded >= 0x80) {
+        out.append(char(encoded | 0x80));
+        encoded >>= 7;
+    }
+    out.append(char(encoded));
+}
+
+static bool readVarint(const QByteArray &in, qsizetype &offset, qint64 &value)
+{
+    quint64 encoded = 0;
+    for (int shift = 0; offset < in.size() && shift < 64; shift += 7) {
+        const quint8 byte = quint8(in.at(offset++));
+        encoded |= quint64(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            value = qint64(encoded >> 1) ^ -qint64(encoded & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void writeBlock(QFile &file, const QList<DataPoint> &block, QByteArray &columns)
+{
+    columns.resize(0);
+    const auto appendColumn = [&](auto field) {
+        qint64 previous = 0;
+        for (const DataPoint &point : block) {
+            const qint64 value = field(point);
+            appendVarint(columns, value - previous);
+            previous = value;
+        }
+    };
+    appendColumn([](const DataPoint &point) { return qint64(point.time); });
+    appendColumn([](const DataPoint &point) { return qRound64(point.position * POSITION_UNITS); });
+    appendColumn([](const DataPoint &point) { return qint64(point.prompterWidth); });
+    appendColumn([](const DataPoint &point) { return qint64(point.lineWidth); });
+    appendColumn([](const DataPoint &point) { return qint64(point.lineHeight); });
+
+    const QByteArray payload = qCompress(columns);
+    quint32 header[2] = {qToLittleEndian(quint32(block.size())), qToLittleEndian(quint32(payload.size()))};
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    file.write(payload);
+    file.flush();
+}
+
+Telemetry::Telemetry(QObject *parent)
+    : QObject(parent)
+    , m_lineWidth(0)
+    , m_lineHeight(0)
+    , m_writer(nullptr)
+    , m_startPending(false)
+    , m_recording(false)
+    , m_droppedPoints(0)
+{
+}
+
+Telemetry::~Telemetry()
+{
+    // The writer uses this object, so it has to finish here.
+    if (m_writer) {
+        m_recording.store(false, std::memory_order_release);
+        m_writer->wait();
+        delete m_writer;
+    }
+}
+
+QQuickItem *Telemetry::target() const
+{
+    return m_target;
+}
+
+void Telemetry::setTarget(QQuickItem *target)
+{
+    if (target == m_target)
+        return;
+
+    if (m_target)
+        disconnect(m_target, &QQuickItem::windowChanged, this, &Telemetry::windowChanged);
+    m_target = target;
+    if (m_target)
+        connect(m_target, &QQuickItem::windowChanged, this, &Telemetry::windowChanged);
+    windowChanged(m_target ? m_target->window() : nullptr);
+    Q_EMIT targetChanged();
+}
+
+int Telemetry::lineWidth() const
+{
+    return m_lineWidth;
+}
+
+void Telemetry::setLineWidth(int lineWidth)
+{
+    if (lineWidth == m_lineWidth)
+        return;
+
+    m_lineWidth = lineWidth;
+    Q_EMIT lineWidthChanged();
+}
+
+int Telemetry::lineHeight() const
+{
+    return m_lineHeight;
+}
+
+void Telemetry::setLineHeight(int lineHeight)
+{
+    if (lineHeight == m_lineHeight)
+        return;
+
+    m_lineHeight = lineHeight;
+    Q_EMIT lineHeightChanged();
+}
+
+bool Telemetry::recording() const
+{
+    return m_writer != nullptr;
+}
+
+QString Telemetry::sessionFile() const
+{
+    return m_sessionFile;
+}
+
+int Telemetry::droppedPoints() const
+{
+    return m_droppedPoints.load(std::memory_order_relaxed);
+}
+
+void Telemetry::startSession()
+{
+    if (m_writer) {
+        // The ring and session file belong to the previous session until its writer exits.
+        if (!m_recording.load(std::memory_order_relaxed))
+            m_startPending = true;
+        return;
+    }
+
+    const QString sessionsPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/sessions");
+    QDir().mkpath(sessionsPath);
+    m_sessionFile = sessionsPath + QLatin1Char('/') + QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-hhmmss")) + QStringLiteral(".qpsession");
+    m_ring.clear();
+    m_droppedPoints.store(0, std::memory_order_relaxed);
+    m_clock.start();
+    m_recording.store(true, std::memory_order_release);
+    m_writer = QThread::create([this]() {
+        write();
+    });
+    connect(m_writer, &QThread::finished, this, &Telemetry::writerFinished);
+    m_writer->start(QThread::LowPriority);
+    Q_EMIT recordingChanged();
+}
+
+void Telemetry::endSession()
+{
+    m_startPending = false;
+    if (!m_writer)
+        return;
+
+    // The writer drains what's left in the ring before it exits, which may take a drain interval and the last block's
+    // compression. It's left to finish on its own rather than blocking the GUI thread, and recording turns false once
+    // the file is complete.
+    m_recording.store(false, std::memory_order_release);
+}
+
+void Telemetry::writerFinished()
+{
+    m_writer->deleteLater();
+    m_writer = nullptr;
+    Q_EMIT recordingChanged();
+    if (m_startPending) {
+        m_startPending = false;
+        startSession();
+    }
+}
+
+void Telemetry::appendDataPoint(const DataPoint &data)
+{
+    if (!m_recording.load(std::memory_order_relaxed))
+        return;
+    if (!m_ring.push(data))
+        m_droppedPoints.fetch_add(1, std::memory_order_relaxed);
+}
+
+QList<DataPoint> Telemetry::loadSession(const QString &filePath)
+{
+    QList<DataPoint> points;
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly) || file.read(4) != FORMAT_MAGIC || file.read(1) != QByteArray(1, char(FORMAT_VERSION)))
+        return points;
+
+    while (!file.atEnd()) {
+        quint32 header[2];
+        if (file.read(reinterpret_cast<char *>(header), sizeof(header)) != sizeof(header))
+            break;
+        const quint32 count = qFromLittleEndian(header[0]);
+        const quint32 payloadSize = qFromLittleEndian(header[1]);
+        // Headers aren't trusted: a block must fit in what's left of the file, and hold no more points than the writer
+        // puts in one, before anything is allocated for it.
+        if (count > quint32(BLOCK_SIZE) || payloadSize < 4 || payloadSize > quint64(file.bytesAvailable())) {
+            qWarning() << "Invalid session block in" << filePath;
+            break;
+        }
+        const QByteArray payload = file.read(payloadSize);
+        // qCompress prefixes the uncompressed size. Each point takes between one and ten bytes per column.
+        const quint32 uncompressedSize = qFromBigEndian<quint32>(payload.constData());
+        if (uncompressedSize < count * COLUMN_COUNT || uncompressedSize > count * COLUMN_COUNT * 10) {
+            qWarning() << "Invalid session block in" << filePath;
+            break;
+        }
+        const QByteArray columns = qUncompress(payload);
+        if (columns.size() != qsizetype(uncompressedSize)) {
+            qWarning() << "Invalid session block in" << filePath;
+            break;
+        }
+        const qsizetype first = points.size();
+        points.resize(first + count);
+
+        qsizetype offset = 0;
+        const auto readColumn = [&](auto assign) {
+            qint64 value = 0, delta = 0;
+            for (quint32 i = 0; i < count; i++) {
+                if (!readVarint(columns, offset, delta))
+                    return false;
+                value += delta;
+                assign(points[first + i], value);
+            }
+            return true;
+        };
+        const bool valid = readColumn([](DataPoint &point, qint64 value) { point.time = int(value); })
+            && readColumn([](DataPoint &point, qint64 value) { point.position = value / POSITION_UNITS; })
+            && readColumn([](DataPoint &point, qint64 value) { point.prompterWidth = int(value); })
+            && readColumn([](DataPoint &point, qint64 value) { point.lineWidth = int(value); })
+            && readColumn([](DataPoint &point, qint64 value) { point.lineHeight = int(value); });
+        if (!valid) {
+            qWarning() << "Truncated session block in" << filePath;
+            points.resize(first);
+            break;
+        }
+    }
+    return points;
+}
+
+void Telemetry::windowChanged(QQuickWindow *window)
+{
+    if (m_window)
+        disconnect(m_window, &QQuickWindow::afterAnimating, this, &Telemetry::frame);
+    m_window = window;
+    if (m_window)
+        connect(m_window, &QQuickWindow::afterAnimating, this, &Telemetry::frame);
+}
+
+// Runs on the GUI thread once per frame. Must not allocate or lock.
+void Telemetry::frame()
+{
+    if (!m_recording.load(std::memory_order_relaxed) || !m_target)
+        return;
+    appendDataPoint(DataPoint(int(m_clock.elapsed()), m_target->property("contentY").toReal(), int(m_target->width()), m_lineWidth, m_lineHeight));
+}
+
+// Runs on the writer thread for the length of a session.
+void Telemetry::write()
+{
+    QFile file(m_sessionFile);
+    const bool opened = file.open(QFile::WriteOnly | QFile::Truncate);
+    if (opened) {
+        file.write(FORMAT_MAGIC, 4);
+        file.putChar(char(FORMAT_VERSION));
+    }
+    else
+        qWarning() << "Failed to record session to" << m_sessionFile << file.errorString();
+
+    QList<DataPoint> block;
+    block.reserve(BLOCK_SIZE);
+    QByteArray columns;
+    bool recording = true;
+    while (recording) {
+        // Read before draining, so points pushed before the session ended are always written.
+        recording = m_recording.load(std::memory_order_acquire);
+        DataPoint point;
+        while (m_ring.pop(point)) {
+            block.append(point);
+            if (block.size() == BLOCK_SIZE) {
+                if (opened)
+                    writeBlock(file, block, columns);
+                block.clear();
+            }
+        }
+        if (recording)
+            QThread::msleep(DRAIN_INTERVAL);
+    }
+    if (opened && !block.isEmpty())
+        writeBlock(file, block, columns);
+}
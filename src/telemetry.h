@@ -18,28 +18,139 @@
  ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
  **
  ****************************************************************************/
-
 #ifndef TELEMETRY_H
 #define TELEMETRY_H
 
+#include <QElapsedTimer>
+#include <QList>
 #include <QObject>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QString>
+#include <QThread>
+
+#include <array>
+#include <atomic>
 
 #include "promptsession.h"
 
+class QQuickWindow;
+
+// Bounded single producer, single consumer queue. Neither side locks or allocates; pushes fail while it's full.
+template<typename T, int Capacity>
+class SpscRing
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool push(const T &value)
+    {
+        const quint64 head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) >= Capacity)
+            return false;
+        m_values[head & (Capacity - 1)] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &value)
+    {
+        const quint64 tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+            return false;
+        value = m_values[tail & (Capacity - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    void clear()
+    {
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<T, Capacity> m_values;
+    std::atomic<quint64> m_head{0};
+    std::atomic<quint64> m_tail{0};
+};
+
+// Records a data point for every frame prepared while a session runs. Points go through a preallocated ring to a writer
+// thread, which stores them in blocks of delta encoded, compressed columns:
+//
+//   File:   "QPSN", version (quint8), then blocks until the end of the file
+//   Block:  point count (quint32 LE), payload size (quint32 LE), payload compressed with qCompress
+//   Payload: one column per DataPoint field, in declaration order, each holding a zigzag varint delta from the previous
+//            point in the block. Positions are stored in 1/64 pixel units.
 class Telemetry : public QObject
 {
-Q_OBJECT
+    Q_OBJECT
+    QML_ELEMENT
+
+    // Flickable whose contentY and width are recorded
+    Q_PROPERTY(QQuickItem *target READ target WRITE setTarget NOTIFY targetChanged)
+    Q_PROPERTY(int lineWidth READ lineWidth WRITE setLineWidth NOTIFY lineWidthChanged)
+    Q_PROPERTY(int lineHeight READ lineHeight WRITE setLineHeight NOTIFY lineHeightChanged)
+    // Stays true after a session ends until its file is completely written
+    Q_PROPERTY(bool recording READ recording NOTIFY recordingChanged)
+    Q_PROPERTY(QString sessionFile READ sessionFile NOTIFY recordingChanged)
+    // Points lost because the writer fell behind, in the current or last session
+    Q_PROPERTY(int droppedPoints READ droppedPoints NOTIFY recordingChanged)
+
+public:
+    explicit Telemetry(QObject *parent = nullptr);
+    ~Telemetry();
+
+    QQuickItem *target() const;
+    void setTarget(QQuickItem *target);
+    int lineWidth() const;
+    void setLineWidth(int lineWidth);
+    int lineHeight() const;
+    void setLineHeight(int lineHeight);
+    bool recording() const;
+    QString sessionFile() const;
+    int droppedPoints() const;
+
+    // Reads every data point of a recorded session. Reading stops at the first block that doesn't fit the file.
+    static QList<DataPoint> loadSession(const QString &filePath);
+
+public Q_SLOTS:
+    void startSession();
+    void endSession();
+    void appendDataPoint(const DataPoint &data);
+
+Q_SIGNALS:
+    void targetChanged();
+    void lineWidthChanged();
+    void lineHeightChanged();
+    void recordingChanged();
+
+private:
+    // About a minute at 120 Hz, a few seconds of which the writer ever falls behind
+    static constexpr int RingCapacity = 8192;
+
+    void windowChanged(QQuickWindow *window);
+    void frame();
+    void write();
+    void writerFinished();
 
-public slots:
-//     void startSession();
-//     void endSession();
-//     void updateSettings();
-//     void appendDataPoint(DataPoint &data);
+    QPointer<QQuickItem> m_target;
+    QPointer<QQuickWindow> m_window;
+    int m_lineWidth;
+    int m_lineHeight;
 
-// private:
-//     void generateSessionUniqueID();
-//     void detectBlockLanguage();
+    // GUI thread
+    QElapsedTimer m_clock;
+    QString m_sessionFile;
+    QThread *m_writer;
+    // A session was started while the previous one was still being written
+    bool m_startPending;
 
+    // Shared with the writer
+    SpscRing<DataPoint, RingCapacity> m_ring;
+    std::atomic<bool> m_recording;
+    std::atomic<int> m_droppedPoints;
 };
 
 #endif // TELEMETRY_H
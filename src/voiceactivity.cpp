@@ -0,0 +1,386 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+#include "voiceactivity.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QList>
+#include <QTextStream>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VAD_SSE2
+#include <emmintrin.h>
+#endif
+
+static constexpr float PRE_EMPHASIS = 0.95f;
+// Decibels the threshold drops by once speech starts
+static constexpr float HYSTERESIS = 3;
+// Pre-emphasis removes at most this many decibels from speech; more means low frequency rumble.
+static constexpr float MAX_TILT = 15;
+// Zero crossings per sample above which a frame is considered hiss
+static constexpr float MAX_CROSSING_RATE = 0.45f;
+static constexpr int ONSET_FRAMES = 2;
+// Noise floor adaptation per frame
+static constexpr float FLOOR_FALL = 0.2f;
+static constexpr float FLOOR_RISE = 0.01f;
+static constexpr float FLOOR_RISE_SPEAKING = 0.001f;
+
+namespace
+{
+struct FrameFeatures {
+    float energy = 0;
+    float emphasised = 0;
+    int crossings = 0;
+};
+
+// Sums of squares of the frame and of its pre-emphasised version, and sign changes. samples[-1] must be the sample
+// before the frame.
+FrameFeatures measure(const qint16 *samples, int count)
+{
+    FrameFeatures features;
+    int i = 0;
+#if defined(VAD_SSE2)
+    const __m128 emphasis = _mm_set1_ps(PRE_EMPHASIS);
+    const __m128i zero = _mm_setzero_si128();
+    __m128 energy = _mm_setzero_ps();
+    __m128 emphasised = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+        const __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i - 1));
+        // Samples of opposite signs have the sign bit of their XOR set; the mask holds two bits per sample.
+        features.crossings += qPopulationCount(quint32(_mm_movemask_epi8(_mm_cmplt_epi16(_mm_xor_si128(current, previous), zero)))) / 2;
+
+        const __m128 currentLow = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(current, current), 16));
+        const __m128 currentHigh = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(current, current), 16));
+        const __m128 previousLow = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(previous, previous), 16));
+        const __m128 previousHigh = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(previous, previous), 16));
+        energy = _mm_add_ps(energy, _mm_add_ps(_mm_mul_ps(currentLow, currentLow), _mm_mul_ps(currentHigh, currentHigh)));
+        const __m128 emphasisedLow = _mm_sub_ps(currentLow, _mm_mul_ps(emphasis, previousLow));
+        const __m128 emphasisedHigh = _mm_sub_ps(currentHigh, _mm_mul_ps(emphasis, previousHigh));
+        emphasised = _mm_add_ps(emphasised, _mm_add_ps(_mm_mul_ps(emphasisedLow, emphasisedLow), _mm_mul_ps(emphasisedHigh, emphasisedHigh)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, energy);
+    features.energy = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_store_ps(lanes, emphasised);
+    features.emphasised = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < count; i++) {
+        const float current = samples[i];
+        const float previous = samples[i - 1];
+        const float difference = current - PRE_EMPHASIS * previous;
+        features.energy += current * current;
+        features.emphasised += difference * difference;
+        features.crossings += (samples[i] ^ samples[i - 1]) < 0;
+    }
+    return features;
+}
+}
+
+VoiceActivityAnalyzer::VoiceActivityAnalyzer(Transition transition)
+    : m_transition(std::move(transition))
+    , m_threshold(9)
+    , m_hangoverFrames(50)
+    , m_frame{}
+    , m_buffered(0)
+    , m_samples(0)
+    , m_noiseFloor(0)
+    , m_speaking(false)
+    , m_speechFrames(0)
+    , m_otherFrames(0)
+    , m_analysisTime(0)
+{
+}
+
+void VoiceActivityAnalyzer::setThreshold(float threshold)
+{
+    m_threshold.store(threshold, std::memory_order_relaxed);
+}
+
+void VoiceActivityAnalyzer::setHangover(int hangover)
+{
+    m_hangoverFrames.store(qMax(1, hangover * AudioInput::SampleRate / 1000 / FrameSize), std::memory_order_relaxed);
+}
+
+void VoiceActivityAnalyzer::process(const qint16 *samples, qsizetype count)
+{
+    while (count > 0) {
+        const int taken = int(qMin<qsizetype>(count, FrameSize - m_buffered));
+        std::copy(samples, samples + taken, m_frame + 1 + m_buffered);
+        m_buffered += taken;
+        samples += taken;
+        count -= taken;
+        if (m_buffered == FrameSize) {
+            analyse();
+            m_buffered = 0;
+        }
+    }
+}
+
+qint64 VoiceActivityAnalyzer::samples() const
+{
+    return m_samples;
+}
+
+qint64 VoiceActivityAnalyzer::analysisTime() const
+{
+    return m_analysisTime;
+}
+
+void VoiceActivityAnalyzer::analyse()
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    const FrameFeatures features = measure(m_frame + 1, FrameSize);
+    const float energy = 10 * std::log10(features.energy / FrameSize + 1);
+    const float emphasised = 10 * std::log10(features.emphasised / FrameSize + 1);
+    const float crossingRate = float(features.crossings) / FrameSize;
+    if (!m_samples)
+        m_noiseFloor = energy;
+
+    const float threshold = m_threshold.load(std::memory_order_relaxed) - (m_speaking ? HYSTERESIS : 0);
+    const bool speech = energy > m_noiseFloor + threshold && emphasised > energy - MAX_TILT && crossingRate < MAX_CROSSING_RATE;
+    // The floor follows quieter frames down quickly and louder ones up slowly, barely moving while speech goes on.
+    const float adaptation = energy < m_noiseFloor ? FLOOR_FALL : speech ? FLOOR_RISE_SPEAKING : FLOOR_RISE;
+    m_noiseFloor += (energy - m_noiseFloor) * adaptation;
+
+    m_samples += FrameSize;
+    m_frame[0] = m_frame[FrameSize];
+    if (speech) {
+        ++m_speechFrames;
+        m_otherFrames = 0;
+    }
+    else {
+        ++m_otherFrames;
+        m_speechFrames = 0;
+    }
+    m_analysisTime += clock.nsecsElapsed();
+
+    if (!m_speaking && m_speechFrames >= ONSET_FRAMES) {
+        m_speaking = true;
+        m_transition(true, m_samples);
+    }
+    else if (m_speaking && m_otherFrames >= m_hangoverFrames.load(std::memory_order_relaxed)) {
+        m_speaking = false;
+        m_transition(false, m_samples);
+    }
+}
+
+VoiceActivityDetector::VoiceActivityDetector(QObject *parent)
+    : QObject(parent)
+    , m_active(false)
+    , m_threshold(9)
+    , m_hangover(500)
+    , m_speaking(false)
+{
+}
+
+VoiceActivityDetector::~VoiceActivityDetector()
+{
+    setActive(false);
+}
+
+bool VoiceActivityDetector::active() const
+{
+    return m_active;
+}
+
+void VoiceActivityDetector::setActive(bool active)
+{
+    if (active == m_active)
+        return;
+
+    m_active = active;
+    if (m_active) {
+        m_analyzer = std::make_unique<VoiceActivityAnalyzer>([this](bool speaking, qint64) {
+            QMetaObject::invokeMethod(this, [this, speaking]() {
+                if (m_active)
+                    setSpeaking(speaking);
+            }, Qt::QueuedConnection);
+        });
+        m_analyzer->setThreshold(m_threshold);
+        m_analyzer->setHangover(m_hangover);
+        m_input = std::make_unique<AudioInput>(m_analyzer.get());
+        connect(m_input.get(), &AudioInput::error, this, &VoiceActivityDetector::error);
+        m_input->start(m_source);
+    }
+    else {
+        m_input.reset();
+        m_analyzer.reset();
+        setSpeaking(false);
+    }
+    Q_EMIT activeChanged();
+}
+
+QString VoiceActivityDetector::source() const
+{
+    return m_source;
+}
+
+void VoiceActivityDetector::setSource(const QString &source)
+{
+    if (source == m_source)
+        return;
+
+    m_source = source;
+    Q_EMIT sourceChanged();
+}
+
+qreal VoiceActivityDetector::threshold() const
+{
+    return m_threshold;
+}
+
+void VoiceActivityDetector::setThreshold(qreal threshold)
+{
+    if (qFuzzyCompare(threshold, m_threshold))
+        return;
+
+    m_threshold = threshold;
+    if (m_analyzer)
+        m_analyzer->setThreshold(m_threshold);
+    Q_EMIT thresholdChanged();
+}
+
+int VoiceActivityDetector::hangover() const
+{
+    return m_hangover;
+}
+
+void VoiceActivityDetector::setHangover(int hangover)
+{
+    if (hangover == m_hangover)
+        return;
+
+    m_hangover = hangover;
+    if (m_analyzer)
+        m_analyzer->setHangover(m_hangover);
+    Q_EMIT hangoverChanged();
+}
+
+bool VoiceActivityDetector::speaking() const
+{
+    return m_speaking;
+}
+
+bool VoiceActivityDetector::available() const
+{
+    return AudioInput::canCapture();
+}
+
+void VoiceActivityDetector::setSpeaking(bool speaking)
+{
+    if (speaking == m_speaking)
+        return;
+
+    m_speaking = speaking;
+    Q_EMIT speakingChanged();
+}
+
+int VoiceActivityDetector::benchmark(const QString &filePath, const QString &labelsPath)
+{
+    QTextStream out(stdout);
+
+    // Speech segments marked in an Audacity label file, as start and end times in seconds
+    QList<QPair<qreal, qreal>> segments;
+    if (!labelsPath.isEmpty()) {
+        QFile labels(labelsPath);
+        if (!labels.open(QFile::ReadOnly | QFile::Text)) {
+            out << "Cannot read labels from " << labelsPath << '\n';
+            return 1;
+        }
+        QTextStream in(&labels);
+        while (!in.atEnd()) {
+            const QStringList fields = in.readLine().split(QLatin1Char('\t'));
+            if (fields.size() >= 2 && !fields.at(0).startsWith(QLatin1Char('\\')))
+                segments.append({fields.at(0).toDouble(), fields.at(1).toDouble()});
+        }
+        std::sort(segments.begin(), segments.end());
+    }
+
+    // Transitions are only appended on the audio thread, and read once it's done.
+    QList<QPair<bool, qreal>> transitions;
+    VoiceActivityAnalyzer analyzer([&transitions](bool speaking, qint64 sample) {
+        transitions.append({speaking, qreal(sample) / AudioInput::SampleRate});
+    });
+    AudioInput input(&analyzer);
+    QEventLoop loop;
+    bool failed = false;
+    QObject::connect(&input, &AudioInput::error, &loop, [&](const QString &message) {
+        out << message << '\n';
+        failed = true;
+    });
+    QObject::connect(&input, &AudioInput::finished, &loop, &QEventLoop::quit);
+    input.start(filePath, false);
+    loop.exec();
+    input.stop();
+    if (failed)
+        return 1;
+
+    for (const auto &transition : std::as_const(transitions))
+        out << (transition.first ? "speech\t" : "silence\t") << transition.second << '\n';
+    const qreal seconds = qreal(analyzer.samples()) / AudioInput::SampleRate;
+    const qreal analysis = analyzer.analysisTime() / 1e6;
+    out << "Analysed " << seconds << " s of audio in " << analysis << " ms, " << (seconds > 0 ? analysis / seconds / 10 : 0) << "% of real time\n";
+
+    if (!segments.isEmpty()) {
+        // Onset latency: from the start of each segment to the first speech transition after it, within the segment
+        qreal latencies = 0, worstLatency = 0;
+        int detected = 0;
+        for (const auto &segment : std::as_const(segments)) {
+            for (const auto &transition : std::as_const(transitions)) {
+                if (transition.first && transition.second >= segment.first && transition.second <= segment.second) {
+                    const qreal latency = transition.second - segment.first;
+                    latencies += latency;
+                    worstLatency = qMax(worstLatency, latency);
+                    ++detected;
+                    break;
+                }
+            }
+        }
+        // Frames where detection agrees with the labels
+        const qint64 frames = analyzer.samples() / VoiceActivityAnalyzer::FrameSize;
+        qint64 agreed = 0;
+        qsizetype segment = 0, transition = 0;
+        bool speaking = false;
+        for (qint64 frame = 0; frame < frames; frame++) {
+            const qreal time = (frame + 1) * qreal(VoiceActivityAnalyzer::FrameSize) / AudioInput::SampleRate;
+            while (segment < segments.size() && segments.at(segment).second < time)
+                ++segment;
+            while (transition < transitions.size() && transitions.at(transition).second <= time)
+                speaking = transitions.at(transition++).first;
+            const bool labelled = segment < segments.size() && segments.at(segment).first <= time;
+            agreed += labelled == speaking;
+        }
+        out << "Detected " << detected << " of " << segments.size() << " speech onsets, mean latency " << (detected ? latencies / detected * 1000 : 0)
+            << " ms, worst " << worstLatency * 1000 << " ms\n";
+        out << "Frame accuracy: " << (frames ? 100. * agreed / frames : 0) << "%\n";
+    }
+    return 0;
+}
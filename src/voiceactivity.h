@@ -0,0 +1,137 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef VOICEACTIVITY_H
+#define VOICEACTIVITY_H
+
+#include <QObject>
+#include <QQmlEngine>
+#include <QString>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "audioinput.h"
+
+// Tells speech from silence and noise on the audio thread, 10 ms at a time. Frames count as speech when their energy
+// stands out from an adaptive noise floor and their spectrum looks like speech: not dominated by low frequency rumble,
+// which pre-emphasis removes, nor by broadband hiss, which crosses zero too often. Onsets need two speech frames in a
+// row; speech only ends after a run of other frames as long as the hangover.
+class VoiceActivityAnalyzer : public AudioProcessor
+{
+public:
+    static constexpr int FrameSize = AudioInput::SampleRate / 100;
+
+    // Called on the audio thread, with the sample where each transition was detected
+    using Transition = std::function<void(bool speaking, qint64 sample)>;
+
+    explicit VoiceActivityAnalyzer(Transition transition);
+
+    // Decibels above the noise floor that speech starts at. Speech continues down to 3 dB less.
+    void setThreshold(float threshold);
+    // Milliseconds
+    void setHangover(int hangover);
+
+    void process(const qint16 *samples, qsizetype count) override;
+
+    // Read once the audio thread is done
+    qint64 samples() const;
+    qint64 analysisTime() const;
+
+private:
+    void analyse();
+
+    Transition m_transition;
+    std::atomic<float> m_threshold;
+    std::atomic<int> m_hangoverFrames;
+
+    // One sample of history before the frame, for pre-emphasis and zero crossings
+    alignas(16) qint16 m_frame[FrameSize + 1];
+    int m_buffered;
+    qint64 m_samples;
+    float m_noiseFloor;
+    bool m_speaking;
+    int m_speechFrames;
+    int m_otherFrames;
+    // Nanoseconds spent analysing frames
+    qint64 m_analysisTime;
+};
+
+// Whether the talent is speaking, for pausing the prompter while they aren't.
+class VoiceActivityDetector : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    // WAV file to listen to instead of the microphone
+    Q_PROPERTY(QString source READ source WRITE setSource NOTIFY sourceChanged)
+    // Decibels above background noise that count as speech
+    Q_PROPERTY(qreal threshold READ threshold WRITE setThreshold NOTIFY thresholdChanged)
+    // Silence needed before speech is considered over, in milliseconds
+    Q_PROPERTY(int hangover READ hangover WRITE setHangover NOTIFY hangoverChanged)
+    Q_PROPERTY(bool speaking READ speaking NOTIFY speakingChanged)
+    // Whether this build can capture from microphones
+    Q_PROPERTY(bool available READ available CONSTANT)
+
+public:
+    explicit VoiceActivityDetector(QObject *parent = nullptr);
+    ~VoiceActivityDetector();
+
+    bool active() const;
+    void setActive(bool active);
+    QString source() const;
+    void setSource(const QString &source);
+    qreal threshold() const;
+    void setThreshold(qreal threshold);
+    int hangover() const;
+    void setHangover(int hangover);
+    bool speaking() const;
+    bool available() const;
+
+    // Runs detection over a WAV file as fast as possible and prints transitions, CPU cost and, given an Audacity label
+    // file marking speech, detection latency and frame accuracy. Returns a process exit code.
+    static int benchmark(const QString &filePath, const QString &labelsPath);
+
+Q_SIGNALS:
+    void activeChanged();
+    void sourceChanged();
+    void thresholdChanged();
+    void hangoverChanged();
+    void speakingChanged();
+    void error(const QString &message);
+
+private:
+    void setSpeaking(bool speaking);
+
+    bool m_active;
+    QString m_source;
+    qreal m_threshold;
+    int m_hangover;
+    bool m_speaking;
+
+    // Destroyed after the input that feeds it
+    std::unique_ptr<VoiceActivityAnalyzer> m_analyzer;
+    std::unique_ptr<AudioInput> m_input;
+};
+
+#endif // VOICEACTIVITY_H
@@ -0,0 +1,132 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+
+#include "wakeupmonitor.h"
+
+#include <QAbstractEventDispatcher>
+#include <QQuickWindow>
+#include <QVariantMap>
+
+static constexpr int SAMPLE_INTERVAL = 1000;
+
+WakeupMonitor::WakeupMonitor(QObject *parent)
+    : QObject(parent)
+    , m_enabled(false)
+    , m_awake(0)
+    , m_wakeups(0)
+{
+    m_sampleTimer.setInterval(SAMPLE_INTERVAL);
+    connect(&m_sampleTimer, &QTimer::timeout, this, &WakeupMonitor::sample);
+}
+
+bool WakeupMonitor::enabled() const
+{
+    return m_enabled;
+}
+
+void WakeupMonitor::setEnabled(bool enabled)
+{
+    if (enabled == m_enabled)
+        return;
+
+    m_enabled = enabled;
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(thread());
+    if (m_enabled) {
+        if (dispatcher)
+            connect(dispatcher, &QAbstractEventDispatcher::awake, this, &WakeupMonitor::awake);
+        m_sampleTimer.start();
+    }
+    else {
+        if (dispatcher)
+            disconnect(dispatcher, &QAbstractEventDispatcher::awake, this, &WakeupMonitor::awake);
+        m_sampleTimer.stop();
+        m_names.clear();
+        m_counts.clear();
+        m_awake = 0;
+        m_wakeups = 0;
+        m_subsystems.clear();
+        Q_EMIT statisticsChanged();
+    }
+    Q_EMIT enabledChanged();
+}
+
+int WakeupMonitor::wakeups() const
+{
+    return m_wakeups;
+}
+
+QVariantList WakeupMonitor::subsystems() const
+{
+    return m_subsystems;
+}
+
+void WakeupMonitor::wake(const QString &subsystem)
+{
+    if (m_enabled)
+        ++counts(subsystem).wakeups;
+}
+
+void WakeupMonitor::watch(QQuickWindow *window, const QString &subsystem)
+{
+    if (!window || m_windows.contains(window))
+        return;
+
+    m_windows.insert(window, subsystem);
+    // afterAnimating is emitted on the GUI thread once for every frame the window prepares.
+    connect(window, &QQuickWindow::afterAnimating, this, [this, window]() {
+        if (m_enabled)
+            ++counts(m_windows.value(window)).frames;
+    });
+    connect(window, &QObject::destroyed, this, [this, window]() {
+        m_windows.remove(window);
+    });
+}
+
+void WakeupMonitor::awake()
+{
+    ++m_awake;
+}
+
+void WakeupMonitor::sample()
+{
+    // The wakeup that delivered this sample is the monitor's own.
+    m_wakeups = qMax(0, m_awake - 1) * 1000 / SAMPLE_INTERVAL;
+    m_awake = 0;
+
+    m_subsystems.clear();
+    m_subsystems.reserve(m_names.size());
+    for (const QString &name : std::as_const(m_names)) {
+        Counts &count = m_counts[name];
+        m_subsystems.append(QVariantMap({{QStringLiteral("name"), name},
+                                         {QStringLiteral("wakeups"), count.wakeups * 1000 / SAMPLE_INTERVAL},
+                                         {QStringLiteral("frames"), count.frames * 1000 / SAMPLE_INTERVAL}}));
+        count = Counts();
+    }
+    Q_EMIT statisticsChanged();
+}
+
+WakeupMonitor::Counts &WakeupMonitor::counts(const QString &subsystem)
+{
+    if (!m_counts.contains(subsystem))
+        m_names.append(subsystem);
+    return m_counts[subsystem];
+}
@@ -0,0 +1,88 @@
+/****************************************************************************
+ **
+ ** QPrompt
+ ** Copyright (C) 2024 Javier O. Cordero Pérez
+ **
+ ** This file is part of QPrompt.
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, version 3 of the License.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **
+ ****************************************************************************/
+
+#ifndef WAKEUPMONITOR_H
+#define WAKEUPMONITOR_H
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QQmlEngine>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantList>
+
+class QQuickWindow;
+
+// Counts how often the GUI thread wakes up and which subsystems ask it to, so an idle prompter can be verified to stay
+// idle. Rates are per second, sampled once a second while enabled.
+class WakeupMonitor : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    // Event loop wakeups per second, not counting the monitor's own sampling
+    Q_PROPERTY(int wakeups READ wakeups NOTIFY statisticsChanged)
+    // One {name, wakeups, frames} entry per subsystem seen since the monitor was enabled
+    Q_PROPERTY(QVariantList subsystems READ subsystems NOTIFY statisticsChanged)
+
+public:
+    explicit WakeupMonitor(QObject *parent = nullptr);
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+    int wakeups() const;
+    QVariantList subsystems() const;
+
+    // Attributes one wakeup to a subsystem, such as a timer firing.
+    Q_INVOKABLE void wake(const QString &subsystem);
+    // Attributes the frames a window renders to a subsystem, until the window is destroyed.
+    Q_INVOKABLE void watch(QQuickWindow *window, const QString &subsystem);
+
+Q_SIGNALS:
+    void enabledChanged();
+    void statisticsChanged();
+
+private Q_SLOTS:
+    void awake();
+    void sample();
+
+private:
+    struct Counts {
+        int wakeups = 0;
+        int frames = 0;
+    };
+
+    Counts &counts(const QString &subsystem);
+
+    bool m_enabled;
+    QTimer m_sampleTimer;
+    QHash<QQuickWindow *, QString> m_windows;
+    // Subsystems in the order they were first seen, and their counts for the current second
+    QStringList m_names;
+    QHash<QString, Counts> m_counts;
+    int m_awake;
+    int m_wakeups;
+    QVariantList m_subsystems;
+};
+
+#endif // WAKEUPMONITOR_H